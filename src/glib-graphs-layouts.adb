@@ -21,6 +21,7 @@
 --                                                                          --
 ------------------------------------------------------------------------------
 
+with Ada.Calendar;                        use Ada.Calendar;
 with Ada.Containers.Doubly_Linked_Lists;
 with Ada.Tags;                            use Ada.Tags;
 with Ada.Unchecked_Deallocation;
@@ -46,6 +47,9 @@ package body Glib.Graphs.Layouts is
    type Integer_Array_Access is access Integer_Array;
    --  maps vertices to some data
 
+   type Place_Array is array (Integer range <>) of Vertex_Place;
+   type Place_Array_Access is access Place_Array;
+
    procedure Make_Acyclic (G : in out Graph);
    --  Make sure the graph is acyclic
 
@@ -59,6 +63,8 @@ package body Glib.Graphs.Layouts is
       Horizontal           : Boolean;
       Space_Between_Layers : Gdouble;
       Space_Between_Items  : Gdouble;
+      Ordering             : Ordering_Options;
+      Ranking              : Ranking_Method;
 
       Min_Layer, Max_Layer : Integer;
 
@@ -67,8 +73,20 @@ package body Glib.Graphs.Layouts is
 
       Layers     : Integer_Array_Access;
       --  For each vertex, its assigned layer
+
+      Previous   : Place_Array_Access;
+      --  For incremental layouts, the place of each vertex in the previous
+      --  layout, or No_Place for the vertices that must be placed again.
+      --  This is null for a full layout, and does not include the dummy
+      --  vertices.
    end record;
 
+   function Is_Fixed (Info : Layout_Info; V : Natural) return Boolean
+     is (Info.Previous /= null
+         and then V <= Info.Previous'Last
+         and then Info.Previous (V) /= No_Place);
+   --  Whether the vertex with index V keeps its previous place
+
    procedure Free (Self : in out Layout_Info);
    --  Free memory used by Self
 
@@ -90,6 +108,7 @@ package body Glib.Graphs.Layouts is
      (G            : Graph;
       Info         : in out Layout_Info);
    --  Sort the nodes within each layer so as to minimize crossing of edges.
+   --  G must be frozen.
    --  To do this, we use a Median or Barycenter Heuristic.
    --  This is also similar to what graphize uses to reorder nodes within a
    --  layer to minimize edge crossing. See for instance:
@@ -103,6 +122,11 @@ package body Glib.Graphs.Layouts is
    --
    --  Basically, for each layer, we order the nodes based on the barycenter
    --  of their neighbor nodes, and repeat for each layer.
+   --  The optional transpose step is described in the second paper.
+   --  For incremental layouts, the fixed vertices keep their relative order,
+   --  and only the layers that contain other vertices are sorted. Positions
+   --  are then scaled by the size of the layers, so that the barycenter of
+   --  the neighbors can be compared with the position of fixed vertices.
 
    type Weight_Info is record
       Weight : Gdouble;
@@ -131,6 +155,17 @@ package body Glib.Graphs.Layouts is
    --  replace it with a DFS, where leaf nodes are assigned to layer 0
    --  (so the ordering would be different, but since we are tightening
    --  edges afterward it doesn't really matter).
+   --  Vertices that keep their previous place are assigned at least to their
+   --  previous layer.
+   --  G must be frozen.
+
+   procedure Constrained_Rank (G : Graph; Info : in out Layout_Info);
+   --  Compute the layers for an incremental layout. The vertices keep their
+   --  previous layer, unless an edge from a vertex placed further forces
+   --  them to move (they are then no longer considered as fixed).
+   --  Other vertices are placed just after their predecessors or, if none of
+   --  their predecessors is fixed, just before their successors.
+   --  G must be frozen.
 
    procedure Organize_Nodes
      (G    : Graph;
@@ -141,6 +176,7 @@ package body Glib.Graphs.Layouts is
    --  layout), we do a breadth-first-search, and add each child in to
    --  its respective layer. This ensures that for the spanning tree at
    --  least there are no edge crossings.
+   --  For incremental layouts, the fixed vertices keep their previous order.
 
    procedure Rank_Items (G : in out Graph; Info : in out Layout_Info);
    --  Compute the layer for each item
@@ -197,6 +233,15 @@ package body Glib.Graphs.Layouts is
    --  tighten the link E->D in the example above).
    --  This changes layer assignment for the vertices.
 
+   procedure Simplex_Rank (G : Graph; Info : in out Layout_Info);
+   --  Compute an optimal layer assignment, starting from the one computed by
+   --  Init_Rank, with the network simplex algorithm from "A Technique for
+   --  Drawing Directed Graphs" (Gansner et al, 1993): a spanning tree of
+   --  tight edges is computed, then tree edges with a negative cut value are
+   --  repeatedly exchanged with non-tree edges until the total length of
+   --  the edges is minimal. Each independent component starts at layer 0.
+   --  G must be frozen.
+
    ----------
    -- Free --
    ----------
@@ -207,9 +252,13 @@ package body Glib.Graphs.Layouts is
       procedure Unchecked_Free is new Ada.Unchecked_Deallocation
         (Layer_Info_Array, Layer_Info_Array_Access);
 
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Place_Array, Place_Array_Access);
+
    begin
       Unchecked_Free (Self.In_Layers);
       Unchecked_Free (Self.Layers);
+      Unchecked_Free (Self.Previous);
    end Free;
 
    -----------
@@ -347,103 +396,350 @@ package body Glib.Graphs.Layouts is
      (G            : Graph;
       Info         : in out Layout_Info)
    is
-      Max_Iterations : constant := 8;
-      Max_I          : constant Integer := Max_Index (G);
-      Position       : Integer_Array (Min_Vertex_Index .. Max_I);
-
-      procedure Do_Iteration (Layer : Integer; Downward : Boolean);
-      procedure Do_Iteration (Layer : Integer; Downward : Boolean) is
-         Weights        : Weight_Array (0 .. Max_I + 1);
-         C              : Vertex_Lists.Cursor := Info.In_Layers (Layer).First;
-         Src, Dest      : Vertex_Access;
-         Current_C      : Integer := Weights'First + 1;
-         Eit            : Edge_Iterator;
-         Total, Count   : Integer;
+      Min_Parallel_Size : constant := 64;
+      --  Minimal number of vertices computed by each task. Smaller layers
+      --  are handled by the calling task only.
+
+      Options  : Ordering_Options renames Info.Ordering;
+      Start    : constant Time := Clock;
+      Max_I    : constant Integer := Max_Index (G);
+      S        : constant not null Graph_Snapshot_Access := Snapshot (G);
+      Position : Integer_Array (Min_Vertex_Index .. Max_I);
+      In_Layer : Integer_Array (Min_Vertex_Index .. Max_I);
+      --  The position of each vertex within its layer, and that layer.
+      --  Info.Layers does not include the dummy vertices.
+
+      Layer_Last : Integer_Array
+        (Info.In_Layers'First - 1 .. Info.In_Layers'Last);
+      Order      : Integer_Array (1 .. S.Num_Vertices);
+      --  The index of the vertices of layer L, in order, are stored in
+      --  Order (Layer_Last (L - 1) + 1 .. Layer_Last (L)).
+
+      Max_Layer_Size : Natural := 0;
+
+      Has_Free : array (Info.In_Layers'Range) of Boolean :=
+        (others => Info.Previous = null);
+      --  Whether the layer contains vertices that are not fixed
+
+      function Scaled (V : Natural) return Gdouble
+        is (if Info.Previous = null
+            then Gdouble (Position (V))
+            else Gdouble (Position (V))
+              / Gdouble (Layer_Last (In_Layer (V))
+                         - Layer_Last (In_Layer (V) - 1) + 1));
+      --  The position of V used to compute barycenters
+
+      function Crossings return Natural;
+      --  Number of crossings between the edges of adjacent layers, in the
+      --  current order
+
+      function Pair_Crossings (U, V : Natural) return Natural;
+      --  Number of crossings between the edges of U and those of V, when U is
+      --  just before V in their layer
+
+      procedure Transpose;
+      --  Swap adjacent vertices in each layer as long as this reduces the
+      --  number of crossings
+
+      function Out_Of_Time return Boolean
+        is (Clock - Start > Options.Time_Budget);
+
+      ---------------
+      -- Crossings --
+      ---------------
+
+      function Crossings return Natural is
+         type Bits is mod 2 ** Integer'Size;
+
+         function Low_Bit (P : Positive) return Positive
+           is (Integer (Bits (P) and (-Bits (P))));
+         --  The lowest bit set in P
+
+         Tree     : Integer_Array (1 .. Max_Layer_Size);
+         --  A Fenwick tree that counts the edges already seen that end at
+         --  each position of the next layer.
+
+         Result   : Natural := 0;
+         Inserted : Natural;
+         Adj      : Adjacency_Cursor;
+         Dest     : Natural;
+         P, Sum   : Natural;
       begin
-         while Has_Element (C) loop
-            Dest := Element (C);
-            Total := 0;
-            Count := 0;
+         for L in Info.In_Layers'First .. Info.In_Layers'Last - 1 loop
+            Tree := (others => 0);
+            Inserted := 0;
+
+            for K in Layer_Last (L - 1) + 1 .. Layer_Last (L) loop
+               --  The edges of this vertex cross all the edges already seen
+               --  that end further in the next layer.
+
+               Adj := First_Adjacent
+                 (S, Order (K), Incoming => False, Both_Ways => False);
+               while not At_End (Adj) loop
+                  Dest := Adjacent (S, Adj);
+                  if In_Layer (Dest) = L + 1 then
+                     Sum := 0;
+                     P := Position (Dest);
+                     while P > 0 loop
+                        Sum := Sum + Tree (P);
+                        P := P - Low_Bit (P);
+                     end loop;
+                     Result := Result + Inserted - Sum;
+                  end if;
+                  Next (S, Adj);
+               end loop;
 
-            if Downward then
-               Eit := First (G, Src => Dest);
-            else
-               Eit := First (G, Dest => Dest);
-            end if;
+               Adj := First_Adjacent
+                 (S, Order (K), Incoming => False, Both_Ways => False);
+               while not At_End (Adj) loop
+                  Dest := Adjacent (S, Adj);
+                  if In_Layer (Dest) = L + 1 then
+                     Inserted := Inserted + 1;
+                     P := Position (Dest);
+                     while P <= Tree'Last loop
+                        Tree (P) := Tree (P) + 1;
+                        P := P + Low_Bit (P);
+                     end loop;
+                  end if;
+                  Next (S, Adj);
+               end loop;
+            end loop;
+         end loop;
 
-            while not At_End (Eit) loop
-               if Downward then
-                  Src := Get_Dest (Get (Eit));
-               else
-                  Src := Get_Src (Get (Eit));
-               end if;
+         return Result;
+      end Crossings;
 
-               --  ignore self-links.
-               --  Only take into account tight edges (where nodes are in
-               --  adjacent layers), which is the default if we added dummy
-               --  nodes.
+      --------------------
+      -- Pair_Crossings --
+      --------------------
 
-               if Src /= Dest
-                 and then (Add_Dummy_Nodes
-                           or else Slack (Info, Get (Eit)) = 0)
-               then
-                  Total := Total + Position (Get_Index (Src));
-                  Count := Count + 1;
+      function Pair_Crossings (U, V : Natural) return Natural is
+         Result     : Natural := 0;
+         Adj_U      : Adjacency_Cursor;
+         Adj_V      : Adjacency_Cursor;
+         Next_Layer : Integer;
+      begin
+         for Incoming in Boolean loop
+            Next_Layer := In_Layer (U) + (if Incoming then -1 else 1);
+
+            Adj_U := First_Adjacent (S, U, Incoming, Both_Ways => False);
+            while not At_End (Adj_U) loop
+               if In_Layer (Adjacent (S, Adj_U)) = Next_Layer then
+                  Adj_V := First_Adjacent
+                    (S, V, Incoming, Both_Ways => False);
+                  while not At_End (Adj_V) loop
+                     if In_Layer (Adjacent (S, Adj_V)) = Next_Layer
+                       and then Position (Adjacent (S, Adj_U)) >
+                         Position (Adjacent (S, Adj_V))
+                     then
+                        Result := Result + 1;
+                     end if;
+                     Next (S, Adj_V);
+                  end loop;
                end if;
-
-               Next (Eit);
+               Next (S, Adj_U);
             end loop;
-
-            if Count = 0 then
-               --  leave the item in place
-               Weights (Current_C) :=
-                 (Gdouble (Position (Get_Index (Dest))), Dest);
-            else
-               Weights (Current_C) :=
-                 (Gdouble (Total) / Gdouble (Count), Dest);
-            end if;
-
-            Current_C := Current_C + 1;
-            Next (C);
          end loop;
 
-         --  Now sort based on weights
+         return Result;
+      end Pair_Crossings;
+
+      ---------------
+      -- Transpose --
+      ---------------
 
-         Sort (Weights (0 .. Current_C - 1));
-         Info.In_Layers (Layer).Clear;
-         for W in 1 .. Current_C - 1 loop
-            Position (Get_Index (Weights (W).Vertex)) := W;
-            Info.In_Layers (Layer).Append (Weights (W).Vertex);
+      procedure Transpose is
+         Improved : Boolean := True;
+         U, V     : Natural;
+      begin
+         while Improved and then not Out_Of_Time loop
+            Improved := False;
+
+            for L in Info.In_Layers'Range loop
+               for K in Layer_Last (L - 1) + 1 .. Layer_Last (L) - 1 loop
+                  U := Order (K);
+                  V := Order (K + 1);
+
+                  if Pair_Crossings (U, V) > Pair_Crossings (V, U) then
+                     Order (K)     := V;
+                     Order (K + 1) := U;
+                     Position (U)  := Position (U) + 1;
+                     Position (V)  := Position (V) - 1;
+                     Improved      := True;
+                  end if;
+               end loop;
+            end loop;
          end loop;
-      end Do_Iteration;
+      end Transpose;
 
-      C              : Vertex_Lists.Cursor;
-      Current_C      : Integer;
+      C         : Vertex_Lists.Cursor;
+      Current_C : Integer;
 
    begin
       --  Store the position of elements within each layer
 
+      Current_C := 0;
+      Layer_Last (Layer_Last'First) := 0;
+
       for L in Info.In_Layers'Range loop
-         C         := Info.In_Layers (L).First;
-         Current_C := 1;
+         C := Info.In_Layers (L).First;
          while Has_Element (C) loop
-            Position (Get_Index (Element (C))) := Current_C;
             Current_C := Current_C + 1;
+            Order (Current_C) := Get_Index (Element (C));
+            Position (Order (Current_C)) := Current_C - Layer_Last (L - 1);
+            In_Layer (Order (Current_C)) := L;
+            if not Is_Fixed (Info, Order (Current_C)) then
+               Has_Free (L) := True;
+            end if;
             Next (C);
          end loop;
+
+         Layer_Last (L) := Current_C;
+         Max_Layer_Size :=
+           Integer'Max (Max_Layer_Size, Current_C - Layer_Last (L - 1));
       end loop;
 
-      for Iteration in 0 .. Max_Iterations - 1 loop
-         if Iteration mod 2 = 0 then
-            for L in reverse Info.In_Layers'First .. Info.In_Layers'Last - 1
-            loop
-               Do_Iteration (L, Downward => True);
+      declare
+         Weights        : Weight_Array (0 .. Max_Layer_Size);
+         Layer          : Integer;
+         Downward       : Boolean;
+         Best_Order     : Integer_Array := Order;
+         Best_Crossings : Natural := Natural'Last;
+         Current        : Natural;
+
+         procedure Compute_Weights (First, Last : Natural);
+         --  Compute the barycenter of the neighbors of the vertices in
+         --  Order (First .. Last), which belong to Layer, and store them in
+         --  Weights. This only reads the current positions, and can be
+         --  called from several tasks for different ranges.
+
+         procedure Do_Iteration;
+         --  Sort the vertices of Layer based on the position of their
+         --  neighbors in the next (if Downward) or previous layer.
+
+         ---------------------
+         -- Compute_Weights --
+         ---------------------
+
+         procedure Compute_Weights (First, Last : Natural) is
+            Offset         : constant Natural := Layer_Last (Layer - 1);
+            Dest_Index     : Natural;
+            Src            : Natural;
+            Adj            : Adjacency_Cursor;
+            Total          : Gdouble;
+            Count          : Integer;
+         begin
+            for K in First .. Last loop
+               Dest_Index := Order (K);
+               Total := 0.0;
+               Count := 0;
+
+               Adj := First_Adjacent
+                 (S, Dest_Index,
+                  Incoming  => not Downward,
+                  Both_Ways => False);
+
+               while not At_End (Adj) loop
+                  Src := Adjacent (S, Adj);
+
+                  --  ignore self-links.
+                  --  Only take into account tight edges (where nodes are in
+                  --  adjacent layers), which is the default if we added
+                  --  dummy nodes.
+
+                  if Src /= Dest_Index
+                    and then (Add_Dummy_Nodes
+                              or else Slack (Info, Get (S, Adj)) = 0)
+                  then
+                     Total := Total + Scaled (Src);
+                     Count := Count + 1;
+                  end if;
+
+                  Next (S, Adj);
+               end loop;
+
+               if Count = 0 or else Is_Fixed (Info, Dest_Index) then
+                  --  leave the item in place
+                  Weights (K - Offset) :=
+                    (Scaled (Dest_Index), S.Vertices (Dest_Index));
+               else
+                  Weights (K - Offset) :=
+                    (Total / Gdouble (Count), S.Vertices (Dest_Index));
+               end if;
             end loop;
-         else
-            for L in Info.In_Layers'First + 1 .. Info.In_Layers'Last loop
-               Do_Iteration (L, Downward => False);
+         end Compute_Weights;
+
+         ------------------
+         -- Do_Iteration --
+         ------------------
+
+         procedure Do_Iteration is
+            First : constant Positive := Layer_Last (Layer - 1) + 1;
+            Last  : constant Natural := Layer_Last (Layer);
+            Size  : constant Natural := Last - First + 1;
+            Tasks : constant Positive := Integer'Max
+              (1, Integer'Min (Options.Tasks, Size / Min_Parallel_Size));
+         begin
+            if Size = 0 or else not Has_Free (Layer) then
+               return;
+            end if;
+
+            if Tasks = 1 or else Options.Runner = null then
+               Compute_Weights (First, Last);
+            else
+               Options.Runner (First, Last, Tasks, Compute_Weights'Access);
+            end if;
+
+            --  Now sort based on weights
+
+            Sort (Weights (0 .. Size));
+            for W in 1 .. Size loop
+               Order (Layer_Last (Layer - 1) + W) :=
+                 Get_Index (Weights (W).Vertex);
+               Position (Get_Index (Weights (W).Vertex)) := W;
             end loop;
+         end Do_Iteration;
+
+      begin
+         for Iteration in 0 .. Options.Sweeps - 1 loop
+            Downward := Iteration mod 2 = 0;
+
+            if Downward then
+               for L in reverse Info.In_Layers'First
+                 .. Info.In_Layers'Last - 1
+               loop
+                  Layer := L;
+                  Do_Iteration;
+               end loop;
+            else
+               for L in Info.In_Layers'First + 1 .. Info.In_Layers'Last loop
+                  Layer := L;
+                  Do_Iteration;
+               end loop;
+            end if;
+
+            if Options.Transpose then
+               Transpose;
+               Current := Crossings;
+               if Current < Best_Crossings then
+                  Best_Crossings := Current;
+                  Best_Order := Order;
+               end if;
+            end if;
+
+            exit when Out_Of_Time;
+         end loop;
+
+         if Options.Transpose then
+            Order := Best_Order;
          end if;
+      end;  --  wait for the workers to terminate
+
+      for L in Info.In_Layers'Range loop
+         Info.In_Layers (L).Clear;
+         for K in Layer_Last (L - 1) + 1 .. Layer_Last (L) loop
+            Info.In_Layers (L).Append (S.Vertices (Order (K)));
+         end loop;
       end loop;
    end Sort_Nodes_Within_Layers;
 
@@ -666,84 +962,165 @@ package body Glib.Graphs.Layouts is
      (G         : Graph;
       Info      : in out Layout_Info)
    is
-      Max_I     : constant Integer := Max_Index (G);
-      Vit   : Vertex_Iterator := First (G);
-      Queue : array (0 .. Max_I) of Vertex_Access;
+      S       : constant not null Graph_Snapshot_Access := Snapshot (G);
+      Max_I   : constant Integer := Max_Index (G);
+      Queue   : Integer_Array (0 .. Max_I);
       Q_Index : Integer := Queue'First;
       Q_Last  : Integer := Queue'First;
       --  The queue of nodes to visit
 
-      S, D    : Vertex_Access;
-      In_Degree : array (0 .. Max_I) of Integer := (others => 0);
+      V, D    : Natural;
+      In_Degree : Integer_Array (0 .. Max_I) := (others => 0);
       --  Number of remaining in-edges that have not been analyzed for
       --  each node.
 
       Layer : Integer;
-      Eit   : Edge_Iterator;
-      Edge  : Edge_Access;
+      C     : Adjacency_Cursor;
       Deg   : Natural;
    begin
       Info.Min_Layer := Default_Layer;
       Info.Max_Layer := Default_Layer;
 
-      while not At_End (Vit) loop
-         S := Get (Vit);
+      for K in S.Order'Range loop
+         V := S.Order (K);
 
          Deg := 0;
-         Eit := First (G, Dest => S);
-         while not At_End (Eit) loop
+         C := First_Adjacent (S, V, Incoming => True, Both_Ways => False);
+         while not At_End (C) loop
             --  Ignore self links
-            if Get_Src (Get (Eit)) /= S then
+            if Adjacent (S, C) /= V then
                Deg := Deg + 1;
             end if;
-            Next (Eit);
+            Next (S, C);
          end loop;
 
-         In_Degree (Get_Index (S)) := Deg;
-         if In_Degree (Get_Index (S)) = 0 then
-            Queue (Q_Last) := S;
+         In_Degree (V) := Deg;
+         if In_Degree (V) = 0 then
+            Queue (Q_Last) := V;
             Q_Last := Q_Last + 1;
          end if;
-         Next (Vit);
       end loop;
 
       while Q_Index < Q_Last loop
-         S := Queue (Q_Index);
+         V := Queue (Q_Index);
          Q_Index := Q_Index + 1;
 
          --  Compute layer based on ancestors' own layers
 
-         Layer := Default_Layer;
-         Eit := First (G, Dest => S);
-         while not At_End (Eit) loop
-            Edge := Get (Eit);
+         if Is_Fixed (Info, V) then
+            Layer := Info.Previous (V).Layer;
+         else
+            Layer := Default_Layer;
+         end if;
+
+         C := First_Adjacent (S, V, Incoming => True, Both_Ways => False);
+         while not At_End (C) loop
             Layer := Integer'Max
-              (Layer,
-               Info.Layers (Get_Index (Get_Src (Edge)))
-               + Preferred_Length);
-            Next (Eit);
+              (Layer, Info.Layers (Adjacent (S, C)) + Preferred_Length);
+            Next (S, C);
          end loop;
 
-         Info.Layers (Get_Index (S)) := Layer;
+         Info.Layers (V) := Layer;
+         Info.Min_Layer := Integer'Min (Info.Min_Layer, Layer);
          Info.Max_Layer := Integer'Max (Info.Max_Layer, Layer);
 
          --  Mark all outgoing edges as scanned, which might lead to new
          --  nodes to analyze.
 
-         Eit := First (G, Src => S);
-         while not At_End (Eit) loop
-            Edge := Get (Eit);
-            D := Get_Dest (Edge);
-            In_Degree (Get_Index (D)) := In_Degree (Get_Index (D)) - 1;
-            if In_Degree (Get_Index (D)) = 0 then
+         C := First_Adjacent (S, V, Incoming => False, Both_Ways => False);
+         while not At_End (C) loop
+            D := Adjacent (S, C);
+            In_Degree (D) := In_Degree (D) - 1;
+            if In_Degree (D) = 0 then
                Queue (Q_Last) := D;
                Q_Last := Q_Last + 1;
             end if;
-            Next (Eit);
+            Next (S, C);
          end loop;
       end loop;
    end Init_Rank;
 
+   ----------------------
+   -- Constrained_Rank --
+   ----------------------
+
+   procedure Constrained_Rank (G : Graph; Info : in out Layout_Info) is
+      S          : constant not null Graph_Snapshot_Access := Snapshot (G);
+      Layer_Last : Integer_Array (Info.Min_Layer - 1 .. Info.Max_Layer);
+      Order      : Integer_Array (1 .. S.Num_Vertices);
+      --  The vertices sorted by layer, so that they can be traversed in
+      --  reverse topological order
+
+      V, D       : Natural;
+      Layer      : Integer;
+      Only_Free  : Boolean;
+      C          : Adjacency_Cursor;
+   begin
+      --  Init_Rank already keeps the fixed vertices in their layer (or
+      --  further when needed), and puts the others after their predecessors.
+
+      Init_Rank (G, Info);
+
+      Layer_Last := (others => 0);
+      for K in S.Order'Range loop
+         Layer := Info.Layers (S.Order (K));
+         Layer_Last (Layer) := Layer_Last (Layer) + 1;
+      end loop;
+
+      for L in Info.Min_Layer .. Info.Max_Layer loop
+         Layer_Last (L) := Layer_Last (L - 1) + Layer_Last (L);
+      end loop;
+
+      for K in reverse S.Order'Range loop
+         V := S.Order (K);
+         Layer := Info.Layers (V);
+         Order (Layer_Last (Layer)) := V;
+         Layer_Last (Layer) := Layer_Last (Layer) - 1;
+      end loop;
+
+      --  Vertices with no fixed predecessors are moved as close as possible
+      --  to their successors, which have already been moved themselves.
+
+      for K in reverse Order'Range loop
+         V := Order (K);
+
+         if not Is_Fixed (Info, V) then
+            Only_Free := True;
+            C := First_Adjacent (S, V, Incoming => True, Both_Ways => False);
+            while not At_End (C) loop
+               if Is_Fixed (Info, Adjacent (S, C)) then
+                  Only_Free := False;
+                  exit;
+               end if;
+               Next (S, C);
+            end loop;
+
+            if Only_Free then
+               Layer := Integer'Last;
+               C := First_Adjacent
+                 (S, V, Incoming => False, Both_Ways => False);
+               while not At_End (C) loop
+                  D := Adjacent (S, C);
+                  if D /= V then
+                     Layer := Integer'Min
+                       (Layer, Info.Layers (D) - Preferred_Length);
+                  end if;
+                  Next (S, C);
+               end loop;
+
+               if Layer /= Integer'Last then
+                  Info.Layers (V) := Integer'Max (Info.Layers (V), Layer);
+               end if;
+            end if;
+
+         elsif Info.Layers (V) /= Info.Previous (V).Layer then
+            --  Pushed to another layer, its previous order is meaningless
+
+            Info.Previous (V) := No_Place;
+         end if;
+      end loop;
+   end Constrained_Rank;
+
    --------------------
    -- Organize_Nodes --
    --------------------
@@ -752,6 +1129,17 @@ package body Glib.Graphs.Layouts is
      (G    : Graph;
       Info : in out Layout_Info)
    is
+      function Previous_Order (V : Vertex_Access) return Natural
+        is (if Is_Fixed (Info, Get_Index (V))
+            then Info.Previous (Get_Index (V)).Order
+            else Natural'Last);
+      function Before (V1, V2 : Vertex_Access) return Boolean
+        is (Previous_Order (V1) < Previous_Order (V2));
+      package Incremental_Sorting is new Vertex_Lists.Generic_Sorting
+        ("<" => Before);
+      --  For incremental layouts, the fixed vertices are initially in their
+      --  previous order, followed by the other vertices.
+
       Nodes : constant Depth_Vertices_Array := Depth_First_Search (G);
       V     : Vertex_Access;
    begin
@@ -763,6 +1151,12 @@ package body Glib.Graphs.Layouts is
          Info.In_Layers (Layer (Info, V)).Append (V);
       end loop;
 
+      if Info.Previous /= null then
+         for L in Info.In_Layers'Range loop
+            Incremental_Sorting.Sort (Info.In_Layers (L));
+         end loop;
+      end if;
+
       Sort_Nodes_Within_Layers (G, Info);
       Adjust_Positions (G,  Info);
    end Organize_Nodes;
@@ -957,6 +1351,685 @@ package body Glib.Graphs.Layouts is
       end loop;
    end Feasible_Tree;
 
+   ------------------
+   -- Simplex_Rank --
+   ------------------
+
+   procedure Simplex_Rank (G : Graph; Info : in out Layout_Info) is
+      Search_Size : constant := 30;
+      --  Number of tree edges with a negative cut value that are examined
+      --  before choosing the one that leaves the tree (as in graphviz)
+
+      No_Vertex : constant := Min_Vertex_Index - 1;
+
+      S : constant not null Graph_Snapshot_Access := Snapshot (G);
+
+      type Simplex_Data
+        (Last_Vertex  : Integer;
+         Num_Vertices : Natural;
+         Num_Edges    : Natural;
+         Num_Incident : Natural;
+         Heap_Size    : Natural)
+      is record
+         Tail        : Integer_Array (1 .. Num_Edges);
+         --  The source of each edge. Edges are identified by their position
+         --  in S.Out_Edges, which also gives their destination.
+
+         Inc_Last    : Integer_Array (Min_Vertex_Index - 1 .. Last_Vertex);
+         Inc         : Integer_Array (1 .. Num_Incident);
+         --  The edges incident to vertex V, in either direction, are
+         --  Inc (Inc_Last (V - 1) + 1 .. Inc_Last (V)). Self-links are
+         --  ignored.
+
+         Tree_Pos    : Integer_Array (1 .. Num_Edges);
+         Tree_Edges  : Integer_Array (1 .. Num_Vertices);
+         --  The edges of the spanning tree, and the position of each edge in
+         --  Tree_Edges (or 0 if it is not in the tree)
+
+         Cut         : Integer_Array (1 .. Num_Edges);
+         --  The cut value of the tree edges
+
+         Par         : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         Root        : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         Low, Lim    : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         Post        : Integer_Array (1 .. Num_Vertices);
+         --  The tree edge to the parent of each vertex (or 0 for the root of
+         --  the tree), and the root of its tree.
+         --  Lim is the postorder number of the vertex, and Low the lowest
+         --  postorder number in its subtree. Post is the vertex for each
+         --  postorder number, so that the vertices of the subtree of V are
+         --  Post (Low (V) .. Lim (V)).
+
+         Comp        : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         Next_Member : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         Last_Member : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         Size        : Integer_Array (Min_Vertex_Index .. Last_Vertex);
+         --  While building the initial tree: the tight component of each
+         --  vertex, identified by its first vertex, which also stores the
+         --  list of its members and their count. Lists end with No_Vertex.
+
+         Heap_Comp   : Integer_Array (1 .. Heap_Size);
+         Heap_Key    : Integer_Array (1 .. Heap_Size);
+         --  A priority queue of components, smallest first
+
+         Stack_V     : Integer_Array (1 .. Num_Vertices);
+         Stack_Pos   : Integer_Array (1 .. Num_Vertices);
+      end record;
+      type Simplex_Data_Access is access Simplex_Data;
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Simplex_Data, Simplex_Data_Access);
+
+      D : Simplex_Data_Access := new Simplex_Data
+        (Last_Vertex  => Max_Index (G),
+         Num_Vertices => S.Num_Vertices,
+         Num_Edges    => S.Out_Edges.Num_Edges,
+         Num_Incident => 2 * S.Out_Edges.Num_Edges,
+         Heap_Size    => 2 * S.Num_Vertices);
+
+      Rank        : Integer_Array renames Info.Layers.all;
+      Num_Tree    : Natural := 0;
+      Heap_Last   : Natural := 0;
+      Search_From : Positive := 1;
+
+      function Head (E : Positive) return Natural
+        is (S.Out_Edges.Target (E));
+      function Other (E : Positive; V : Natural) return Natural
+        is (if D.Tail (E) = V then Head (E) else D.Tail (E));
+      function Edge_Slack (E : Positive) return Integer
+        is (Rank (Head (E)) - Rank (D.Tail (E)) - Preferred_Length);
+      function In_Subtree (V, W : Natural) return Boolean
+        is (D.Low (V) <= D.Lim (W) and then D.Lim (W) <= D.Lim (V));
+      --  Whether W is in the subtree rooted at V
+
+      procedure Add_Tree_Edge (E : Positive);
+      --  Add E to the spanning tree
+
+      procedure Push (Comp : Integer);
+      procedure Pop (Comp : out Integer; Key : out Integer);
+      --  Manipulate the priority queue of components. Pop sets Comp to
+      --  No_Vertex when the queue is empty. Components are pushed again when
+      --  they grow, so Pop might return obsolete entries, whose Key is not
+      --  their size.
+
+      procedure Tight_Component (Start : Natural);
+      --  Create a new component with all vertices reachable from Start
+      --  through tight edges.
+
+      procedure Feasible_Tree;
+      --  Compute a spanning tree of tight edges, changing the ranks as
+      --  needed. Components are merged smallest first, so that the ranks
+      --  of each vertex are only changed a logarithmic number of times.
+
+      function Dfs_Range
+        (Root : Natural; Par : Natural; Low : Positive) return Positive;
+      --  Compute Par, Low and Lim for the subtree rooted at Root, whose edge
+      --  to its parent is Par. Return the next unused postorder number.
+
+      function X_Cutval (F : Positive) return Integer;
+      --  Compute the cut value of a tree edge, from the cut values of the
+      --  tree edges below it
+
+      function Leave_Edge return Natural;
+      --  A tree edge with a negative cut value, or 0 if the tree is optimal
+
+      function Enter_Edge (F : Positive) return Natural;
+      --  The non-tree edge with the smallest slack that reconnects the two
+      --  parts of the tree once F is removed, in the opposite direction.
+
+      procedure Update (E, F : Positive);
+      --  Replace F with E in the tree, update the ranks so that E is tight,
+      --  and update the cut values and postorder numbers.
+
+      -------------------
+      -- Add_Tree_Edge --
+      -------------------
+
+      procedure Add_Tree_Edge (E : Positive) is
+      begin
+         Num_Tree := Num_Tree + 1;
+         D.Tree_Edges (Num_Tree) := E;
+         D.Tree_Pos (E) := Num_Tree;
+      end Add_Tree_Edge;
+
+      ----------
+      -- Push --
+      ----------
+
+      procedure Push (Comp : Integer) is
+         Pos    : Positive;
+         Parent : Positive;
+      begin
+         Heap_Last := Heap_Last + 1;
+         Pos := Heap_Last;
+         while Pos > 1 loop
+            Parent := Pos / 2;
+            exit when D.Heap_Key (Parent) <= D.Size (Comp);
+            D.Heap_Comp (Pos) := D.Heap_Comp (Parent);
+            D.Heap_Key (Pos) := D.Heap_Key (Parent);
+            Pos := Parent;
+         end loop;
+         D.Heap_Comp (Pos) := Comp;
+         D.Heap_Key (Pos) := D.Size (Comp);
+      end Push;
+
+      ---------
+      -- Pop --
+      ---------
+
+      procedure Pop (Comp : out Integer; Key : out Integer) is
+         Last_Comp : Integer;
+         Last_Key  : Integer;
+         Pos       : Positive := 1;
+         Child     : Positive;
+      begin
+         if Heap_Last = 0 then
+            Comp := No_Vertex;
+            Key := 0;
+            return;
+         end if;
+
+         Comp := D.Heap_Comp (1);
+         Key := D.Heap_Key (1);
+         Last_Comp := D.Heap_Comp (Heap_Last);
+         Last_Key := D.Heap_Key (Heap_Last);
+         Heap_Last := Heap_Last - 1;
+
+         loop
+            Child := 2 * Pos;
+            exit when Child > Heap_Last;
+            if Child < Heap_Last
+              and then D.Heap_Key (Child + 1) < D.Heap_Key (Child)
+            then
+               Child := Child + 1;
+            end if;
+            exit when Last_Key <= D.Heap_Key (Child);
+            D.Heap_Comp (Pos) := D.Heap_Comp (Child);
+            D.Heap_Key (Pos) := D.Heap_Key (Child);
+            Pos := Child;
+         end loop;
+
+         D.Heap_Comp (Pos) := Last_Comp;
+         D.Heap_Key (Pos) := Last_Key;
+      end Pop;
+
+      ---------------------
+      -- Tight_Component --
+      ---------------------
+
+      procedure Tight_Component (Start : Natural) is
+         Q_First : Positive := 1;
+         Q_Last  : Positive := 1;
+         V, W    : Natural;
+         E       : Positive;
+      begin
+         D.Comp (Start) := Start;
+         D.Size (Start) := 1;
+         D.Next_Member (Start) := No_Vertex;
+         D.Last_Member (Start) := Start;
+         D.Stack_V (1) := Start;
+
+         while Q_First <= Q_Last loop
+            V := D.Stack_V (Q_First);
+            Q_First := Q_First + 1;
+
+            for P in D.Inc_Last (V - 1) + 1 .. D.Inc_Last (V) loop
+               E := D.Inc (P);
+               W := Other (E, V);
+               if D.Comp (W) = No_Vertex and then Edge_Slack (E) = 0 then
+                  Add_Tree_Edge (E);
+                  D.Comp (W) := Start;
+                  D.Size (Start) := D.Size (Start) + 1;
+                  D.Next_Member (W) := No_Vertex;
+                  D.Next_Member (D.Last_Member (Start)) := W;
+                  D.Last_Member (Start) := W;
+                  Q_Last := Q_Last + 1;
+                  D.Stack_V (Q_Last) := W;
+               end if;
+            end loop;
+         end loop;
+
+         Push (Start);
+      end Tight_Component;
+
+      -------------------
+      -- Feasible_Tree --
+      -------------------
+
+      procedure Feasible_Tree is
+         C, U, M  : Integer;
+         Key      : Integer;
+         Best     : Natural;
+         Best_Sl  : Integer;
+         Sl       : Integer;
+         Delta_R  : Integer;
+         E        : Positive;
+      begin
+         D.Comp := (others => No_Vertex);
+
+         for K in S.Order'Range loop
+            if D.Comp (S.Order (K)) = No_Vertex then
+               Tight_Component (S.Order (K));
+            end if;
+         end loop;
+
+         loop
+            Pop (C, Key);
+            exit when C = No_Vertex;
+
+            --  Skip obsolete entries in the queue
+
+            if D.Comp (C) = C and then Key = D.Size (C) then
+               Best := 0;
+               Best_Sl := Integer'Last;
+               M := C;
+
+               Find_Edge :
+               while M /= No_Vertex loop
+                  for P in D.Inc_Last (M - 1) + 1 .. D.Inc_Last (M) loop
+                     E := D.Inc (P);
+                     if D.Comp (Other (E, M)) /= C then
+                        Sl := Edge_Slack (E);
+                        if Sl < Best_Sl then
+                           Best := E;
+                           Best_Sl := Sl;
+                           exit Find_Edge when Sl = 0;
+                        end if;
+                     end if;
+                  end loop;
+                  M := D.Next_Member (M);
+               end loop Find_Edge;
+
+               --  If there is no such edge, the component is complete
+
+               if Best /= 0 then
+                  --  Move the whole component so that Best becomes tight
+
+                  if D.Comp (D.Tail (Best)) = C then
+                     Delta_R := Best_Sl;
+                     U := D.Comp (Head (Best));
+                  else
+                     Delta_R := -Best_Sl;
+                     U := D.Comp (D.Tail (Best));
+                  end if;
+
+                  M := C;
+                  while M /= No_Vertex loop
+                     Rank (M) := Rank (M) + Delta_R;
+                     M := D.Next_Member (M);
+                  end loop;
+
+                  Add_Tree_Edge (Best);
+
+                  --  Merge into the other component, which is at least as
+                  --  large.
+
+                  M := C;
+                  while M /= No_Vertex loop
+                     D.Comp (M) := U;
+                     M := D.Next_Member (M);
+                  end loop;
+
+                  D.Next_Member (D.Last_Member (U)) := C;
+                  D.Last_Member (U) := D.Last_Member (C);
+                  D.Size (U) := D.Size (U) + D.Size (C);
+                  Push (U);
+               end if;
+            end if;
+         end loop;
+      end Feasible_Tree;
+
+      ---------------
+      -- Dfs_Range --
+      ---------------
+
+      function Dfs_Range
+        (Root : Natural; Par : Natural; Low : Positive) return Positive
+      is
+         Counter : Positive := Low;
+         Top     : Natural := 1;
+         V, W    : Natural;
+         P       : Positive;
+         E       : Positive;
+      begin
+         D.Par (Root) := Par;
+         D.Low (Root) := Counter;
+         D.Stack_V (1) := Root;
+         D.Stack_Pos (1) := D.Inc_Last (Root - 1) + 1;
+
+         while Top > 0 loop
+            V := D.Stack_V (Top);
+            P := D.Stack_Pos (Top);
+
+            if P > D.Inc_Last (V) then
+               D.Lim (V) := Counter;
+               D.Post (Counter) := V;
+               Counter := Counter + 1;
+               Top := Top - 1;
+
+            else
+               D.Stack_Pos (Top) := P + 1;
+               E := D.Inc (P);
+               if D.Tree_Pos (E) /= 0 and then E /= D.Par (V) then
+                  W := Other (E, V);
+                  D.Par (W) := E;
+                  D.Low (W) := Counter;
+                  Top := Top + 1;
+                  D.Stack_V (Top) := W;
+                  D.Stack_Pos (Top) := D.Inc_Last (W - 1) + 1;
+               end if;
+            end if;
+         end loop;
+
+         return Counter;
+      end Dfs_Range;
+
+      --------------
+      -- X_Cutval --
+      --------------
+
+      function X_Cutval (F : Positive) return Integer is
+         V       : constant Natural :=
+           (if D.Lim (D.Tail (F)) < D.Lim (Head (F))
+            then D.Tail (F) else Head (F));
+         --  The end of F in the subtree
+
+         Dir     : constant Boolean := V = D.Tail (F);
+         Sum     : Integer := 0;
+         E       : Positive;
+         Rv      : Integer;
+         Down    : Boolean;
+         Outside : Boolean;
+      begin
+         for P in D.Inc_Last (V - 1) + 1 .. D.Inc_Last (V) loop
+            E := D.Inc (P);
+            Outside := not In_Subtree (V, Other (E, V));
+
+            if Outside then
+               Rv := 1;
+            elsif D.Tree_Pos (E) /= 0 then
+               Rv := D.Cut (E) - 1;
+            else
+               Rv := -1;
+            end if;
+
+            Down := (if Dir then Head (E) = V else D.Tail (E) = V);
+            if Down = Outside then
+               Rv := -Rv;
+            end if;
+
+            Sum := Sum + Rv;
+         end loop;
+
+         return Sum;
+      end X_Cutval;
+
+      ----------------
+      -- Leave_Edge --
+      ----------------
+
+      function Leave_Edge return Natural is
+         F     : Natural := 0;
+         Count : Natural := 0;
+         Start : constant Positive := Search_From;
+         Last  : Natural := Num_Tree;
+         E     : Positive;
+      begin
+         --  Search from where the previous call stopped, then wrap around
+
+         for Pass in 1 .. 2 loop
+            while Search_From <= Last loop
+               E := D.Tree_Edges (Search_From);
+               if D.Cut (E) < 0 then
+                  if F = 0 or else D.Cut (E) < D.Cut (F) then
+                     F := E;
+                  end if;
+                  Count := Count + 1;
+                  if Count >= Search_Size then
+                     return F;
+                  end if;
+               end if;
+               Search_From := Search_From + 1;
+            end loop;
+
+            exit when Pass = 2 or else Start = 1;
+            Search_From := 1;
+            Last := Start - 1;
+         end loop;
+
+         return F;
+      end Leave_Edge;
+
+      ----------------
+      -- Enter_Edge --
+      ----------------
+
+      function Enter_Edge (F : Positive) return Natural is
+         Outgoing : constant Boolean := D.Lim (D.Tail (F)) >= D.Lim (Head (F));
+         V        : constant Natural :=
+           (if Outgoing then Head (F) else D.Tail (F));
+         --  The subtree below F, and whether we look for edges leaving it
+         --  (F then enters it) or entering it.
+
+         Result   : Natural := 0;
+         Best_Sl  : Integer := Integer'Last;
+         Sl       : Integer;
+         W        : Natural;
+         E        : Positive;
+      begin
+         For_Each_Vertex :
+         for K in D.Low (V) .. D.Lim (V) loop
+            W := D.Post (K);
+            for P in D.Inc_Last (W - 1) + 1 .. D.Inc_Last (W) loop
+               E := D.Inc (P);
+               if D.Tree_Pos (E) = 0
+                 and then (if Outgoing then D.Tail (E) else Head (E)) = W
+                 and then not In_Subtree (V, Other (E, W))
+               then
+                  Sl := Edge_Slack (E);
+                  if Sl < Best_Sl then
+                     Result := E;
+                     Best_Sl := Sl;
+                     exit For_Each_Vertex when Sl = 0;
+                  end if;
+               end if;
+            end loop;
+         end loop For_Each_Vertex;
+
+         return Result;
+      end Enter_Edge;
+
+      ------------
+      -- Update --
+      ------------
+
+      procedure Update (E, F : Positive) is
+         Sl       : constant Integer := Edge_Slack (E);
+         Sub      : constant Natural :=
+           (if D.Lim (D.Tail (F)) < D.Lim (Head (F))
+            then D.Tail (F) else Head (F));
+         R        : constant Natural := D.Root (Sub);
+         Cutvalue : constant Integer := D.Cut (F);
+         Delta_R  : Integer;
+         Lca      : Natural;
+         Lca2     : Natural;
+
+         function Tree_Update
+           (From, To : Natural; Dir : Boolean) return Natural;
+         --  Update the cut values of the tree edges on the path from From
+         --  to the common ancestor of From and To, which is returned
+
+         -----------------
+         -- Tree_Update --
+         -----------------
+
+         function Tree_Update
+           (From, To : Natural; Dir : Boolean) return Natural
+         is
+            V  : Natural := From;
+            TE : Positive;
+         begin
+            while not In_Subtree (V, To) loop
+               TE := D.Par (V);
+               if (V = D.Tail (TE)) = Dir then
+                  D.Cut (TE) := D.Cut (TE) + Cutvalue;
+               else
+                  D.Cut (TE) := D.Cut (TE) - Cutvalue;
+               end if;
+
+               V := (if D.Lim (D.Tail (TE)) > D.Lim (Head (TE))
+                     then D.Tail (TE) else Head (TE));
+            end loop;
+            return V;
+         end Tree_Update;
+
+         Dummy : Positive;
+         pragma Unreferenced (Dummy);
+      begin
+         if Sl > 0 then
+            --  Move the subtree below F so that E becomes tight, or the rest
+            --  of the tree in the opposite direction if that is smaller.
+
+            Delta_R := (if In_Subtree (Sub, D.Tail (E)) then Sl else -Sl);
+
+            if 2 * (D.Lim (Sub) - D.Low (Sub) + 1)
+              <= D.Lim (R) - D.Low (R) + 1
+            then
+               for K in D.Low (Sub) .. D.Lim (Sub) loop
+                  Rank (D.Post (K)) := Rank (D.Post (K)) + Delta_R;
+               end loop;
+            else
+               for K in D.Low (R) .. D.Low (Sub) - 1 loop
+                  Rank (D.Post (K)) := Rank (D.Post (K)) - Delta_R;
+               end loop;
+               for K in D.Lim (Sub) + 1 .. D.Lim (R) loop
+                  Rank (D.Post (K)) := Rank (D.Post (K)) - Delta_R;
+               end loop;
+            end if;
+         end if;
+
+         Lca := Tree_Update (D.Tail (E), Head (E), Dir => True);
+         Lca2 := Tree_Update (Head (E), D.Tail (E), Dir => False);
+         pragma Assert (Lca = Lca2);
+
+         D.Cut (E) := -Cutvalue;
+         D.Cut (F) := 0;
+
+         D.Tree_Pos (E) := D.Tree_Pos (F);
+         D.Tree_Edges (D.Tree_Pos (E)) := E;
+         D.Tree_Pos (F) := 0;
+
+         Dummy := Dfs_Range (Lca, D.Par (Lca), D.Low (Lca));
+      end Update;
+
+      Num_Incident : Natural;
+      Next_Post    : Positive := 1;
+      First        : Positive;
+      V            : Natural;
+      F, E         : Natural;
+      Min_Rank     : Integer;
+      Pivots       : Natural := 0;
+
+   begin
+      --  Compute the edges incident to each vertex
+
+      D.Inc_Last := (others => 0);
+      for K in S.Order'Range loop
+         V := S.Order (K);
+         for P in S.Out_Edges.Last (V - 1) + 1 .. S.Out_Edges.Last (V) loop
+            D.Tail (P) := V;
+            if Head (P) /= V then
+               D.Inc_Last (V) := D.Inc_Last (V) + 1;
+               D.Inc_Last (Head (P)) := D.Inc_Last (Head (P)) + 1;
+            end if;
+         end loop;
+      end loop;
+
+      for I in Min_Vertex_Index .. D.Last_Vertex loop
+         D.Inc_Last (I) := D.Inc_Last (I - 1) + D.Inc_Last (I);
+      end loop;
+      Num_Incident := D.Inc_Last (D.Last_Vertex);
+
+      --  Fill the lists from the end, so that Inc_Last (V) ends up pointing
+      --  just before the first edge of V, i.e. to the last edge of the
+      --  previous vertex.
+
+      for P in reverse 1 .. D.Num_Edges loop
+         if Head (P) /= D.Tail (P) then
+            D.Inc (D.Inc_Last (D.Tail (P))) := P;
+            D.Inc_Last (D.Tail (P)) := D.Inc_Last (D.Tail (P)) - 1;
+            D.Inc (D.Inc_Last (Head (P))) := P;
+            D.Inc_Last (Head (P)) := D.Inc_Last (Head (P)) - 1;
+         end if;
+      end loop;
+
+      for I in Min_Vertex_Index .. D.Last_Vertex - 1 loop
+         D.Inc_Last (I) := D.Inc_Last (I + 1);
+      end loop;
+      D.Inc_Last (D.Last_Vertex) := Num_Incident;
+
+      --  Initial spanning tree, postorder numbering and cut values
+
+      D.Tree_Pos := (others => 0);
+      D.Cut := (others => 0);
+      Feasible_Tree;
+
+      D.Comp := (others => No_Vertex);
+      for K in S.Order'Range loop
+         V := S.Order (K);
+         if D.Comp (V) = No_Vertex then
+            First := Next_Post;
+            Next_Post := Dfs_Range (V, 0, Next_Post);
+            for P in First .. Next_Post - 1 loop
+               D.Root (D.Post (P)) := V;
+               D.Comp (D.Post (P)) := V;
+            end loop;
+         end if;
+      end loop;
+
+      for K in 1 .. Next_Post - 1 loop
+         V := D.Post (K);
+         if D.Par (V) /= 0 then
+            D.Cut (D.Par (V)) := X_Cutval (D.Par (V));
+         end if;
+      end loop;
+
+      --  Pivot until all cut values are positive. We limit the number of
+      --  iterations in case the algorithm cycles (the ranking is always
+      --  feasible, just not optimal).
+
+      while Pivots < 10 * D.Num_Vertices + 100 loop
+         F := Leave_Edge;
+         exit when F = 0;
+         E := Enter_Edge (F);
+         exit when E = 0;
+         Update (E, F);
+         Pivots := Pivots + 1;
+      end loop;
+
+      --  Each independent component starts at layer 0
+
+      Info.Min_Layer := 0;
+      Info.Max_Layer := 0;
+
+      for K in S.Order'Range loop
+         V := S.Order (K);
+         if D.Root (V) = V then
+            Min_Rank := Integer'Last;
+            for P in D.Low (V) .. D.Lim (V) loop
+               Min_Rank := Integer'Min (Min_Rank, Rank (D.Post (P)));
+            end loop;
+
+            for P in D.Low (V) .. D.Lim (V) loop
+               Rank (D.Post (P)) := Rank (D.Post (P)) - Min_Rank;
+               Info.Max_Layer := Integer'Max
+                 (Info.Max_Layer, Rank (D.Post (P)));
+            end loop;
+         end if;
+      end loop;
+
+      Unchecked_Free (D);
+   end Simplex_Rank;
+
    ----------------
    -- Rank_Items --
    ----------------
@@ -967,16 +2040,21 @@ package body Glib.Graphs.Layouts is
       Spanning  : Tree (Max_I);
 
    begin
-      Init_Rank (G, Info);
+      if Info.Previous /= null then
+         Constrained_Rank (G, Info);
+         return;
+      end if;
 
-      Feasible_Tree (G, Info, Spanning);
+      Init_Rank (G, Info);
 
-      --  ??? Should now compute cut values, and adjust layers for edges
-      --  with negative cut values. The idea is that a node with for
-      --  instance more incoming edges than outgoing edges, should
-      --  preferably shorten the incoming edges
+      case Info.Ranking is
+         when Tight_Tree =>
+            Feasible_Tree (G, Info, Spanning);
+            Normalize_Layers (Spanning, Info);
 
-      Normalize_Layers (Spanning, Info);
+         when Network_Simplex =>
+            Simplex_Rank (G, Info);
+      end case;
 
       --  ??? Could balance the layers: when a node can be in multiple
       --  layers (same number of incomding and outgoing edges), it should be
@@ -995,6 +2073,13 @@ package body Glib.Graphs.Layouts is
       --  When an edge spans multiple layers, replace it with a chain of
       --  edges, each of which only connects adjacent layers
 
+      procedure Run
+        (G      : in out Graph;
+         Info   : in out Layout_Info;
+         Placed : access procedure
+           (V : Vertex_Access; Place : Vertex_Place));
+      --  Compute the layout once Info has been initialized, then free Info
+
       ------------------------
       -- Insert_Dummy_Nodes --
       ------------------------
@@ -1043,6 +2128,69 @@ package body Glib.Graphs.Layouts is
          end loop;
       end Insert_Dummy_Nodes;
 
+      ---------
+      -- Run --
+      ---------
+
+      procedure Run
+        (G      : in out Graph;
+         Info   : in out Layout_Info;
+         Placed : access procedure
+           (V : Vertex_Access; Place : Vertex_Place))
+      is
+         Was_Frozen : constant Boolean := Is_Frozen (G);
+         C          : Vertex_Lists.Cursor;
+         Order      : Natural;
+      begin
+         if not Is_Directed (G) then
+            Free (Info);
+            raise Program_Error
+              with "Layer layout only applies to directed graphs";
+         end if;
+
+         --  The graph is frozen while we only traverse it, which is much
+         --  faster for large graphs. Make_Acyclic and Insert_Dummy_Nodes
+         --  modify the graph, and thus discard the snapshot.
+
+         Make_Acyclic (G);
+
+         if not Is_Frozen (G) then
+            Freeze (G);
+         end if;
+
+         Rank_Items (G, Info);
+
+         if Add_Dummy_Nodes then
+            Insert_Dummy_Nodes (G, Info);
+         end if;
+
+         if not Is_Frozen (G) then
+            Freeze (G);
+         end if;
+
+         Organize_Nodes (G, Info);
+
+         if Placed /= null then
+            for L in Info.In_Layers'Range loop
+               Order := 0;
+               C := Info.In_Layers (L).First;
+               while Has_Element (C) loop
+                  Order := Order + 1;
+                  if Element (C).all not in Base_Dummy_Vertex'Class then
+                     Placed (Element (C), (Layer => L, Order => Order));
+                  end if;
+                  Next (C);
+               end loop;
+            end loop;
+         end if;
+
+         Free (Info);
+
+         if not Was_Frozen then
+            Thaw (G);
+         end if;
+      end Run;
+
       ------------
       -- Layout --
       ------------
@@ -1051,7 +2199,11 @@ package body Glib.Graphs.Layouts is
         (G                    : in out Graph;
          Horizontal           : Boolean := True;
          Space_Between_Layers : Gdouble := 20.0;
-         Space_Between_Items  : Gdouble := 10.0)
+         Space_Between_Items  : Gdouble := 10.0;
+         Ordering             : Ordering_Options := (others => <>);
+         Ranking              : Ranking_Method := Tight_Tree;
+         Placed               : access procedure
+           (V : Vertex_Access; Place : Vertex_Place) := null)
       is
          Info : Layout_Info;
       begin
@@ -1063,25 +2215,78 @@ package body Glib.Graphs.Layouts is
          Info.Horizontal           := Horizontal;
          Info.Space_Between_Items  := Space_Between_Items;
          Info.Space_Between_Layers := Space_Between_Layers;
+         Info.Ordering             := Ordering;
+         Info.Ranking              := Ranking;
 
          Info.Layers :=
            new Integer_Array'(Min_Vertex_Index .. Max_Index (G) => 0);
 
-         if not Is_Directed (G) then
-            raise Program_Error
-              with "Layer layout only applies to directed graphs";
-         end if;
+         Run (G, Info, Placed);
+      end Layout;
 
-         Make_Acyclic (G);
-         Rank_Items (G, Info);
+      ------------------------
+      -- Incremental_Layout --
+      ------------------------
 
-         if Add_Dummy_Nodes then
-            Insert_Dummy_Nodes (G, Info);
+      procedure Incremental_Layout
+        (G                    : in out Graph;
+         Previous             : not null access function
+           (V : Vertex_Access) return Vertex_Place;
+         Horizontal           : Boolean := True;
+         Space_Between_Layers : Gdouble := 20.0;
+         Space_Between_Items  : Gdouble := 10.0;
+         Placed               : access procedure
+           (V : Vertex_Access; Place : Vertex_Place) := null)
+      is
+         Info      : Layout_Info;
+         Vit       : Vertex_Iterator;
+         Eit       : Edge_Iterator;
+         Backward  : Edge_Lists.List;
+         Src, Dest : Natural;
+      begin
+         if Max_Index (G) = -1 then
+            return;
          end if;
 
-         Organize_Nodes (G, Info);
-         Free (Info);
-      end Layout;
+         Info.Horizontal           := Horizontal;
+         Info.Space_Between_Items  := Space_Between_Items;
+         Info.Space_Between_Layers := Space_Between_Layers;
+         Info.Ranking              := Tight_Tree;
+
+         Info.Layers :=
+           new Integer_Array'(Min_Vertex_Index .. Max_Index (G) => 0);
+         Info.Previous :=
+           new Place_Array'(Min_Vertex_Index .. Max_Index (G) => No_Place);
+
+         Vit := First (G);
+         while not At_End (Vit) loop
+            Info.Previous (Get_Index (Get (Vit))) := Previous (Get (Vit));
+            Next (Vit);
+         end loop;
+
+         --  Edges between fixed vertices that go backward were reverted in
+         --  the previous layout. Revert them first, so that Make_Acyclic
+         --  does not choose other edges and force these vertices to move.
+
+         Eit := First (G);
+         while not At_End (Eit) loop
+            Src  := Get_Index (Get_Src (Get (Eit)));
+            Dest := Get_Index (Get_Dest (Get (Eit)));
+            if Is_Fixed (Info, Src)
+              and then Is_Fixed (Info, Dest)
+              and then Info.Previous (Src).Layer > Info.Previous (Dest).Layer
+            then
+               Backward.Append (Get (Eit));
+            end if;
+            Next (Eit);
+         end loop;
+
+         for E of Backward loop
+            Revert_Edge (G, E);
+         end loop;
+
+         Run (G, Info, Placed);
+      end Incremental_Layout;
 
    end Layered_Layouts;
 
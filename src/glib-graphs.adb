@@ -25,6 +25,168 @@ with Unchecked_Deallocation;
 
 package body Glib.Graphs is
 
+   generic
+      type Cell_Record is private;
+      type Cell_Access is access all Cell_Record;
+      with function Get_Next (C : not null Cell_Access) return Cell_Access;
+      with procedure Set_Next (C : not null Cell_Access; Next : Cell_Access);
+   package Cell_Pools is
+      type Pool is limited private;
+
+      function Allocate
+        (P         : in out Pool;
+         Use_Arena : Boolean;
+         Value     : Cell_Record) return not null Cell_Access;
+      --  Return a new cell initialized with Value
+
+      procedure Release
+        (P         : in out Pool;
+         Use_Arena : Boolean;
+         C         : in out Cell_Access);
+      --  Free C, or keep it for the next call to Allocate
+
+      procedure Clear (P : in out Pool);
+      --  Free all the blocks allocated for the arena. This invalidates all
+      --  the cells returned by Allocate when Use_Arena was True.
+
+      function Allocations (P : Pool) return Natural;
+      --  The number of heap allocations done so far
+
+   private
+      Block_Size : constant := 1024;
+
+      type Cell_Array is array (1 .. Block_Size) of aliased Cell_Record;
+      type Block;
+      type Block_Access is access Block;
+      type Block is record
+         Cells : Cell_Array;
+         Next  : Block_Access;
+      end record;
+
+      type Pool is limited record
+         Blocks      : Block_Access;
+         Used        : Natural := Block_Size;
+         --  The number of cells used in the first block
+
+         Free_Cells  : Cell_Access;
+         --  The cells that were released, chained through their Next field
+
+         Allocations : Natural := 0;
+      end record;
+   end Cell_Pools;
+
+   ----------------
+   -- Cell_Pools --
+   ----------------
+
+   package body Cell_Pools is
+
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Cell_Record, Cell_Access);
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Block, Block_Access);
+
+      --------------
+      -- Allocate --
+      --------------
+
+      function Allocate
+        (P         : in out Pool;
+         Use_Arena : Boolean;
+         Value     : Cell_Record) return not null Cell_Access
+      is
+         C : Cell_Access;
+      begin
+         if not Use_Arena then
+            P.Allocations := P.Allocations + 1;
+            return new Cell_Record'(Value);
+         end if;
+
+         if P.Free_Cells /= null then
+            C := P.Free_Cells;
+            P.Free_Cells := Get_Next (C);
+
+         else
+            if P.Used = Block_Size then
+               P.Blocks := new Block'(Cells => <>, Next => P.Blocks);
+               P.Used := 0;
+               P.Allocations := P.Allocations + 1;
+            end if;
+
+            P.Used := P.Used + 1;
+            C := P.Blocks.Cells (P.Used)'Unchecked_Access;
+         end if;
+
+         C.all := Value;
+         return C;
+      end Allocate;
+
+      -------------
+      -- Release --
+      -------------
+
+      procedure Release
+        (P         : in out Pool;
+         Use_Arena : Boolean;
+         C         : in out Cell_Access)
+      is
+      begin
+         if Use_Arena then
+            Set_Next (C, P.Free_Cells);
+            P.Free_Cells := C;
+            C := null;
+         else
+            Unchecked_Free (C);
+         end if;
+      end Release;
+
+      -----------
+      -- Clear --
+      -----------
+
+      procedure Clear (P : in out Pool) is
+         B : Block_Access;
+      begin
+         while P.Blocks /= null loop
+            B := P.Blocks;
+            P.Blocks := B.Next;
+            Unchecked_Free (B);
+         end loop;
+
+         P.Used       := Block_Size;
+         P.Free_Cells := null;
+      end Clear;
+
+      -----------------
+      -- Allocations --
+      -----------------
+
+      function Allocations (P : Pool) return Natural is
+      begin
+         return P.Allocations;
+      end Allocations;
+   end Cell_Pools;
+
+   function Get_Next (C : not null Edge_List) return Edge_List is (C.Next);
+   function Get_Next (C : not null Vertex_List) return Vertex_List
+     is (C.Next);
+   procedure Set_Next (C : not null Edge_List; Next : Edge_List);
+   procedure Set_Next (C : not null Vertex_List; Next : Vertex_List);
+
+   package Edge_Cells is new Cell_Pools
+     (Edge_List_Record, Edge_List, Get_Next, Set_Next);
+   package Vertex_Cells is new Cell_Pools
+     (Vertex_List_Record, Vertex_List, Get_Next, Set_Next);
+
+   type Cell_Storage is limited record
+      Use_Arena : Boolean;
+      Edges     : Edge_Cells.Pool;
+      Vertices  : Vertex_Cells.Pool;
+   end record;
+
+   procedure Unchecked_Free is new Unchecked_Deallocation
+     (Cell_Storage, Cell_Storage_Access);
+
    type Search_Color is (White, Gray, Black);
    type Color_Array  is array (Natural range <>) of Search_Color;
 
@@ -33,6 +195,42 @@ package body Glib.Graphs is
    --  E should be the first potential candidate for the next item (ie should
    --  already have been moved to the next edge).
 
+   procedure Link
+     (S : not null Cell_Storage_Access; E : access Edge'Class);
+   procedure Unlink
+     (S : not null Cell_Storage_Access; E : access Edge'Class);
+   --  Add or remove E from the lists of its ends, and update their degree
+
+   procedure Unchecked_Free is new Unchecked_Deallocation
+     (Graph_Snapshot, Graph_Snapshot_Access);
+
+   procedure Set_Range
+     (S : not null Graph_Snapshot_Access; C : in out Adjacency_Cursor);
+   --  Point C to the first edge of C.Vertex in the current direction
+
+   procedure Skip_To_Valid
+     (S : not null Graph_Snapshot_Access; C : in out Adjacency_Cursor);
+   --  Move C to the first edge it should return, starting at the current
+   --  position. This switches to the second pass if needed.
+
+   --------------
+   -- Set_Next --
+   --------------
+
+   procedure Set_Next (C : not null Edge_List; Next : Edge_List) is
+   begin
+      C.Next := Next;
+   end Set_Next;
+
+   --------------
+   -- Set_Next --
+   --------------
+
+   procedure Set_Next (C : not null Vertex_List; Next : Vertex_List) is
+   begin
+      C.Next := Next;
+   end Set_Next;
+
    ------------------
    -- Set_Directed --
    ------------------
@@ -51,6 +249,39 @@ package body Glib.Graphs is
       return G.Directed;
    end Is_Directed;
 
+   -------------------
+   -- Set_Use_Arena --
+   -------------------
+
+   procedure Set_Use_Arena (G : in out Graph; Use_Arena : Boolean) is
+   begin
+      pragma Assert (G.Vertices = null);
+      Clear (G);
+      G.Use_Arena := Use_Arena;
+   end Set_Use_Arena;
+
+   -------------------
+   -- Get_Use_Arena --
+   -------------------
+
+   function Get_Use_Arena (G : Graph) return Boolean is
+   begin
+      return G.Use_Arena;
+   end Get_Use_Arena;
+
+   -----------------------
+   -- Count_Allocations --
+   -----------------------
+
+   function Count_Allocations (G : Graph) return Natural is
+   begin
+      if G.Cells = null then
+         return 0;
+      end if;
+      return Edge_Cells.Allocations (G.Cells.Edges)
+        + Vertex_Cells.Allocations (G.Cells.Vertices);
+   end Count_Allocations;
+
    ---------------
    -- Get_Index --
    ---------------
@@ -69,16 +300,214 @@ package body Glib.Graphs is
       return G.Last_Vertex_Index - 1;
    end Max_Index;
 
+   --------------
+   -- Renumber --
+   --------------
+
+   procedure Renumber (G : in out Graph) is
+      Tmp : Vertex_List := G.Vertices;
+   begin
+      Thaw (G);
+      G.Last_Vertex_Index := Min_Vertex_Index;
+      while Tmp /= null loop
+         Tmp.V.Index := G.Last_Vertex_Index;
+         G.Last_Vertex_Index := G.Last_Vertex_Index + 1;
+         Tmp := Tmp.Next;
+      end loop;
+   end Renumber;
+
+   ------------
+   -- Freeze --
+   ------------
+
+   procedure Freeze (G : in out Graph) is
+      Num_Edges : Natural := 0;
+      L         : Vertex_List := G.Vertices;
+   begin
+      Thaw (G);
+
+      while L /= null loop
+         Num_Edges := Num_Edges + L.V.Num_Out;
+         L := L.Next;
+      end loop;
+
+      G.Frozen := new Graph_Snapshot
+        (Max_Index    => Max_Index (G),
+         Num_Vertices => G.Num_Vertices,
+         Num_Edges    => Num_Edges);
+
+      declare
+         S     : Graph_Snapshot renames G.Frozen.all;
+         Count : Natural := 0;
+
+         procedure Fill (A : in out Adjacency; Incoming : Boolean);
+         --  Fill the arrays for one direction of the edges
+
+         procedure Fill (A : in out Adjacency; Incoming : Boolean) is
+            E   : Edge_List;
+            Pos : Natural;
+         begin
+            --  First count the edges of each vertex, then compute the
+            --  offsets from these counts.
+
+            A.Last := (others => 0);
+            L := G.Vertices;
+            while L /= null loop
+               A.Last (L.V.Index) :=
+                 (if Incoming then L.V.Num_In else L.V.Num_Out);
+               L := L.Next;
+            end loop;
+
+            for I in Min_Vertex_Index .. A.Max_Index loop
+               A.Last (I) := A.Last (I - 1) + A.Last (I);
+            end loop;
+
+            L := G.Vertices;
+            while L /= null loop
+               Pos := A.Last (L.V.Index - 1);
+               E := (if Incoming then L.V.In_Edges else L.V.Out_Edges);
+               while E /= null loop
+                  Pos := Pos + 1;
+                  A.Edges (Pos) := E.E;
+                  A.Target (Pos) :=
+                    (if Incoming then E.E.Src.Index else E.E.Dest.Index);
+                  E := E.Next;
+               end loop;
+               L := L.Next;
+            end loop;
+         end Fill;
+
+      begin
+         L := G.Vertices;
+         while L /= null loop
+            Count := Count + 1;
+            S.Order (Count) := L.V.Index;
+            S.Vertices (L.V.Index) := L.V;
+            L := L.Next;
+         end loop;
+
+         Fill (S.Out_Edges, Incoming => False);
+         Fill (S.In_Edges, Incoming => True);
+      end;
+   end Freeze;
+
+   ----------
+   -- Thaw --
+   ----------
+
+   procedure Thaw (G : in out Graph) is
+   begin
+      Unchecked_Free (G.Frozen);
+   end Thaw;
+
+   ---------------
+   -- Is_Frozen --
+   ---------------
+
+   function Is_Frozen (G : Graph) return Boolean is
+   begin
+      return Snapshot (G) /= null;
+   end Is_Frozen;
+
+   ---------------
+   -- Set_Range --
+   ---------------
+
+   procedure Set_Range
+     (S : not null Graph_Snapshot_Access; C : in out Adjacency_Cursor) is
+   begin
+      if C.Incoming then
+         C.Pos  := S.In_Edges.Last (C.Vertex - 1) + 1;
+         C.Last := S.In_Edges.Last (C.Vertex);
+      else
+         C.Pos  := S.Out_Edges.Last (C.Vertex - 1) + 1;
+         C.Last := S.Out_Edges.Last (C.Vertex);
+      end if;
+   end Set_Range;
+
+   -------------------
+   -- Skip_To_Valid --
+   -------------------
+
+   procedure Skip_To_Valid
+     (S : not null Graph_Snapshot_Access; C : in out Adjacency_Cursor) is
+   begin
+      loop
+         if C.Pos > C.Last then
+            exit when not C.Both_Ways;
+            C.Both_Ways   := False;
+            C.Second_Pass := True;
+            C.Incoming    := not C.Incoming;
+            Set_Range (S, C);
+
+         --  In the second pass, we must ignore the recursive links to the
+         --  item, since they have already been returned.
+         elsif C.Second_Pass and then Adjacent (S, C) = C.Vertex then
+            C.Pos := C.Pos + 1;
+
+         else
+            exit;
+         end if;
+      end loop;
+   end Skip_To_Valid;
+
+   --------------------
+   -- First_Adjacent --
+   --------------------
+
+   function First_Adjacent
+     (S         : not null Graph_Snapshot_Access;
+      Vertex    : Natural;
+      Incoming  : Boolean;
+      Both_Ways : Boolean) return Adjacency_Cursor
+   is
+      C : Adjacency_Cursor :=
+        (Vertex      => Vertex,
+         Pos         => 1,
+         Last        => 0,
+         Incoming    => Incoming,
+         Second_Pass => False,
+         Both_Ways   => Both_Ways);
+   begin
+      Set_Range (S, C);
+      Skip_To_Valid (S, C);
+      return C;
+   end First_Adjacent;
+
+   ----------
+   -- Next --
+   ----------
+
+   procedure Next
+     (S : not null Graph_Snapshot_Access; C : in out Adjacency_Cursor) is
+   begin
+      C.Pos := C.Pos + 1;
+      Skip_To_Valid (S, C);
+   end Next;
+
    ----------------
    -- Add_Vertex --
    ----------------
 
    procedure Add_Vertex (G : in out Graph; V : access Vertex'Class) is
    begin
+      Thaw (G);
       V.Index             := G.Last_Vertex_Index;
       G.Last_Vertex_Index := G.Last_Vertex_Index + 1;
       G.Num_Vertices      := G.Num_Vertices + 1;
-      Add (G.Vertices, V);
+
+      if G.Cells = null then
+         G.Cells := new Cell_Storage;
+         G.Cells.Use_Arena := G.Use_Arena;
+      end if;
+
+      V.Cell := Vertex_Cells.Allocate
+        (G.Cells.Vertices, G.Cells.Use_Arena,
+         (V => Vertex_Access (V), Prev => null, Next => G.Vertices));
+      if G.Vertices /= null then
+         G.Vertices.Prev := V.Cell;
+      end if;
+      G.Vertices := V.Cell;
    end Add_Vertex;
 
    --------------
@@ -90,13 +519,12 @@ package body Glib.Graphs is
       E            : access Edge'Class;
       Source, Dest : access Vertex'Class)
    is
-      pragma Unreferenced (G);
    begin
       pragma Assert (E.Src = null and then E.Dest = null);
+      Thaw (G);
       E.Src  := Vertex_Access (Source);
       E.Dest := Vertex_Access (Dest);
-      Add (Source.Out_Edges, E);
-      Add (Dest.In_Edges, E);
+      Link (G.Cells, E);
    end Add_Edge;
 
    --------------
@@ -117,18 +545,68 @@ package body Glib.Graphs is
    ------------
 
    procedure Remove (G : in out Graph; E : access Edge'Class) is
-      pragma Unreferenced (G);
-
       procedure Free is new Unchecked_Deallocation (Edge'Class, Edge_Access);
       E2 : Edge_Access := Edge_Access (E);
 
    begin
-      Remove (E.Src.Out_Edges, E);
-      Remove (E.Dest.In_Edges, E);
+      Thaw (G);
+      Unlink (G.Cells, E);
       Destroy (E.all);
       Free (E2);
    end Remove;
 
+   ----------
+   -- Link --
+   ----------
+
+   procedure Link
+     (S : not null Cell_Storage_Access; E : access Edge'Class)
+   is
+      Parallel : Edge_List :=
+        (if E.Src.Num_Out <= E.Dest.Num_In
+         then E.Src.Out_Edges else E.Dest.In_Edges);
+   begin
+      E.Out_Cell := Edge_Cells.Allocate
+        (S.Edges, S.Use_Arena, (Edge_Access (E), Prev => null, Next => null));
+      E.In_Cell := Edge_Cells.Allocate
+        (S.Edges, S.Use_Arena, (Edge_Access (E), Prev => null, Next => null));
+
+      --  Edges with equal ends are next to each other in the lists. Look for
+      --  one of them in the shorter of the two lists.
+
+      while Parallel /= null
+        and then (Parallel.E.Src /= E.Src or else Parallel.E.Dest /= E.Dest)
+      loop
+         Parallel := Parallel.Next;
+      end loop;
+
+      if Parallel = null then
+         Insert (E.Src.Out_Edges, null, E.Out_Cell);
+         Insert (E.Dest.In_Edges, null, E.In_Cell);
+      else
+         Insert (E.Src.Out_Edges, Parallel.E.Out_Cell, E.Out_Cell);
+         Insert (E.Dest.In_Edges, Parallel.E.In_Cell, E.In_Cell);
+      end if;
+
+      E.Src.Num_Out := E.Src.Num_Out + 1;
+      E.Dest.Num_In := E.Dest.Num_In + 1;
+   end Link;
+
+   ------------
+   -- Unlink --
+   ------------
+
+   procedure Unlink
+     (S : not null Cell_Storage_Access; E : access Edge'Class) is
+   begin
+      Remove (E.Src.Out_Edges, E.Out_Cell);
+      Remove (E.Dest.In_Edges, E.In_Cell);
+      Edge_Cells.Release (S.Edges, S.Use_Arena, E.Out_Cell);
+      Edge_Cells.Release (S.Edges, S.Use_Arena, E.In_Cell);
+      E.Src.Num_Out := E.Src.Num_Out - 1;
+      E.Dest.Num_In := E.Dest.Num_In - 1;
+   end Unlink;
+
    -------------
    -- Destroy --
    -------------
@@ -143,10 +621,70 @@ package body Glib.Graphs is
    -----------
 
    procedure Clear (G : in out Graph) is
+      procedure Free is new Unchecked_Deallocation (Edge'Class, Edge_Access);
+      procedure Free is new Unchecked_Deallocation
+        (Vertex'Class, Vertex_Access);
+      L     : Vertex_List;
+      C, C2 : Edge_List;
+      E     : Edge_Access;
    begin
+      Thaw (G);
+
+      if G.Cells = null then
+         return;
+      end if;
+
+      --  Since the whole graph is destroyed, there is no need to keep the
+      --  lists consistent. Each edge is found in the list of its source, and
+      --  is destroyed while both its ends still exist. In an arena, the
+      --  cells are all released at once at the end.
+
+      L := G.Vertices;
+      while L /= null loop
+         C := L.V.Out_Edges;
+         while C /= null loop
+            C2 := C.Next;
+            E := C.E;
+            Destroy (E.all);
+            Free (E);
+            if not G.Cells.Use_Arena then
+               Edge_Cells.Release (G.Cells.Edges, False, C);
+            end if;
+            C := C2;
+         end loop;
+         L := L.Next;
+      end loop;
+
       while G.Vertices /= null loop
-         Remove (G, G.Vertices.V);
+         L := G.Vertices;
+         G.Vertices := L.Next;
+
+         if not G.Cells.Use_Arena then
+            C := L.V.In_Edges;
+            while C /= null loop
+               C2 := C.Next;
+               Edge_Cells.Release (G.Cells.Edges, False, C);
+               C := C2;
+            end loop;
+         end if;
+
+         L.V.In_Edges  := null;
+         L.V.Out_Edges := null;
+         L.V.Num_In    := 0;
+         L.V.Num_Out   := 0;
+         L.V.Cell      := null;
+         Destroy (L.V.all);
+         Free (L.V);
+
+         if not G.Cells.Use_Arena then
+            Vertex_Cells.Release (G.Cells.Vertices, False, L);
+         end if;
       end loop;
+
+      G.Num_Vertices := 0;
+      Edge_Cells.Clear (G.Cells.Edges);
+      Vertex_Cells.Clear (G.Cells.Vertices);
+      Unchecked_Free (G.Cells);
    end Clear;
 
    ------------
@@ -156,25 +694,18 @@ package body Glib.Graphs is
    procedure Remove (G : in out Graph; V : access Vertex'Class) is
       procedure Free is new Unchecked_Deallocation
         (Vertex'Class, Vertex_Access);
-      E : Edge_Iterator;
-      E2 : Edge_Access;
       V2 : Vertex_Access := Vertex_Access (V);
    begin
+      Thaw (G);
+
       --  Destroy all outgoing edges
-      E := First (G, Src => Vertex_Access (V));
-      while not At_End (E) loop
-         E2 := Get (E);
-         Next (E);
-         Remove (G, E2);
+      while V.Out_Edges /= null loop
+         Remove (G, V.Out_Edges.E);
       end loop;
 
       --  Destroy all ingoing edges
-      E := First (G, Dest => Vertex_Access (V));
-      while not At_End (E) loop
-         E2 := Get (E);
-         Next (E);
-         Remove (G, E2);   --  ??? Could be more efficient, since we have
-                           --  the pointer into the list directly
+      while V.In_Edges /= null loop
+         Remove (G, V.In_Edges.E);
       end loop;
 
       --  Free the vertex
@@ -183,64 +714,45 @@ package body Glib.Graphs is
       Free (V2);
    end Remove;
 
-   ---------
-   -- Add --
-   ---------
+   ------------
+   -- Insert --
+   ------------
 
-   procedure Add (List : in out Edge_List; E : access Edge'Class) is
-      L : Edge_List := List;
+   procedure Insert
+     (List  : in out Edge_List;
+      After : Edge_List;
+      Cell  : not null Edge_List)
+   is
    begin
-      --  Insert the item in the list so that items with equal ends are next to
-      --  each other.
-
-      while L /= null loop
-         if L.E.Src = E.Src and then L.E.Dest = E.Dest then
-            L.Next := new Edge_List_Record'
-              (E => Edge_Access (E), Next => L.Next);
-            return;
-         end if;
-         L := L.Next;
-      end loop;
-
-      List := new Edge_List_Record'(E => Edge_Access (E), Next => List);
-   end Add;
-
-   ---------
-   -- Add --
-   ---------
+      Cell.Prev := After;
+      if After = null then
+         Cell.Next := List;
+         List := Cell;
+      else
+         Cell.Next := After.Next;
+         After.Next := Cell;
+      end if;
 
-   procedure Add    (List : in out Vertex_List; V : access Vertex'Class) is
-   begin
-      List := new Vertex_List_Record'(V => Vertex_Access (V), Next => List);
-   end Add;
+      if Cell.Next /= null then
+         Cell.Next.Prev := Cell;
+      end if;
+   end Insert;
 
    ------------
    -- Remove --
    ------------
 
-   procedure Remove (List : in out Edge_List; E : access Edge'Class) is
-      procedure Internal is new Unchecked_Deallocation
-        (Edge_List_Record, Edge_List);
-      Tmp      : Edge_List := List;
-      Previous : Edge_List;
+   procedure Remove (List : in out Edge_List; Cell : not null Edge_List) is
    begin
-      while Tmp /= null
-        and then Tmp.E /= Edge_Access (E)
-      loop
-         Previous := Tmp;
-         Tmp := Tmp.Next;
-      end loop;
+      if Cell.Prev = null then
+         pragma Assert (Cell = List);
+         List := Cell.Next;
+      else
+         Cell.Prev.Next := Cell.Next;
+      end if;
 
-      if Tmp /= null then
-         if Previous = null then
-            pragma Assert (Tmp = List);
-            Previous := List;
-            List := List.Next;
-            Internal (Previous);
-         else
-            Previous.Next := Tmp.Next;
-            Internal (Tmp);
-         end if;
+      if Cell.Next /= null then
+         Cell.Next.Prev := Cell.Prev;
       end if;
    end Remove;
 
@@ -249,30 +761,22 @@ package body Glib.Graphs is
    ------------
 
    procedure Internal_Remove (G : in out Graph; V : access Vertex'Class) is
-      procedure Internal is new Unchecked_Deallocation
-        (Vertex_List_Record, Vertex_List);
-      Tmp      : Vertex_List := G.Vertices;
-      Previous : Vertex_List := null;
+      Tmp : Vertex_List := V.Cell;
    begin
-      while Tmp /= null
-        and then Tmp.V /= Vertex_Access (V)
-      loop
-         Previous := Tmp;
-         Tmp := Tmp.Next;
-      end loop;
-
       if Tmp /= null then
-         if Previous = null then
-            --  The list contains only one item which is the one to be removed.
-            --  Once it has been removed the list must be reset to null.
+         if Tmp.Prev = null then
             pragma Assert (Tmp = G.Vertices, "Remove vertex");
-            Previous := G.Vertices;
-            G.Vertices := G.Vertices.Next;
-            Internal (Previous);
+            G.Vertices := Tmp.Next;
          else
-            Previous.Next := Tmp.Next;
-            Internal (Tmp);
+            Tmp.Prev.Next := Tmp.Next;
          end if;
+
+         if Tmp.Next /= null then
+            Tmp.Next.Prev := Tmp.Prev;
+         end if;
+
+         V.Cell := null;
+         Vertex_Cells.Release (G.Cells.Vertices, G.Cells.Use_Arena, Tmp);
          G.Num_Vertices := G.Num_Vertices - 1;
       end if;
    end Internal_Remove;
@@ -528,9 +1032,26 @@ package body Glib.Graphs is
       Queue_First : Integer := 0;
       Result : Breadth_Vertices_Array (0 .. G.Num_Vertices - 1);
       Result_Index : Natural := 0;
+      S : constant Graph_Snapshot_Access := Snapshot (G);
 
       V, U : Vertex_Access;
       Eit : Edge_Iterator;
+      C   : Adjacency_Cursor;
+
+      procedure Visit (V : Vertex_Access);
+      --  Process a child V of U
+
+      procedure Visit (V : Vertex_Access) is
+      begin
+         if Colors (V.Index) = White then
+            Colors (V.Index) := Gray;
+            Distances (V.Index) := Distances (U.Index) + 1;
+            Predecessors (V.Index) := U;
+            Queue (Queue_Index) := V;
+            Queue_Index := Queue_Index + 1;
+         end if;
+      end Visit;
+
    begin
       --  Initialize the root
       Distances (Root.Index) := 0;
@@ -539,22 +1060,28 @@ package body Glib.Graphs is
 
       while Queue_First < Queue_Index loop
          U := Queue (Queue_First);
-         Eit := First (G, Src => U);
-         while not At_End (Eit) loop
-            V := Get_Dest (Get (Eit));
-            if V = U then
-               V := Get_Src (Get (Eit));
-            end if;
 
-            if Colors (V.Index) = White then
-               Colors (V.Index) := Gray;
-               Distances (V.Index) := Distances (U.Index) + 1;
-               Predecessors (V.Index) := U;
-               Queue (Queue_Index) := V;
-               Queue_Index := Queue_Index + 1;
-            end if;
-            Next (Eit);
-         end loop;
+         if S /= null then
+            C := First_Adjacent
+              (S, U.Index, Incoming => False, Both_Ways => not G.Directed);
+            while not At_End (C) loop
+               Visit (S.Vertices (Adjacent (S, C)));
+               Next (S, C);
+            end loop;
+
+         else
+            Eit := First (G, Src => U);
+            while not At_End (Eit) loop
+               V := Get_Dest (Get (Eit));
+               if V = U then
+                  V := Get_Src (Get (Eit));
+               end if;
+
+               Visit (V);
+               Next (Eit);
+            end loop;
+         end if;
+
          Queue_First := Queue_First + 1;
          Colors (U.Index) := Black;
          Result (Result_Index) :=
@@ -591,12 +1118,41 @@ package body Glib.Graphs is
       Result_Index : Integer := Result'Last;
       Time : Natural := 0;
 
+      S : constant Graph_Snapshot_Access :=
+        (if Reverse_Edge_Cb = null then Snapshot (G) else null);
+      --  The callback modifies the graph, so we can't use the snapshot then
+
+      type Frame is record
+         U            : Natural;
+         Predecessor  : Vertex_Access;
+         Edge         : Edge_Access;
+         Start_Search : Natural;
+         Cursor       : Adjacency_Cursor;
+      end record;
+      type Frame_Array is array (Positive range <>) of Frame;
+      type Frame_Array_Access is access Frame_Array;
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Frame_Array, Frame_Array_Access);
+
+      Stack : Frame_Array_Access;
+      Top   : Natural := 0;
+      --  The vertices being processed when using the snapshot
+
       procedure Depth_First_Visit
         (U            : Vertex_Access;
          Predecessor  : Vertex_Access;
          Edge         : Edge_Access);
       --  Process the node U
 
+      procedure Push
+        (U           : Natural;
+         Predecessor : Vertex_Access;
+         Edge        : Edge_Access);
+      procedure Depth_First_Visit_Frozen (Root : Natural);
+      --  Same as Depth_First_Visit, but using the snapshot. We use an
+      --  explicit stack instead of recursion, so that deep graphs do not
+      --  exhaust the stack.
+
       procedure Depth_First_Visit
         (U            : Vertex_Access;
          Predecessor  : Vertex_Access;
@@ -654,9 +1210,77 @@ package body Glib.Graphs is
          Result_Index := Result_Index - 1;
       end Depth_First_Visit;
 
+      procedure Push
+        (U           : Natural;
+         Predecessor : Vertex_Access;
+         Edge        : Edge_Access) is
+      begin
+         Colors (U) := Gray;
+         Time := Time + 1;
+         Top := Top + 1;
+         Stack (Top) :=
+           (U            => U,
+            Predecessor  => Predecessor,
+            Edge         => Edge,
+            Start_Search => Time,
+            Cursor       => First_Adjacent
+              (S, U,
+               Incoming  => False,
+               Both_Ways => Force_Undirected or else not G.Directed));
+      end Push;
+
+      procedure Depth_First_Visit_Frozen (Root : Natural) is
+         V : Natural;
+         E : Edge_Access;
+      begin
+         Push (Root, Predecessor => null, Edge => null);
+
+         while Top /= 0 loop
+            declare
+               F : Frame renames Stack (Top);
+            begin
+               if At_End (F.Cursor) then
+                  Colors (F.U) := Black;
+                  Time := Time + 1;
+                  Result (Result_Index) :=
+                    (S.Vertices (F.U),
+                     First_Discovered => F.Start_Search,
+                     End_Search       => Time,
+                     Predecessor      => F.Predecessor,
+                     Edge             => F.Edge);
+                  Result_Index := Result_Index - 1;
+                  Top := Top - 1;
+
+               else
+                  V := Adjacent (S, F.Cursor);
+                  E := Get (S, F.Cursor);
+                  Next (S, F.Cursor);
+
+                  if Colors (V) = White then
+                     Push (V, Predecessor => S.Vertices (F.U), Edge => E);
+                  elsif not Force_Undirected and then Colors (V) = Gray then
+                     Acyclic.all := False;
+                  end if;
+               end if;
+            end;
+         end loop;
+      end Depth_First_Visit_Frozen;
+
       U : Vertex_List;
    begin
       Acyclic.all := True;
+
+      if S /= null then
+         Stack := new Frame_Array (1 .. S.Num_Vertices);
+         for K in S.Order'Range loop
+            if Colors (S.Order (K)) = White then
+               Depth_First_Visit_Frozen (S.Order (K));
+            end if;
+         end loop;
+         Unchecked_Free (Stack);
+         return Result;
+      end if;
+
       U := G.Vertices;
       while U /= null loop
          if Colors (U.V.Index) = White then
@@ -757,10 +1381,56 @@ package body Glib.Graphs is
       Colors : Color_Array (0 .. G.Last_Vertex_Index - 1) := (others => White);
       Result : Vertices_Array (0 .. G.Num_Vertices - 1);
       Result_Index : Integer := Result'Last;
+      S : constant Graph_Snapshot_Access := Snapshot (G);
+
+      type Cursor_Array is array (Positive range <>) of Adjacency_Cursor;
+      type Cursor_Array_Access is access Cursor_Array;
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Cursor_Array, Cursor_Array_Access);
+
+      Stack : Cursor_Array_Access;
+      --  The vertices being processed when using the snapshot
 
       procedure Depth_First_Visit (U : Vertex_Access);
       --  Process the node U
 
+      procedure Depth_First_Visit_Frozen (Root : Natural);
+      --  Same as Depth_First_Visit, but using the snapshot and an explicit
+      --  stack.
+
+      procedure Depth_First_Visit_Frozen (Root : Natural) is
+         Top : Natural := 1;
+         V   : Natural;
+      begin
+         Colors (Root) := Gray;
+         Stack (Top) := First_Adjacent
+           (S, Root, Incoming => True, Both_Ways => False);
+
+         while Top /= 0 loop
+            declare
+               C : Adjacency_Cursor renames Stack (Top);
+            begin
+               if At_End (C) then
+                  Colors (C.Vertex) := Black;
+                  Result (Result_Index) := S.Vertices (C.Vertex);
+                  Result_Index := Result_Index - 1;
+                  Top := Top - 1;
+
+               else
+                  V := Adjacent (S, C);
+                  Next (S, C);
+
+                  if Colors (V) = White then
+                     Colors (V) := Gray;
+                     Top := Top + 1;
+                     Stack (Top) := First_Adjacent
+                       (S, V, Incoming => True, Both_Ways => False);
+                  end if;
+               end if;
+            end;
+         end loop;
+      end Depth_First_Visit_Frozen;
+
       procedure Depth_First_Visit (U : Vertex_Access) is
          V : Vertex_Access;
          Eit : Edge_Iterator;
@@ -788,9 +1458,19 @@ package body Glib.Graphs is
       List : Connected_Component_List := null;
    begin
       pragma Assert (G.Directed);
+
+      if S /= null then
+         Stack := new Cursor_Array (1 .. S.Num_Vertices);
+      end if;
+
       for U in DFS'Range loop
          if Colors (DFS (U).Vertex.Index) = White then
-            Depth_First_Visit (DFS (U).Vertex);
+            if S /= null then
+               Depth_First_Visit_Frozen (DFS (U).Vertex.Index);
+            else
+               Depth_First_Visit (DFS (U).Vertex);
+            end if;
+
             List := new Connected_Component'
               (Num_Vertices => Result'Last - Result_Index,
                Vertices     => Result (Result_Index + 1 .. Result'Last),
@@ -798,6 +1478,8 @@ package body Glib.Graphs is
             Result_Index := Result'Last;
          end if;
       end loop;
+
+      Unchecked_Free (Stack);
       return List;
    end Strongly_Connected_Components;
 
@@ -808,64 +1490,78 @@ package body Glib.Graphs is
    function Kruskal (G : Graph) return Edges_Array is
       Result : Edges_Array (0 .. G.Num_Vertices - 2);
       Result_Index : Natural := Result'First;
+      S : constant Graph_Snapshot_Access := Snapshot (G);
       Eit : Edge_Iterator;
-      U, V : Vertex_Access;
 
-      Sets : array (0 .. G.Last_Vertex_Index - 1) of Natural;
+      Sets : Index_Array (0 .. G.Last_Vertex_Index - 1);
       --  This is used to represent the sets that will contain the
-      --  vertices. Probably not the fastest method (the union operation is
-      --  quite slow), but the easiest to implement.
+      --  vertices. Each set is a tree, and Sets points to the parent of each
+      --  vertex in that tree (or to the vertex itself for the root of the
+      --  tree, which represents the set).
+
+      function Find_Set (V : Natural) return Natural;
+      --  Return the root of the set that contains V. The path to the root is
+      --  shortened at the same time, so that the next lookups are faster.
+
+      procedure Add_If_Disjoint (E : Edge_Access; U, V : Natural);
+      --  Add E to the result if its ends U and V are in different sets, and
+      --  merge the two sets.
+
+      function Find_Set (V : Natural) return Natural is
+         R : Natural := V;
+      begin
+         while Sets (R) /= R loop
+            Sets (R) := Sets (Sets (R));
+            R := Sets (R);
+         end loop;
+         return R;
+      end Find_Set;
+
+      procedure Add_If_Disjoint (E : Edge_Access; U, V : Natural) is
+         U_Set : constant Natural := Find_Set (U);
+         V_Set : constant Natural := Find_Set (V);
+      begin
+         if U_Set /= V_Set then
+            Result (Result_Index) := E;
+            Result_Index := Result_Index + 1;
+            Sets (V_Set) := U_Set;
+         end if;
+      end Add_If_Disjoint;
 
-      V_Set : Natural;
+      U : Natural;
 
    begin
       --  First put all vertices in their own set
-      for S in Sets'Range loop
-         Sets (S) := S;
+      for I in Sets'Range loop
+         Sets (I) := I;
       end loop;
 
       --  ??? Should sort the edges by increasing weight
       --  ??? and do the loop in that order
 
-      Eit := First (G, Src => Vertex_Access'(null));
-      while not At_End (Eit) loop
-         U := Get_Src (Get (Eit));
-         V := Get_Dest (Get (Eit));
-
-         if Sets (U.Index) /= Sets (V.Index) then
-            Result (Result_Index) := Get (Eit);
-            Result_Index := Result_Index + 1;
-
-            --  Merge the two sets
-            V_Set := Sets (V.Index);
-            for S in Sets'Range loop
-               if Sets (S) = V_Set then
-                  Sets (S) := Sets (U.Index);
-               end if;
+      if S /= null then
+         for K in S.Order'Range loop
+            U := S.Order (K);
+            for P in S.Out_Edges.Last (U - 1) + 1 .. S.Out_Edges.Last (U) loop
+               Add_If_Disjoint
+                 (S.Out_Edges.Edges (P), U, S.Out_Edges.Target (P));
             end loop;
-         end if;
+         end loop;
 
-         Next (Eit);
-      end loop;
+      else
+         Eit := First (G, Src => Vertex_Access'(null));
+         while not At_End (Eit) loop
+            Add_If_Disjoint
+              (Get (Eit),
+               Get_Src (Get (Eit)).Index,
+               Get_Dest (Get (Eit)).Index);
+            Next (Eit);
+         end loop;
+      end if;
 
       return Result;
    end Kruskal;
 
-   ------------
-   -- Length --
-   ------------
-
-   function Length (List : Edge_List) return Natural is
-      E : Edge_List := List;
-      Count : Natural := 0;
-   begin
-      while E /= null loop
-         Count := Count + 1;
-         E := E.Next;
-      end loop;
-      return Count;
-   end Length;
-
    ---------------
    -- In_Degree --
    ---------------
@@ -873,7 +1569,7 @@ package body Glib.Graphs is
    function In_Degree (G : Graph; V : access Vertex'Class) return Natural is
       pragma Unreferenced (G);
    begin
-      return Length (V.In_Edges);
+      return V.Num_In;
    end In_Degree;
 
    ----------------
@@ -883,7 +1579,7 @@ package body Glib.Graphs is
    function Out_Degree (G : Graph; V : access Vertex'Class) return Natural is
       pragma Unreferenced (G);
    begin
-      return Length (V.Out_Edges);
+      return V.Num_Out;
    end Out_Degree;
 
    -------------------
@@ -891,27 +1587,24 @@ package body Glib.Graphs is
    -------------------
 
    procedure Move_To_Front (G : in out Graph; V : access Vertex'Class) is
-      Iter : Vertex_List := G.Vertices;
-      Tmp : Vertex_List;
-   begin
-      --  No or only one item => nothing to do
-      if G.Vertices = null
-        or else G.Vertices.V = Vertex_Access (V)
-        or else G.Vertices.Next = null
-      then
+      Tmp : constant Vertex_List := V.Cell;
+   begin
+      Thaw (G);
+
+      --  Already the first item => nothing to do
+      if Tmp = null or else Tmp.Prev = null then
          return;
       end if;
 
-      while Iter.Next /= null and then Iter.Next.V /= Vertex_Access (V) loop
-         Iter := Iter.Next;
-      end loop;
-
-      if Iter.Next /= null then
-         Tmp := Iter.Next;
-         Iter.Next := Tmp.Next;
-         Tmp.Next := G.Vertices;
-         G.Vertices := Tmp;
+      Tmp.Prev.Next := Tmp.Next;
+      if Tmp.Next /= null then
+         Tmp.Next.Prev := Tmp.Prev;
       end if;
+
+      Tmp.Prev := null;
+      Tmp.Next := G.Vertices;
+      G.Vertices.Prev := Tmp;
+      G.Vertices := Tmp;
    end Move_To_Front;
 
    ------------------
@@ -919,33 +1612,31 @@ package body Glib.Graphs is
    ------------------
 
    procedure Move_To_Back (G : in out Graph; V : access Vertex'Class) is
+      Old  : constant Vertex_List := V.Cell;
       Iter : Vertex_List;
-      Old   : Vertex_List := null;
    begin
-      if G.Vertices = null or else G.Vertices.Next = null then
-         return;
-      end if;
+      Thaw (G);
 
-      if G.Vertices.V = Vertex_Access (V) then
-         Old := G.Vertices;
-         G.Vertices := G.Vertices.Next;
+      --  Already the last item => nothing to do
+      if Old = null or else Old.Next = null then
+         return;
       end if;
 
-      Iter := G.Vertices;
-
+      Iter := Old.Next;
       while Iter.Next /= null loop
-         if Iter.Next.V = Vertex_Access (V) then
-            Old := Iter.Next;
-            Iter.Next := Old.Next;
-         else
-            Iter := Iter.Next;
-         end if;
+         Iter := Iter.Next;
       end loop;
 
-      if Old /= null then
-         Old.Next := null;
-         Iter.Next := Old;
+      if Old.Prev = null then
+         G.Vertices := Old.Next;
+      else
+         Old.Prev.Next := Old.Next;
       end if;
+      Old.Next.Prev := Old.Prev;
+
+      Old.Prev  := Iter;
+      Old.Next  := null;
+      Iter.Next := Old;
    end Move_To_Back;
 
    -----------------
@@ -953,18 +1644,19 @@ package body Glib.Graphs is
    -----------------
 
    procedure Revert_Edge (G : Graph; E : Edge_Access) is
-      pragma Unreferenced (G);
-
       Src  : constant Vertex_Access := E.Src;
       Dest : constant Vertex_Access := E.Dest;
 
    begin
-      Remove (E.Src.Out_Edges, E);
-      Remove (E.Dest.In_Edges, E);
+      --  G is read-only here, so we can't free the snapshot
+      if G.Frozen /= null then
+         G.Frozen.Stale := True;
+      end if;
+
+      Unlink (G.Cells, E);
       E.Src  := Dest;
       E.Dest := Src;
-      Add (E.Src.Out_Edges, E);
-      Add (E.Dest.In_Edges, E);
+      Link (G.Cells, E);
    end Revert_Edge;
 
 end Glib.Graphs;
@@ -22,7 +22,14 @@
 --                                                                          --
 ------------------------------------------------------------------------------
 
+with Ada.Characters.Handling; use Ada.Characters.Handling;
+with Ada.Containers.Hashed_Maps;
+with Ada.Containers.Hashed_Sets;
+with Ada.Containers.Indefinite_Hashed_Maps;
+with Ada.Containers.Vectors;
 with Ada.Strings.Fixed; use Ada.Strings.Fixed;
+with Ada.Strings.Hash;
+with System.Storage_Elements;
 with Glib.Convert;  use Glib.Convert;
 with Glib.Error;    use Glib.Error;
 with Glib.Unicode;  use Glib.Unicode;
@@ -69,43 +76,6 @@ package body Glib.XML is
    pragma Import (C, Close, "close");
    --  Close file referenced by FD
 
-   procedure Skip_Blanks (Buf : String; Index : in out Natural);
-   --  Skip blanks, LF and CR, starting at Index. Index is updated to the
-   --  new position (first non blank or EOF)
-
-   function Get_Node (Buf : String; Index : access Natural) return Node_Ptr;
-   --  The main parse routine. Starting at Index.all, Index.all is updated
-   --  on return. Return the node starting at Buf (Index.all) which will
-   --  also contain all the children and subchildren.
-
-   procedure Get_Buf
-     (Buf        : String;
-      Index      : in out Natural;
-      Terminator : Character;
-      S          : out String_Ptr);
-   --  On return, S will contain the String starting at Buf (Index) and
-   --  terminating before the first 'Terminator' character. Index will also
-   --  point to the next non blank character.
-   --  The special XML '&' characters are translated appropriately in S.
-   --  S is set to null if Terminator wasn't found in Buf.
-
-   procedure Extract_Attrib
-     (Tag        : in out String_Ptr;
-      Attributes : out String_Ptr;
-      Empty_Node : out Boolean);
-   --  Extract the attributes as a string, if the tag contains blanks ' '
-   --  On return, Tag is unchanged and Attributes contains the string
-   --  If the last character in Tag is '/' then the node is empty and
-   --  Empty_Node is set to True.
-
-   procedure Get_Next_Word
-     (Buf     : String;
-      Index   : in out Natural;
-      Word    : out String_Ptr);
-   --  extract the next textual word from Buf and return it.
-   --  return null if no word left.
-   --  The special XML '&' characters are translated appropriately in S.
-
    function Translate (S : String) return String;
    --  Translate S by replacing the XML '&' special characters by the
    --  actual ASCII character.
@@ -116,142 +86,107 @@ package body Glib.XML is
    --   - &amp;
    --   - &apos;
 
-   -----------------
-   -- Skip_Blanks --
-   -----------------
-
-   procedure Skip_Blanks (Buf : String; Index : in out Natural) is
-   begin
-      while Index < Buf'Last and then
-        (Buf (Index) = ' '  or else Buf (Index) = ASCII.LF
-          or else Buf (Index) = ASCII.HT
-          or else Buf (Index) = ASCII.CR)
-      loop
-         Index := Index + 1;
-      end loop;
-   end Skip_Blanks;
-
-   -------------
-   -- Get_Buf --
-   -------------
-
-   procedure Get_Buf
-     (Buf        : String;
-      Index      : in out Natural;
-      Terminator : Character;
-      S          : out String_Ptr)
-   is
-      Start : constant Natural := Index;
-
-   begin
-      while Index <= Buf'Last
-        and then Buf (Index) /= Terminator
-      loop
-         Index := Index + 1;
-      end loop;
-
-      if Index > Buf'Last then
-         S := null;
-
-      else
-         S := new String'(Translate (Buf (Start .. Index - 1)));
-         Index := Index + 1;
-
-         if Index < Buf'Last then
-            Skip_Blanks (Buf, Index);
-         end if;
-      end if;
-   end Get_Buf;
-
-   ------------------------
-   -- Extract_Attributes --
-   ------------------------
-
-   procedure Extract_Attrib
-     (Tag        : in out String_Ptr;
-      Attributes : out String_Ptr;
-      Empty_Node : out Boolean)
-   is
-      Index             : Natural := Tag'First;
-      Index_Last_Of_Tag : Natural;
-      S                 : String_Ptr;
-
-   begin
-      --  First decide if the node is empty
-
-      if Tag (Tag'Last) = '/' then
-         Empty_Node := True;
-      else
-         Empty_Node := False;
-      end if;
-
-      while Index <= Tag'Last and then
-        not
-          (Tag (Index) = ' '  or else Tag (Index) = ASCII.LF
-           or else Tag (Index) = ASCII.HT
-           or else Tag (Index) = ASCII.CR)
-      loop
-         Index := Index + 1;
-      end loop;
-
-      Index_Last_Of_Tag := Index - 1;
-      Skip_Blanks (Tag.all, Index);
-
-      if Index <= Tag'Last then
-         if Empty_Node then
-            Attributes := new String'(Tag (Index .. Tag'Last - 1));
-         else
-            Attributes := new String'(Tag (Index .. Tag'Last));
-         end if;
-
-         S := new String'(Tag (Tag'First .. Index_Last_Of_Tag));
-         Free (Tag);
-         Tag := S;
-      end if;
-   end Extract_Attrib;
-
-   -------------------
-   -- Get_Next_Word --
-   -------------------
-
-   procedure Get_Next_Word
-     (Buf     : String;
-      Index   : in out Natural;
-      Word    : out String_Ptr)
-   is
-      Terminator : Character;
-   begin
-      Skip_Blanks (Buf, Index);
-
-      if Buf (Index) = ''' or Buf (Index) = '"' then
-         --  If the word starts with a quotation mark, then read until
-         --  the closing mark
-
-         Terminator := Buf (Index);
-         Index := Index + 1;
-         Get_Buf (Buf, Index, Terminator, Word);
-
-      else
-         --  For a normal word, scan up to either a blank, or a '='
-
-         declare
-            Start_Index : constant Natural := Index;
-         begin
-            while Index <= Buf'Last
-              and then Buf (Index) /= ' '
-              and then Buf (Index) /= '='
-            loop
-               Index := Index + 1;
-            end loop;
-
-            Word := new String'(Translate (Buf (Start_Index .. Index - 1)));
-         end;
-      end if;
-
-      if Index < Buf'Last then
-         Skip_Blanks (Buf, Index);
-      end if;
-   end Get_Next_Word;
+   Parse_Error : exception;
+   --  Raised when the document being parsed is not well formed
+
+   function New_String (S : String) return String_Ptr;
+   --  Return a copy of S, indexed from 1
+
+   function Is_Blank (C : Character) return Boolean
+     is (C = ' ' or else C = ASCII.LF or else C = ASCII.HT
+         or else C = ASCII.CR);
+   --  Whether C is a blank character
+
+   type Scan_State is record
+      Depth   : Natural := 0;
+      --  The number of opening tags that have not been closed yet
+
+      Codeset : String_Ptr;
+      --  The encoding of the document, or null if it is utf8
+
+      Raw     : Boolean := False;
+      --  If True, the strings are reported as slices of the input, without
+      --  any conversion or translation of the XML '&' characters, and the
+      --  encoding of the document is ignored. CDATA sections are reported
+      --  with their markup.
+   end record;
+   --  The state of the parser between two calls to Scan
+
+   procedure Scan
+     (Self   : in out XML_Handler'Class;
+      State  : in out Scan_State;
+      Input  : String;
+      At_EOF : Boolean;
+      First  : in out Natural);
+   --  The main parse routine. Parse the tags and texts in Input, starting at
+   --  First, and report them to Self.
+   --  On exit, First is the first character that has not been parsed. When
+   --  At_EOF is False, the last tag or text in Input might be incomplete, and
+   --  is only parsed once Scan is called again with more input.
+   --  Parse_Error is raised if the document is not well formed.
+
+   procedure Parse_Stream
+     (Self       : in out XML_Handler'Class;
+      Fill       : not null access procedure
+        (Into : out String; Last : out Natural);
+      Chunk_Size : Positive;
+      Success    : out Boolean);
+   --  Read the input in chunks, and parse them with Scan.
+   --  Fill is called to read more data into Into. It sets Last to the index
+   --  of the last character read, or to Into'First - 1 at the end of the
+   --  input.
+
+   function Get_Encoding (Declaration : String) return String;
+   --  Return the encoding named in Declaration, the contents of the <?xml?>
+   --  declaration of a document, or the empty string if none is given or it
+   --  is utf8.
+
+   procedure Next_Attribute
+     (Attributes  : String;
+      Index       : in out Natural;
+      Key_First   : out Natural;
+      Key_Last    : out Natural;
+      Value_First : out Natural;
+      Value_Last  : out Natural);
+   --  Find the first attribute at or after Index in the raw Attributes of a
+   --  node, and move Index after it. Key_First is set to 0 when there are no
+   --  attributes left. The value is not translated.
+   --  Malformed attributes (a key with no value, or a value with no closing
+   --  quote) are skipped, as older versions of this package did.
+
+   procedure Unchecked_Free is new Unchecked_Deallocation
+     (Attribute_Table_Record, Attribute_Table);
+
+   procedure Parse_Attributes (N : Node_Ptr);
+   --  Split the attributes of N into N.Parsed_Attributes, unless this was
+   --  already done for the current value of N.Attributes.
+
+   type Tree_Builder is new XML_Handler with record
+      Root    : Node_Ptr;
+
+      Current : Node_Ptr;
+      --  The node whose contents are being parsed
+
+      Last    : Node_Ptr;
+      --  The last child of Current parsed so far
+   end record;
+   --  Builds the tree returned by Parse and Parse_Buffer
+
+   overriding procedure Start_Tag
+     (Self       : in out Tree_Builder;
+      Tag        : UTF8_String;
+      Attributes : UTF8_String);
+   overriding function Decode_Attributes (Self : Tree_Builder) return Boolean
+     is (False);
+   overriding procedure Text
+     (Self : in out Tree_Builder; Value : UTF8_String);
+   overriding procedure End_Tag
+     (Self : in out Tree_Builder; Tag : UTF8_String);
+
+   function Result
+     (Self : in out Tree_Builder; Success : Boolean) return Node_Ptr;
+   --  Return the tree that was built, or free it and return null if the
+   --  document could not be parsed.
 
    ---------------
    -- Translate --
@@ -308,6 +243,59 @@ package body Glib.XML is
       end if;
    end Translate;
 
+   ----------------------
+   -- Parse_Attributes --
+   ----------------------
+
+   procedure Parse_Attributes (N : Node_Ptr) is
+      Count       : Natural := 0;
+      Index       : Natural;
+      Key_First   : Natural;
+      Key_Last    : Natural;
+      Value_First : Natural;
+      Value_Last  : Natural;
+   begin
+      if N.Parsed_Attributes /= null
+        and then N.Parsed_Attributes.Source = N.Attributes
+        and then N.Attributes /= null
+        and then N.Parsed_Attributes.Text = N.Attributes.all
+      then
+         return;
+      end if;
+
+      Unchecked_Free (N.Parsed_Attributes);
+
+      if N.Attributes = null then
+         return;
+      end if;
+
+      --  Count the attributes first, so that the table is allocated only
+      --  once.
+
+      Index := N.Attributes'First;
+      loop
+         Next_Attribute
+           (N.Attributes.all, Index,
+            Key_First, Key_Last, Value_First, Value_Last);
+         exit when Key_First = 0;
+         Count := Count + 1;
+      end loop;
+
+      N.Parsed_Attributes := new Attribute_Table_Record
+        (Count => Count, Length => N.Attributes'Length);
+      N.Parsed_Attributes.Source := N.Attributes;
+      N.Parsed_Attributes.Text := N.Attributes.all;
+
+      Index := N.Attributes'First;
+      for J in 1 .. Count loop
+         Next_Attribute
+           (N.Attributes.all, Index,
+            Key_First, Key_Last, Value_First, Value_Last);
+         N.Parsed_Attributes.Items (J) :=
+           (Key_First, Key_Last, Value_First, Value_Last);
+      end loop;
+   end Parse_Attributes;
+
    -------------------
    -- Get_Attribute --
    -------------------
@@ -315,43 +303,25 @@ package body Glib.XML is
    function Get_Attribute
      (N              : Node_Ptr;
       Attribute_Name : UTF8_String;
-      Default        : UTF8_String := "") return UTF8_String
-   is
-      Index      : Natural;
-      Key, Value : String_Ptr;
-
+      Default        : UTF8_String := "") return UTF8_String is
    begin
       if N = null or else N.Attributes = null then
          return Default;
       end if;
 
-      Index := N.Attributes'First;
-      while Index < N.Attributes'Last loop
-         Get_Next_Word (N.Attributes.all, Index, Key);
-         Get_Buf (N.Attributes.all, Index, '=', Value);
-         Free (Value);
-         Get_Next_Word (N.Attributes.all, Index, Value);
+      Parse_Attributes (N);
 
-         if Attribute_Name = Key.all then
-            exit;
-         else
-            Free (Key);
-            Free (Value);
+      for Item of N.Parsed_Attributes.Items loop
+         if Item.Key_Last - Item.Key_First + 1 = Attribute_Name'Length
+           and then N.Attributes (Item.Key_First .. Item.Key_Last) =
+             Attribute_Name
+         then
+            return Translate
+              (N.Attributes (Item.Value_First .. Item.Value_Last));
          end if;
       end loop;
 
-      Free (Key);
-
-      if Value = null then
-         return Default;
-      else
-         declare
-            V : constant String := Value.all;
-         begin
-            Free (Value);
-            return V;
-         end;
-      end if;
+      return Default;
    end Get_Attribute;
 
    -------------------
@@ -361,46 +331,57 @@ package body Glib.XML is
    procedure Set_Attribute
      (N : Node_Ptr; Attribute_Name, Attribute_Value : UTF8_String)
    is
-      Index, Tmp : Natural;
-      Key, Value : String_Ptr;
-      Atts       : String_Ptr;
-      Str        : constant String :=
+      Str  : constant String :=
         Attribute_Name & "=""" & Protect (Attribute_Value) & """ ";
+      Atts : String_Ptr;
+      Last : Natural;
 
    begin
-      if N.Attributes /= null then
-         Index := N.Attributes'First;
-         --  First remove any definition of the attribute in the current list
-         while Index < N.Attributes'Last loop
-            Tmp := Index;
-            Get_Next_Word (N.Attributes.all, Index, Key);
-            Get_Buf (N.Attributes.all, Index, '=', Value);
-            Free (Value);
-
-            Get_Next_Word (N.Attributes.all, Index, Value);
-            Free (Value);
-
-            if Attribute_Name = Key.all then
-               Atts := new String'
-                 (Str
-                  & N.Attributes (N.Attributes'First .. Tmp - 1)
-                  & N.Attributes (Index .. N.Attributes'Last));
-               Free (N.Attributes);
-               N.Attributes := Atts;
-               Free (Key);
-               return;
+      if N.Attributes = null then
+         Unchecked_Free (N.Parsed_Attributes);
+         N.Attributes := new String'(Str);
+         return;
+      end if;
+
+      Parse_Attributes (N);
+
+      --  Remove any definition of the attribute in the current list, along
+      --  with the blanks that follow it.
+
+      for Item of N.Parsed_Attributes.Items loop
+         if N.Attributes (Item.Key_First .. Item.Key_Last) =
+           Attribute_Name
+         then
+            Last := Item.Value_Last + 1;
+
+            if Last <= N.Attributes'Last
+              and then (N.Attributes (Last) = '"'
+                        or else N.Attributes (Last) = ''')
+            then
+               Last := Last + 1;
             end if;
 
-            Free (Key);
-         end loop;
+            while Last <= N.Attributes'Last
+              and then Is_Blank (N.Attributes (Last))
+            loop
+               Last := Last + 1;
+            end loop;
 
-         Atts := new String'(Str & N.Attributes.all);
-         Free (N.Attributes);
-         N.Attributes := Atts;
+            Atts := new String'
+              (Str
+               & N.Attributes (N.Attributes'First .. Item.Key_First - 1)
+               & N.Attributes (Last .. N.Attributes'Last));
+            exit;
+         end if;
+      end loop;
 
-      else
-         N.Attributes := new String'(Str);
+      if Atts = null then
+         Atts := new String'(Str & N.Attributes.all);
       end if;
+
+      Free (N.Attributes);
+      Unchecked_Free (N.Parsed_Attributes);
+      N.Attributes := Atts;
    end Set_Attribute;
 
    ---------------
@@ -429,84 +410,6 @@ package body Glib.XML is
       Child.Parent := N;
    end Add_Child;
 
-   --------------
-   -- Get_Node --
-   --------------
-
-   function Get_Node (Buf : String; Index : access Natural) return Node_Ptr is
-      N : constant Node_Ptr := new Node;
-      Q : Node_Ptr;
-      S : String_Ptr;
-      Empty_Node : Boolean;
-      Last_Child : Node_Ptr;
-
-   begin
-      pragma Assert (Buf (Index.all) = '<');
-
-      Index.all := Index.all + 1;
-      Get_Buf (Buf, Index.all, '>', N.Tag);
-
-      --  Check to see whether it is a comment, !DOCTYPE, or the like:
-
-      if N.Tag (N.Tag'First) = '!' then
-         return Get_Node (Buf, Index);
-      else
-         --  Here we have to deal with the attributes of the form
-         --  <tag attrib='xyyzy'>
-
-         Extract_Attrib (N.Tag, N.Attributes, Empty_Node);
-
-         --  it is possible to have a child-less node that has the form
-         --  <tag /> or <tag attrib='xyyzy'/>
-
-         if Empty_Node then
-            N.Value := new String'("");
-         else
-            if Buf (Index.all) = '<' then
-               if Buf (Index.all + 1) = '/' then
-                  --  No value contained on this node
-
-                  N.Value := new String'("");
-                  Index.all := Index.all + 1;
-
-               else
-                  --  Parse the children
-
-                  Add_Child (N, Get_Node (Buf, Index));
-                  Last_Child := N.Child;
-                  pragma Assert (Buf (Index.all) = '<');
-
-                  while Buf (Index.all + 1) /= '/' loop
-                     Q := Last_Child;
-                     Q.Next := Get_Node (Buf, Index);
-                     Q.Next.Parent := N;
-                     Last_Child := Q.Next;
-                     pragma Assert (Buf (Index.all) = '<');
-                  end loop;
-
-                  Index.all := Index.all + 1;
-               end if;
-
-            else
-               --  Get the value of this node
-
-               Get_Buf (Buf, Index.all, '<', N.Value);
-            end if;
-
-            pragma Assert (Buf (Index.all) = '/');
-            Index.all := Index.all + 1;
-            Get_Buf (Buf, Index.all, '>', S);
-            pragma Assert (N.Tag.all = S.all);
-            Free (S);
-         end if;
-
-         return N;
-      end if;
-   exception
-      when others =>
-         return null;
-   end Get_Node;
-
    -------------
    -- Protect --
    -------------
@@ -804,144 +707,744 @@ package body Glib.XML is
       Success := True;
    end Print;
 
-   -----------
-   -- Parse --
-   -----------
+   ----------------
+   -- New_String --
+   ----------------
 
-   function Parse (File : String) return Node_Ptr is
+   function New_String (S : String) return String_Ptr is
+      Result : constant String_Ptr := new String (1 .. S'Length);
+   begin
+      Result.all := S;
+      return Result;
+   end New_String;
 
-      function Read_File (The_File : String) return String_Ptr;
-      --  Return the contents of an entire file.
-      --  If the file cannot be found, return null.
-      --  The caller is responsible for freeing the returned memory.
+   ----------
+   -- Stop --
+   ----------
 
-      ---------------
-      -- Read_File --
-      ---------------
+   procedure Stop (Self : in out XML_Handler'Class) is
+   begin
+      Self.Stopped := True;
+   end Stop;
 
-      function Read_File (The_File : String) return String_Ptr is
-         FD     : Integer;
-         Buffer : String_Ptr;
-         Length : Integer;
-         pragma Warnings (Off, Length);
+   ------------------
+   -- Get_Encoding --
+   ------------------
+
+   function Get_Encoding (Declaration : String) return String is
+      Encoding : Natural := Index (Declaration, "encoding");
+      Quote    : Natural;
+   begin
+      if Encoding = 0 then
+         return "";
+      end if;
 
+      while Encoding <= Declaration'Last
+        and then Declaration (Encoding) /= '"'
+        and then Declaration (Encoding) /= '''
+      loop
+         Encoding := Encoding + 1;
+      end loop;
+
+      if Encoding >= Declaration'Last then
+         return "";
+      end if;
+
+      Quote := Index
+        (Declaration (Encoding + 1 .. Declaration'Last),
+         (1 => Declaration (Encoding)));
+
+      if Quote = 0
+        or else To_Upper (Declaration (Encoding + 1 .. Quote - 1)) = "UTF-8"
+        or else To_Upper (Declaration (Encoding + 1 .. Quote - 1)) = "UTF8"
+      then
+         return "";
+      end if;
+
+      return Declaration (Encoding + 1 .. Quote - 1);
+   end Get_Encoding;
+
+   --------------------
+   -- Next_Attribute --
+   --------------------
+
+   procedure Next_Attribute
+     (Attributes  : String;
+      Index       : in out Natural;
+      Key_First   : out Natural;
+      Key_Last    : out Natural;
+      Value_First : out Natural;
+      Value_Last  : out Natural)
+   is
+      procedure Skip;
+      --  Skip blanks in Attributes
+
+      ----------
+      -- Skip --
+      ----------
+
+      procedure Skip is
       begin
-         FD := Open_Read (The_File & ASCII.NUL);
+         while Index <= Attributes'Last
+           and then Is_Blank (Attributes (Index))
+         loop
+            Index := Index + 1;
+         end loop;
+      end Skip;
 
-         if FD < 0 then
-            return null;
+   begin
+      Key_Last    := 0;
+      Value_First := 0;
+      Value_Last  := 0;
+
+      loop
+         Key_First := 0;
+         Skip;
+         if Index > Attributes'Last then
+            return;
          end if;
 
-         Length := Integer (File_Length (FD));
-         Buffer := new String (1 .. Length);
-         Length := Read (FD, Buffer.all'Address, Length);
-         Close (FD);
-         return Buffer;
-      end Read_File;
+         Key_First := Index;
+         while Index <= Attributes'Last
+           and then Attributes (Index) /= '='
+           and then not Is_Blank (Attributes (Index))
+         loop
+            Index := Index + 1;
+         end loop;
+         Key_Last := Index - 1;
 
-      Buf    : String_Ptr;
-      Result : Node_Ptr;
+         Skip;
+         if Index <= Attributes'Last and then Attributes (Index) = '=' then
+            Index := Index + 1;
+            Skip;
+            exit when Index <= Attributes'Last;
+         end if;
 
-   begin
-      Buf := Read_File (File);
+         --  A key with no value: ignore it, and look at the next word
+      end loop;
 
-      if Buf = null then
-         return null;
+      --  Values are normally quoted, but for compatibility with older
+      --  versions accept a value that extends up to the next blank.
+
+      if Attributes (Index) /= '"' and then Attributes (Index) /= ''' then
+         Value_First := Index;
+         while Index <= Attributes'Last
+           and then not Is_Blank (Attributes (Index))
+         loop
+            Index := Index + 1;
+         end loop;
+         Value_Last := Index - 1;
+         return;
       end if;
 
-      Result := Parse_Buffer (Buf.all);
-      Free (Buf);
-      return Result;
-   end Parse;
+      Value_First := Index + 1;
+      Value_Last := Ada.Strings.Fixed.Index
+        (Attributes (Value_First .. Attributes'Last),
+         (1 => Attributes (Index)));
 
-   ------------------
-   -- Parse_Buffer --
-   ------------------
+      if Value_Last = 0 then
+         --  No closing quote: ignore the attribute, which extends to the
+         --  end of Attributes.
+         Key_First := 0;
+         Index     := Attributes'Last + 1;
+         return;
+      end if;
 
-   function Parse_Buffer (Buffer : UTF8_String) return Node_Ptr is
-      Index       : aliased Natural := 2;
-      XML_Version : String_Ptr;
-      Encoding    : Integer;
-      Encoding_Last : Integer;
-      Result        : Node_Ptr;
-   begin
-      Get_Buf (Buffer, Index, '>', XML_Version);
-      if XML_Version = null then
-         return null;
-      else
-         --  Check the encoding specified for that file
-         Encoding := Ada.Strings.Fixed.Index (XML_Version.all, "encoding");
+      Index := Value_Last + 1;
+      Value_Last := Value_Last - 1;
+   end Next_Attribute;
 
-         if Encoding /= 0 then
-            while Encoding <= XML_Version'Last
-              and then XML_Version (Encoding) /= '"'
-            loop
-               Encoding := Encoding + 1;
-            end loop;
+   ----------
+   -- Scan --
+   ----------
 
-            Encoding := Encoding + 1;
-            Encoding_Last := Encoding + 1;
+   procedure Scan
+     (Self   : in out XML_Handler'Class;
+      State  : in out Scan_State;
+      Input  : String;
+      At_EOF : Boolean;
+      First  : in out Natural)
+   is
+      function Looking_At (S : String) return Boolean
+        is (First + S'Length - 1 <= Input'Last
+            and then Input (First .. First + S'Length - 1) = S);
+      --  Whether Input starts with S at First
+
+      function Search
+        (Terminator : String;
+         Offset     : Natural;
+         Quoted     : Boolean := False) return Natural;
+      --  Return the index of the first occurrence of Terminator after
+      --  First + Offset. If Quoted is True, occurrences within quotes are
+      --  ignored.
+      --  Return 0 if it is not found and more input is expected, or raise
+      --  Parse_Error if At_EOF.
+
+      function Decode (S : String) return String;
+      --  Convert S to utf8
+
+      procedure Start_Element (Tag_End : Natural);
+      --  Process the opening tag between First and Tag_End (the index of
+      --  the closing '>').
+
+      procedure End_Element (Tag_End : Natural);
+      --  Process the closing tag between First and Tag_End
+
+      ------------
+      -- Search --
+      ------------
+
+      function Search
+        (Terminator : String;
+         Offset     : Natural;
+         Quoted     : Boolean := False) return Natural
+      is
+         Quote  : Character := ASCII.NUL;
+         Result : Natural := 0;
+      begin
+         if not Quoted then
+            Result := Index (Input (First + Offset .. Input'Last), Terminator);
 
-            while Encoding_Last <= XML_Version'Last
-              and then XML_Version (Encoding_Last) /= '"'
-            loop
-               Encoding_Last := Encoding_Last + 1;
+         else
+            for J in First + Offset .. Input'Last loop
+               if Quote /= ASCII.NUL then
+                  if Input (J) = Quote then
+                     Quote := ASCII.NUL;
+                  end if;
+
+               elsif Input (J) = '"' or else Input (J) = ''' then
+                  Quote := Input (J);
+
+               elsif Input (J) = Terminator (Terminator'First)
+                 and then J + Terminator'Length - 1 <= Input'Last
+                 and then Input (J .. J + Terminator'Length - 1) = Terminator
+               then
+                  Result := J;
+                  exit;
+               end if;
             end loop;
+         end if;
 
-            if Encoding_Last <= XML_Version'Last then
-               declare
-                  Error       : aliased GError;
-                  Utf8_Buffer : constant String := Glib.Convert.Convert
-                    (Buffer,
-                     To_Codeset => "UTF-8",
-                     From_Codeset =>
-                       XML_Version (Encoding .. Encoding_Last - 1),
-                     Error => Error'Unchecked_Access);
-               begin
-                  if Utf8_Buffer /= "" then
-                     Result := Get_Node (Utf8_Buffer, Index'Unchecked_Access);
-                  else
-                     Glib.Messages.Log
-                       ("Glib", Log_Level_Warning, Get_Message (Error));
-                     Error_Free (Error);
-                  end if;
-               end;
-            else
-               Result := Get_Node (Buffer, Index'Unchecked_Access);
-            end if;
-         else
-            Result := Get_Node (Buffer, Index'Unchecked_Access);
+         if Result = 0 and then At_EOF then
+            raise Parse_Error;
          end if;
 
-         Free (XML_Version);
          return Result;
-      end if;
-   end Parse_Buffer;
-
-   --------------
-   -- Find_Tag --
-   --------------
+      end Search;
+
+      ------------
+      -- Decode --
+      ------------
+
+      function Decode (S : String) return String is
+         Error : aliased GError;
+         Utf8  : constant String := Glib.Convert.Convert
+           (S,
+            To_Codeset   => "UTF-8",
+            From_Codeset => State.Codeset.all,
+            Error        => Error'Unchecked_Access);
+      begin
+         if Error /= null then
+            Glib.Messages.Log
+              ("Glib", Log_Level_Warning, Get_Message (Error));
+            Error_Free (Error);
+            raise Parse_Error;
+         end if;
 
-   function Find_Tag (N : Node_Ptr; Tag : UTF8_String) return Node_Ptr is
-      P : Node_Ptr := N;
+         return Utf8;
+      end Decode;
 
-   begin
-      while P /= null loop
-         if P.Tag.all = Tag then
-            return P;
-         end if;
+      -------------------
+      -- Start_Element --
+      -------------------
 
-         P := P.Next;
-      end loop;
+      procedure Start_Element (Tag_End : Natural) is
+         Empty      : constant Boolean := Input (Tag_End - 1) = '/';
+         Name_First : constant Natural := First + 1;
+         Name_Last  : Natural := Name_First;
+         Tag_Last   : Natural := Tag_End - 1;
+         Attr       : Natural;
 
-      return null;
-   end Find_Tag;
+         procedure Report (Name, Attributes : String);
+         --  Report the tag to Self
 
-   -----------------------------
-   -- Find_Tag_With_Attribute --
-   -----------------------------
+         ------------
+         -- Report --
+         ------------
 
-   function Find_Tag_With_Attribute
+         procedure Report (Name, Attributes : String) is
+            Index                   : Natural := Attributes'First;
+            Key_First, Key_Last     : Natural;
+            Value_First, Value_Last : Natural;
+         begin
+            Self.Start_Tag (Name, Attributes);
+
+            if not Self.Stopped and then Self.Decode_Attributes then
+               loop
+                  Next_Attribute
+                    (Attributes, Index,
+                     Key_First, Key_Last, Value_First, Value_Last);
+                  exit when Key_First = 0;
+
+                  Self.Attribute
+                    (Attributes (Key_First .. Key_Last),
+                     Translate (Attributes (Value_First .. Value_Last)));
+                  exit when Self.Stopped;
+               end loop;
+            end if;
+
+            if not Empty then
+               State.Depth := State.Depth + 1;
+            elsif not Self.Stopped then
+               Self.End_Tag (Name);
+            end if;
+         end Report;
+
+      begin
+         if Empty then
+            Tag_Last := Tag_End - 2;
+         end if;
+
+         while Name_Last <= Tag_Last
+           and then not Is_Blank (Input (Name_Last))
+         loop
+            Name_Last := Name_Last + 1;
+         end loop;
+
+         if Name_Last = Name_First then
+            raise Parse_Error;
+         end if;
+
+         Attr := Name_Last;
+         while Attr <= Tag_Last and then Is_Blank (Input (Attr)) loop
+            Attr := Attr + 1;
+         end loop;
+
+         First := Tag_End + 1;
+
+         if State.Raw or else State.Codeset = null then
+            Report (Input (Name_First .. Name_Last - 1),
+                    Input (Attr .. Tag_Last));
+         else
+            Report (Decode (Input (Name_First .. Name_Last - 1)),
+                    Decode (Input (Attr .. Tag_Last)));
+         end if;
+      end Start_Element;
+
+      -----------------
+      -- End_Element --
+      -----------------
+
+      procedure End_Element (Tag_End : Natural) is
+         Name_First : constant Natural := First + 2;
+         Name_Last  : Natural := Tag_End - 1;
+      begin
+         if State.Depth = 0 then
+            raise Parse_Error;
+         end if;
+
+         while Name_Last >= Name_First
+           and then Is_Blank (Input (Name_Last))
+         loop
+            Name_Last := Name_Last - 1;
+         end loop;
+
+         State.Depth := State.Depth - 1;
+         First := Tag_End + 1;
+
+         if State.Raw or else State.Codeset = null then
+            Self.End_Tag (Input (Name_First .. Name_Last));
+         else
+            Self.End_Tag (Decode (Input (Name_First .. Name_Last)));
+         end if;
+      end End_Element;
+
+      Found : Natural;
+      --  The position of the end of the current tag or text
+
+   begin
+      loop
+         exit when Self.Stopped;
+
+         while First <= Input'Last and then Is_Blank (Input (First)) loop
+            First := First + 1;
+         end loop;
+
+         exit when First > Input'Last;
+
+         if Input (First) /= '<' then
+            Found := Index (Input (First .. Input'Last), "<");
+
+            if Found = 0 then
+               exit when not At_EOF;
+
+               --  Text after the root node is ignored
+
+               if State.Depth > 0 then
+                  raise Parse_Error;
+               end if;
+
+               First := Input'Last + 1;
+               exit;
+            end if;
+
+            if State.Depth = 0 then
+               null;
+            elsif State.Raw then
+               Self.Text (Input (First .. Found - 1));
+            elsif State.Codeset = null then
+               Self.Text (Translate (Input (First .. Found - 1)));
+            else
+               Self.Text (Translate (Decode (Input (First .. Found - 1))));
+            end if;
+
+            First := Found;
+
+         else
+            --  Wait until there is enough input to recognize the markup
+
+            exit when not At_EOF and then First + 8 > Input'Last;
+
+            if Looking_At ("</") then
+               Found := Search (">", 2);
+               exit when Found = 0;
+               End_Element (Found);
+
+            elsif Looking_At ("<!--") then
+               Found := Search ("-->", 4);
+               exit when Found = 0;
+               First := Found + 3;
+
+            elsif Looking_At ("<![CDATA[") then
+               Found := Search ("]]>", 9);
+               exit when Found = 0;
+
+               if State.Depth = 0 then
+                  null;
+               elsif State.Raw then
+                  Self.Text (Input (First .. Found + 2));
+               elsif Found = First + 9 then
+                  null;
+               elsif State.Codeset = null then
+                  Self.Text (Input (First + 9 .. Found - 1));
+               else
+                  Self.Text (Decode (Input (First + 9 .. Found - 1)));
+               end if;
+
+               First := Found + 3;
+
+            elsif Looking_At ("<!") or else Looking_At ("<?") then
+               Found := Search (">", 2, Quoted => True);
+               exit when Found = 0;
+
+               if not State.Raw
+                 and then Looking_At ("<?xml")
+                 and then Found > First + 5
+                 and then Is_Blank (Input (First + 5))
+               then
+                  Free (State.Codeset);
+
+                  declare
+                     Encoding : constant String :=
+                       Get_Encoding (Input (First + 5 .. Found - 1));
+                  begin
+                     if Encoding /= "" then
+                        State.Codeset := new String'(Encoding);
+                     end if;
+                  end;
+               end if;
+
+               First := Found + 1;
+
+            else
+               Found := Search (">", 1, Quoted => True);
+               exit when Found = 0;
+               Start_Element (Found);
+            end if;
+         end if;
+      end loop;
+   end Scan;
+
+   ------------------
+   -- Parse_Stream --
+   ------------------
+
+   procedure Parse_Stream
+     (Self       : in out XML_Handler'Class;
+      Fill       : not null access procedure
+        (Into : out String; Last : out Natural);
+      Chunk_Size : Positive;
+      Success    : out Boolean)
+   is
+      Buffer    : String_Ptr := new String (1 .. Chunk_Size);
+      First     : Natural := 1;
+      --  The first character of Buffer that has not been parsed yet
+
+      Last      : Natural := 0;
+      --  The last character read into Buffer
+
+      Read_Last : Natural;
+      At_EOF    : Boolean;
+      State     : Scan_State;
+      Tmp       : String_Ptr;
+
+   begin
+      Self.Stopped := False;
+
+      loop
+         --  Move the characters that have not been parsed yet to the
+         --  beginning of the buffer, and make it larger if a single tag or
+         --  text does not fit.
+
+         Buffer (1 .. Last - First + 1) := Buffer (First .. Last);
+         Last  := Last - First + 1;
+         First := 1;
+
+         if Last = Buffer'Last then
+            Tmp := new String (1 .. 2 * Buffer'Length);
+            Tmp (1 .. Last) := Buffer (1 .. Last);
+            Free (Buffer);
+            Buffer := Tmp;
+         end if;
+
+         Fill (Buffer (Last + 1 .. Buffer'Last), Read_Last);
+         At_EOF := Read_Last <= Last;
+         Last := Natural'Max (Last, Read_Last);
+
+         Scan (Self, State, Buffer (1 .. Last), At_EOF, First);
+         exit when At_EOF or else Self.Stopped;
+      end loop;
+
+      Success := State.Depth = 0 or else Self.Stopped;
+      Free (Buffer);
+      Free (State.Codeset);
+
+   exception
+      when Parse_Error =>
+         Success := False;
+         Free (Buffer);
+         Free (State.Codeset);
+
+      when others =>
+         Free (Buffer);
+         Free (State.Codeset);
+         raise;
+   end Parse_Stream;
+
+   -----------
+   -- Parse --
+   -----------
+
+   procedure Parse
+     (Self       : in out XML_Handler'Class;
+      File       : String;
+      Success    : out Boolean;
+      Chunk_Size : Positive := Default_Chunk_Size)
+   is
+      FD : constant Integer := Open_Read (File & ASCII.NUL);
+
+      procedure Fill (Into : out String; Last : out Natural);
+      --  Read the next chunk of the file
+
+      ----------
+      -- Fill --
+      ----------
+
+      procedure Fill (Into : out String; Last : out Natural) is
+         Count : constant Integer := Read (FD, Into'Address, Into'Length);
+      begin
+         Last := Into'First + Integer'Max (Count, 0) - 1;
+      end Fill;
+
+   begin
+      if FD < 0 then
+         Success := False;
+         return;
+      end if;
+
+      Parse_Stream (Self, Fill'Access, Chunk_Size, Success);
+      Close (FD);
+
+   exception
+      when others =>
+         Close (FD);
+         raise;
+   end Parse;
+
+   ------------------
+   -- Parse_Buffer --
+   ------------------
+
+   procedure Parse_Buffer
+     (Self       : in out XML_Handler'Class;
+      Buffer     : UTF8_String;
+      Success    : out Boolean;
+      Chunk_Size : Positive := Default_Chunk_Size)
+   is
+      Next : Natural := Buffer'First;
+      --  The first character of Buffer not passed to the parser yet
+
+      procedure Fill (Into : out String; Last : out Natural);
+      --  Copy the next chunk of Buffer
+
+      ----------
+      -- Fill --
+      ----------
+
+      procedure Fill (Into : out String; Last : out Natural) is
+         Count : constant Natural :=
+           Integer'Max (0, Integer'Min (Into'Length, Buffer'Last - Next + 1));
+      begin
+         Into (Into'First .. Into'First + Count - 1) :=
+           Buffer (Next .. Next + Count - 1);
+         Next := Next + Count;
+         Last := Into'First + Count - 1;
+      end Fill;
+
+   begin
+      Parse_Stream (Self, Fill'Access, Chunk_Size, Success);
+   end Parse_Buffer;
+
+   ---------------
+   -- Start_Tag --
+   ---------------
+
+   overriding procedure Start_Tag
+     (Self       : in out Tree_Builder;
+      Tag        : UTF8_String;
+      Attributes : UTF8_String)
+   is
+      N : constant Node_Ptr := new Node;
+   begin
+      N.Tag := New_String (Tag);
+
+      if Attributes /= "" then
+         N.Attributes := New_String (Attributes);
+      end if;
+
+      N.Parent := Self.Current;
+
+      if Self.Current = null then
+         Self.Root := N;
+      elsif Self.Last = null then
+         Self.Current.Child := N;
+      else
+         Self.Last.Next := N;
+      end if;
+
+      Self.Current := N;
+      Self.Last := null;
+   end Start_Tag;
+
+   ----------
+   -- Text --
+   ----------
+
+   overriding procedure Text
+     (Self : in out Tree_Builder; Value : UTF8_String)
+   is
+      N : constant Node_Ptr := Self.Current;
+      S : String_Ptr;
+   begin
+      --  Text mixed with child nodes cannot be represented in the tree
+
+      if N.Child = null then
+         if N.Value = null then
+            N.Value := New_String (Value);
+         else
+            S := new String'(N.Value.all & Value);
+            Free (N.Value);
+            N.Value := S;
+         end if;
+      end if;
+   end Text;
+
+   -------------
+   -- End_Tag --
+   -------------
+
+   overriding procedure End_Tag
+     (Self : in out Tree_Builder; Tag : UTF8_String)
+   is
+      pragma Unreferenced (Tag);
+      N : constant Node_Ptr := Self.Current;
+   begin
+      if N.Child = null and then N.Value = null then
+         N.Value := new String'("");
+      end if;
+
+      Self.Last := N;
+      Self.Current := N.Parent;
+
+      --  Only the first node of the document is returned
+
+      if Self.Current = null then
+         Stop (Self);
+      end if;
+   end End_Tag;
+
+   ------------
+   -- Result --
+   ------------
+
+   function Result
+     (Self : in out Tree_Builder; Success : Boolean) return Node_Ptr is
+   begin
+      if not Success then
+         Free (Self.Root);
+      end if;
+
+      return Self.Root;
+   end Result;
+
+   -----------
+   -- Parse --
+   -----------
+
+   function Parse (File : String) return Node_Ptr is
+      Builder : Tree_Builder;
+      Success : Boolean;
+   begin
+      Parse (Builder, File, Success);
+      return Result (Builder, Success);
+   end Parse;
+
+   ------------------
+   -- Parse_Buffer --
+   ------------------
+
+   function Parse_Buffer (Buffer : UTF8_String) return Node_Ptr is
+      Builder : Tree_Builder;
+      Success : Boolean;
+   begin
+      Parse_Buffer (Builder, Buffer, Success);
+      return Result (Builder, Success);
+   end Parse_Buffer;
+
+   --------------
+   -- Find_Tag --
+   --------------
+
+   function Find_Tag (N : Node_Ptr; Tag : UTF8_String) return Node_Ptr is
+      P : Node_Ptr := N;
+
+   begin
+      while P /= null loop
+         if P.Tag.all = Tag then
+            return P;
+         end if;
+
+         P := P.Next;
+      end loop;
+
+      return null;
+   end Find_Tag;
+
+   -----------------------------
+   -- Find_Tag_With_Attribute --
+   -----------------------------
+
+   function Find_Tag_With_Attribute
      (N : Node_Ptr;
       Tag : UTF8_String;
       Key : UTF8_String;
@@ -1008,6 +1511,7 @@ package body Glib.XML is
          Free (N.Tag);
          Free (N.Attributes);
          Free (N.Value);
+         Unchecked_Free (N.Parsed_Attributes);
 
          if Free_Data /= null then
             Free_Data (N.Specific_Data);
@@ -1095,7 +1599,8 @@ package body Glib.XML is
                Parent => Parent,
                Child => null,
                Next => null,
-               Specific_Data => N.Specific_Data);
+               Specific_Data => N.Specific_Data,
+               Parsed_Attributes => null);
 
             --  Clone each child
 
@@ -1205,4 +1710,1057 @@ package body Glib.XML is
       return Count;
    end Children_Count;
 
+   -------------
+   -- Indexes --
+   -------------
+
+   package body Indexes is
+
+      package Tag_Maps is new Ada.Containers.Indefinite_Hashed_Maps
+        (Key_Type        => String,
+         Element_Type    => Positive,
+         Hash            => Ada.Strings.Hash,
+         Equivalent_Keys => "=");
+      --  Interns the tag names, so that they are stored only once
+
+      type Child_Key is record
+         Parent : Node_Ptr;
+         Tag    : Positive;
+      end record;
+
+      function Hash (N : Node_Ptr) return Ada.Containers.Hash_Type;
+      function Hash (Key : Child_Key) return Ada.Containers.Hash_Type;
+
+      package Node_Vectors is new Ada.Containers.Vectors (Positive, Node_Ptr);
+      type Node_List is access Node_Vectors.Vector;
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Node_Vectors.Vector, Node_List);
+
+      package Children_Maps is new Ada.Containers.Hashed_Maps
+        (Key_Type        => Child_Key,
+         Element_Type    => Node_List,
+         Hash            => Hash,
+         Equivalent_Keys => "=");
+
+      package Node_Sets is new Ada.Containers.Hashed_Sets
+        (Element_Type        => Node_Ptr,
+         Hash                => Hash,
+         Equivalent_Elements => "=");
+
+      type Index_Data is record
+         Tags     : Tag_Maps.Map;
+
+         Children : Children_Maps.Map;
+         --  The children of each indexed node, grouped by tag. The lists are
+         --  allocated separately so that they do not move when other nodes
+         --  are indexed.
+
+         Indexed  : Node_Sets.Set;
+         --  The nodes whose children have been indexed
+      end record;
+
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Index_Data, Index_Data_Access);
+
+      function Lookup
+        (Index : in out Tag_Index;
+         N     : Node_Ptr;
+         Tag   : UTF8_String) return Node_List;
+      --  Return the children of N whose tag is Tag, or null if there are
+      --  none. The children of N are indexed first if needed.
+
+      function Matches (N : Node_Ptr; Conditions : String) return Boolean;
+      --  Whether N satisfies the conditions on attributes that follow a tag
+      --  in a path, as in "[@name='x'][@id=""1""]".
+      --  Parse_Error is raised if Conditions is not well formed.
+
+      procedure Evaluate
+        (Index  : in out Tag_Index;
+         N      : Node_Ptr;
+         Path   : String;
+         Result : in out Node_Vectors.Vector;
+         Max    : Natural);
+      --  Append to Result the nodes that match Path, starting from the
+      --  children of N. This stops when Result contains Max nodes, unless
+      --  Max is 0.
+      --  Parse_Error is raised if Path is not well formed.
+
+      ----------
+      -- Hash --
+      ----------
+
+      function Hash (N : Node_Ptr) return Ada.Containers.Hash_Type is
+         use System.Storage_Elements;
+      begin
+         return Ada.Containers.Hash_Type
+           (To_Integer (N.all'Address)
+            mod Integer_Address (Ada.Containers.Hash_Type'Last));
+      end Hash;
+
+      ----------
+      -- Hash --
+      ----------
+
+      function Hash (Key : Child_Key) return Ada.Containers.Hash_Type is
+         use type Ada.Containers.Hash_Type;
+      begin
+         return Hash (Key.Parent) * 65_599
+           + Ada.Containers.Hash_Type (Key.Tag);
+      end Hash;
+
+      -----------
+      -- Clear --
+      -----------
+
+      procedure Clear (Index : in out Tag_Index) is
+         List : Node_List;
+      begin
+         if Index.Data /= null then
+            for Pos in Index.Data.Children.Iterate loop
+               List := Children_Maps.Element (Pos);
+               Unchecked_Free (List);
+            end loop;
+
+            Unchecked_Free (Index.Data);
+         end if;
+      end Clear;
+
+      ------------
+      -- Lookup --
+      ------------
+
+      function Lookup
+        (Index : in out Tag_Index;
+         N     : Node_Ptr;
+         Tag   : UTF8_String) return Node_List
+      is
+         Child    : Node_Ptr;
+         Id       : Tag_Maps.Cursor;
+         Pos      : Children_Maps.Cursor;
+         Inserted : Boolean;
+      begin
+         if Index.Data = null then
+            Index.Data := new Index_Data;
+         end if;
+
+         if not Index.Data.Indexed.Contains (N) then
+            Index.Data.Indexed.Insert (N);
+
+            Child := N.Child;
+            while Child /= null loop
+               if Child.Tag /= null then
+                  Index.Data.Tags.Insert
+                    (Key      => Child.Tag.all,
+                     New_Item => Natural (Index.Data.Tags.Length) + 1,
+                     Position => Id,
+                     Inserted => Inserted);
+                  Index.Data.Children.Insert
+                    (Key      => (N, Tag_Maps.Element (Id)),
+                     New_Item => null,
+                     Position => Pos,
+                     Inserted => Inserted);
+
+                  if Inserted then
+                     Index.Data.Children.Replace_Element
+                       (Pos, new Node_Vectors.Vector);
+                  end if;
+
+                  Children_Maps.Element (Pos).Append (Child);
+               end if;
+
+               Child := Child.Next;
+            end loop;
+         end if;
+
+         Id := Index.Data.Tags.Find (Tag);
+         if not Tag_Maps.Has_Element (Id) then
+            return null;
+         end if;
+
+         Pos := Index.Data.Children.Find ((N, Tag_Maps.Element (Id)));
+         if not Children_Maps.Has_Element (Pos) then
+            return null;
+         end if;
+
+         return Children_Maps.Element (Pos);
+      end Lookup;
+
+      -------------
+      -- Matches --
+      -------------
+
+      function Matches (N : Node_Ptr; Conditions : String) return Boolean is
+         First      : Natural := Conditions'First;
+         Name_Last  : Natural;
+         Value_Last : Natural;
+      begin
+         while First <= Conditions'Last loop
+            if First + 1 > Conditions'Last
+              or else Conditions (First .. First + 1) /= "[@"
+            then
+               raise Parse_Error;
+            end if;
+
+            Name_Last := Ada.Strings.Fixed.Index
+              (Conditions (First + 2 .. Conditions'Last), "=");
+
+            if Name_Last <= First + 2
+              or else Name_Last = Conditions'Last
+              or else (Conditions (Name_Last + 1) /= '"'
+                       and then Conditions (Name_Last + 1) /= ''')
+            then
+               raise Parse_Error;
+            end if;
+
+            Value_Last := Ada.Strings.Fixed.Index
+              (Conditions (Name_Last + 2 .. Conditions'Last),
+               (1 => Conditions (Name_Last + 1)));
+
+            if Value_Last = 0
+              or else Value_Last = Conditions'Last
+              or else Conditions (Value_Last + 1) /= ']'
+            then
+               raise Parse_Error;
+            end if;
+
+            declare
+               Value : String renames
+                 Conditions (Name_Last + 2 .. Value_Last - 1);
+            begin
+               --  The default value can never be equal to Value, so that a
+               --  missing attribute never matches.
+
+               if Get_Attribute
+                 (N, Conditions (First + 2 .. Name_Last - 1),
+                  Default => Value & ASCII.NUL) /= Value
+               then
+                  return False;
+               end if;
+            end;
+
+            First := Value_Last + 2;
+         end loop;
+
+         return True;
+      end Matches;
+
+      --------------
+      -- Evaluate --
+      --------------
+
+      procedure Evaluate
+        (Index  : in out Tag_Index;
+         N      : Node_Ptr;
+         Path   : String;
+         Result : in out Node_Vectors.Vector;
+         Max    : Natural)
+      is
+         Tag_Last  : Natural := Path'First - 1;
+         Step_Last : Natural;
+         Quote     : Character := ASCII.NUL;
+         List      : Node_List;
+      begin
+         while Tag_Last < Path'Last
+           and then Path (Tag_Last + 1) /= '['
+           and then Path (Tag_Last + 1) /= '/'
+         loop
+            Tag_Last := Tag_Last + 1;
+         end loop;
+
+         if Tag_Last < Path'First then
+            raise Parse_Error;
+         end if;
+
+         --  Find the end of the conditions, ignoring the '/' in values
+
+         Step_Last := Tag_Last;
+         while Step_Last < Path'Last loop
+            if Quote /= ASCII.NUL then
+               if Path (Step_Last + 1) = Quote then
+                  Quote := ASCII.NUL;
+               end if;
+            elsif Path (Step_Last + 1) = '"'
+              or else Path (Step_Last + 1) = '''
+            then
+               Quote := Path (Step_Last + 1);
+            elsif Path (Step_Last + 1) = '/' then
+               exit;
+            end if;
+
+            Step_Last := Step_Last + 1;
+         end loop;
+
+         List := Lookup (Index, N, Path (Path'First .. Tag_Last));
+         if List = null then
+            return;
+         end if;
+
+         for Child of List.all loop
+            if Matches (Child, Path (Tag_Last + 1 .. Step_Last)) then
+               if Step_Last = Path'Last then
+                  Result.Append (Child);
+               else
+                  Evaluate
+                    (Index, Child, Path (Step_Last + 2 .. Path'Last),
+                     Result, Max);
+               end if;
+
+               exit when Max /= 0 and then Natural (Result.Length) >= Max;
+            end if;
+         end loop;
+      end Evaluate;
+
+      ----------------
+      -- Find_Child --
+      ----------------
+
+      function Find_Child
+        (Index : in out Tag_Index;
+         N     : Node_Ptr;
+         Tag   : UTF8_String) return Node_Ptr
+      is
+         List : Node_List;
+      begin
+         if N = null then
+            return null;
+         end if;
+
+         List := Lookup (Index, N, Tag);
+         if List = null then
+            return null;
+         else
+            return List.First_Element;
+         end if;
+      end Find_Child;
+
+      ---------------
+      -- Get_Field --
+      ---------------
+
+      function Get_Field
+        (Index : in out Tag_Index;
+         N     : Node_Ptr;
+         Field : UTF8_String) return String_Ptr
+      is
+         Child : constant Node_Ptr := Find_Child (Index, N, Field);
+      begin
+         if Child = null then
+            return null;
+         else
+            return Child.Value;
+         end if;
+      end Get_Field;
+
+      -----------
+      -- Query --
+      -----------
+
+      function Query
+        (Index : in out Tag_Index;
+         N     : Node_Ptr;
+         Path  : UTF8_String) return Node_Array
+      is
+         Result : Node_Vectors.Vector;
+      begin
+         if N /= null then
+            Evaluate (Index, N, Path, Result, Max => 0);
+         end if;
+
+         declare
+            Nodes : Node_Array (1 .. Natural (Result.Length));
+         begin
+            for J in Nodes'Range loop
+               Nodes (J) := Result (J);
+            end loop;
+            return Nodes;
+         end;
+
+      exception
+         when Parse_Error =>
+            return (1 .. 0 => null);
+      end Query;
+
+      -----------------
+      -- Query_First --
+      -----------------
+
+      function Query_First
+        (Index : in out Tag_Index;
+         N     : Node_Ptr;
+         Path  : UTF8_String) return Node_Ptr
+      is
+         Result : Node_Vectors.Vector;
+      begin
+         if N /= null then
+            Evaluate (Index, N, Path, Result, Max => 1);
+         end if;
+
+         if Result.Is_Empty then
+            return null;
+         else
+            return Result.First_Element;
+         end if;
+
+      exception
+         when Parse_Error =>
+            return null;
+      end Query_First;
+
+   end Indexes;
+
+   ---------------
+   -- Documents --
+   ---------------
+
+   package body Documents is
+
+      function G_Mapped_File_New
+        (Filename : String;
+         Writable : Gboolean;
+         Error    : GError_Access) return System.Address;
+      pragma Import (C, G_Mapped_File_New, "g_mapped_file_new");
+
+      function G_Mapped_File_Get_Contents
+        (File : System.Address) return System.Address;
+      pragma Import
+        (C, G_Mapped_File_Get_Contents, "g_mapped_file_get_contents");
+
+      function G_Mapped_File_Get_Length (File : System.Address) return Gsize;
+      pragma Import (C, G_Mapped_File_Get_Length, "g_mapped_file_get_length");
+
+      procedure G_Mapped_File_Unref (File : System.Address);
+      pragma Import (C, G_Mapped_File_Unref, "g_mapped_file_unref");
+
+      type Element_Data is record
+         Tag_First, Tag_Last               : Natural;
+         Attributes_First, Attributes_Last : Natural;
+         Value_First, Value_Last           : Natural;
+         --  Slices of the input. Value_Last is 0 when the element contains no
+         --  text.
+
+         Translate_Value : Boolean;
+         --  Whether the value contains XML '&' characters, comments or CDATA
+         --  sections, and should be processed before it is returned.
+
+         Parent, Child, Next : Element;
+      end record;
+      type Element_Array is array (Element range <>) of Element_Data;
+
+      type Document_Data (Max_Elements : Element) is record
+         Mapped   : System.Address := System.Null_Address;
+         --  The GMappedFile, if the input is a file mapped in memory
+
+         Input    : String_Ptr;
+         --  The input, if it was read or converted in memory
+
+         Contents : System.Address;
+         Length   : Natural;
+         --  The location and size of the input
+
+         Count    : Element := No_Element;
+         Elements : Element_Array (1 .. Max_Elements);
+      end record;
+      --  The contents of a document. Max_Elements is computed from the input
+      --  before parsing, so that the elements never need to be moved.
+
+      procedure Unchecked_Free is new Unchecked_Deallocation
+        (Document_Data, Document_Data_Access);
+
+      procedure Create
+        (Doc            : in out Document;
+         Mapped         : System.Address;
+         Input          : String_Ptr;
+         Contents       : System.Address;
+         Length         : Natural;
+         Success        : out Boolean;
+         Check_Encoding : Boolean := True);
+      --  Parse the input at Contents into Doc, which takes ownership of
+      --  Mapped and Input.
+      --  If Check_Encoding is True and the declaration of the document
+      --  specifies an encoding other than utf8, the input is converted first.
+
+      function Slice
+        (Data : not null Document_Data_Access;
+         First, Last : Natural) return String;
+      --  Return a copy of a slice of the input
+
+      function Decode_Text (Raw : String) return String;
+      --  Translate the XML '&' characters in Raw, remove the comments and
+      --  the markup of CDATA sections.
+
+      type Document_Builder is new XML_Handler with record
+         Data    : Document_Data_Access;
+
+         Current : Element := No_Element;
+         --  The element whose contents are being parsed
+
+         Last    : Element := No_Element;
+         --  The last child of Current parsed so far
+      end record;
+      --  Fills the array of elements of a document
+
+      overriding procedure Start_Tag
+        (Self       : in out Document_Builder;
+         Tag        : UTF8_String;
+         Attributes : UTF8_String);
+      overriding function Decode_Attributes
+        (Self : Document_Builder) return Boolean is (False);
+      overriding procedure Text
+        (Self : in out Document_Builder; Value : UTF8_String);
+      overriding procedure End_Tag
+        (Self : in out Document_Builder; Tag : UTF8_String);
+
+      -----------
+      -- Slice --
+      -----------
+
+      function Slice
+        (Data : not null Document_Data_Access;
+         First, Last : Natural) return String
+      is
+         Input : String (1 .. Data.Length);
+         for Input'Address use Data.Contents;
+         pragma Import (Ada, Input);
+      begin
+         return Result : String (1 .. Last - First + 1) do
+            Result := Input (First .. Last);
+         end return;
+      end Slice;
+
+      -----------------
+      -- Decode_Text --
+      -----------------
+
+      function Decode_Text (Raw : String) return String is
+         Result     : String (1 .. Raw'Length);
+         Last       : Natural := 0;
+         J          : Natural := Raw'First;
+         Markup_End : Natural;
+      begin
+         while J <= Raw'Last loop
+            if Raw (J) /= '<' then
+               Markup_End := Index (Raw (J .. Raw'Last), "<");
+               if Markup_End = 0 then
+                  Markup_End := Raw'Last + 1;
+               end if;
+
+               declare
+                  S : constant String := Translate (Raw (J .. Markup_End - 1));
+               begin
+                  Result (Last + 1 .. Last + S'Length) := S;
+                  Last := Last + S'Length;
+               end;
+
+               J := Markup_End;
+
+            else
+               if J + 8 <= Raw'Last
+                 and then Raw (J .. J + 8) = "<![CDATA["
+               then
+                  Markup_End := Index (Raw (J .. Raw'Last), "]]>");
+                  Result (Last + 1 .. Last + Markup_End - J - 9) :=
+                    Raw (J + 9 .. Markup_End - 1);
+                  Last := Last + Markup_End - J - 9;
+                  J := Markup_End + 3;
+
+               elsif J + 3 <= Raw'Last and then Raw (J .. J + 3) = "<!--" then
+                  J := Index (Raw (J .. Raw'Last), "-->") + 3;
+
+               else
+                  J := Index (Raw (J .. Raw'Last), ">") + 1;
+               end if;
+
+               --  As done by the parser, blanks are skipped after the markup
+
+               while J <= Raw'Last and then Is_Blank (Raw (J)) loop
+                  J := J + 1;
+               end loop;
+            end if;
+         end loop;
+
+         return Result (1 .. Last);
+      end Decode_Text;
+
+      ---------------
+      -- Start_Tag --
+      ---------------
+
+      overriding procedure Start_Tag
+        (Self       : in out Document_Builder;
+         Tag        : UTF8_String;
+         Attributes : UTF8_String)
+      is
+         Data : Document_Data renames Self.Data.all;
+         E    : constant Element := Data.Count + 1;
+      begin
+         Data.Count := E;
+         Data.Elements (E) :=
+           (Tag_First        => Tag'First,
+            Tag_Last         => Tag'Last,
+            Attributes_First => Attributes'First,
+            Attributes_Last  => Attributes'Last,
+            Value_First      => 0,
+            Value_Last       => 0,
+            Translate_Value  => False,
+            Parent           => Self.Current,
+            Child            => No_Element,
+            Next             => No_Element);
+
+         if Self.Current = No_Element then
+            null;
+         elsif Self.Last = No_Element then
+            Data.Elements (Self.Current).Child := E;
+         else
+            Data.Elements (Self.Last).Next := E;
+         end if;
+
+         Self.Current := E;
+         Self.Last := No_Element;
+      end Start_Tag;
+
+      ----------
+      -- Text --
+      ----------
+
+      overriding procedure Text
+        (Self : in out Document_Builder; Value : UTF8_String)
+      is
+         E : Element_Data renames Self.Data.Elements (Self.Current);
+      begin
+         --  As for the tree of nodes, text after the first child is ignored
+
+         if E.Child /= No_Element then
+            return;
+
+         elsif E.Value_Last = 0 then
+            E.Value_First := Value'First;
+            E.Translate_Value :=
+              Value (Value'First) = '<' or else Index (Value, "&") /= 0;
+
+         else
+            --  The value now includes the markup between the two texts
+
+            E.Translate_Value := True;
+         end if;
+
+         E.Value_Last := Value'Last;
+      end Text;
+
+      -------------
+      -- End_Tag --
+      -------------
+
+      overriding procedure End_Tag
+        (Self : in out Document_Builder; Tag : UTF8_String)
+      is
+         pragma Unreferenced (Tag);
+      begin
+         Self.Last := Self.Current;
+         Self.Current := Self.Data.Elements (Self.Current).Parent;
+
+         if Self.Current = No_Element then
+            Stop (Self);
+         end if;
+      end End_Tag;
+
+      ------------
+      -- Create --
+      ------------
+
+      procedure Create
+        (Doc            : in out Document;
+         Mapped         : System.Address;
+         Input          : String_Ptr;
+         Contents       : System.Address;
+         Length         : Natural;
+         Success        : out Boolean;
+         Check_Encoding : Boolean := True)
+      is
+         Text  : String (1 .. Length);
+         for Text'Address use Contents;
+         pragma Import (Ada, Text);
+
+         BOM   : constant String :=
+           Character'Val (16#EF#) & Character'Val (16#BB#)
+           & Character'Val (16#BF#);
+         Start : Natural := Text'First;
+         Count : Element := No_Element;
+         Last  : Natural;
+
+         procedure Release;
+         --  Release Mapped and Input
+
+         -------------
+         -- Release --
+         -------------
+
+         procedure Release is
+            Tmp : String_Ptr := Input;
+         begin
+            if Mapped /= System.Null_Address then
+               G_Mapped_File_Unref (Mapped);
+            end if;
+            Free (Tmp);
+         end Release;
+
+      begin
+         --  Check the encoding specified in the declaration
+
+         if Length >= 3 and then Text (1 .. 3) = BOM then
+            Start := 4;
+         end if;
+
+         if Check_Encoding
+           and then Start + 4 <= Text'Last
+           and then Text (Start .. Start + 4) = "<?xml"
+         then
+            Last := Index (Text (Start .. Text'Last), "?>");
+
+            if Last /= 0 then
+               declare
+                  Encoding : constant String :=
+                    Get_Encoding (Text (Start + 5 .. Last - 1));
+                  Error    : aliased GError;
+                  Utf8     : String_Ptr;
+               begin
+                  if Encoding /= "" then
+                     Utf8 := new String'
+                       (Glib.Convert.Convert
+                          (Text,
+                           To_Codeset   => "UTF-8",
+                           From_Codeset => Encoding,
+                           Error        => Error'Unchecked_Access));
+                     Release;
+
+                     if Error /= null then
+                        Glib.Messages.Log
+                          ("Glib", Log_Level_Warning, Get_Message (Error));
+                        Error_Free (Error);
+                        Free (Utf8);
+                        Success := False;
+                     else
+                        Create
+                          (Doc, System.Null_Address, Utf8,
+                           Utf8.all'Address, Utf8'Length, Success,
+                           Check_Encoding => False);
+                     end if;
+
+                     return;
+                  end if;
+               end;
+            end if;
+         end if;
+
+         --  Each element starts with '<' followed by its name, which gives an
+         --  upper bound on the number of elements.
+
+         for J in Text'First .. Text'Last - 1 loop
+            if Text (J) = '<'
+              and then Text (J + 1) /= '/'
+              and then Text (J + 1) /= '!'
+              and then Text (J + 1) /= '?'
+            then
+               Count := Count + 1;
+            end if;
+         end loop;
+
+         Doc.Data := new Document_Data (Count);
+         Doc.Data.Mapped   := Mapped;
+         Doc.Data.Input    := Input;
+         Doc.Data.Contents := Contents;
+         Doc.Data.Length   := Length;
+
+         declare
+            Builder : Document_Builder;
+            State   : Scan_State := (Raw => True, others => <>);
+            First   : Natural := Text'First;
+         begin
+            Builder.Data := Doc.Data;
+            Scan (Builder, State, Text, At_EOF => True, First => First);
+            Success := State.Depth = 0 or else Builder.Stopped;
+         exception
+            when Parse_Error =>
+               Success := False;
+         end;
+
+         if not Success then
+            Free (Doc);
+         end if;
+      end Create;
+
+      ----------
+      -- Load --
+      ----------
+
+      procedure Load
+        (Doc      : in out Document;
+         File     : String;
+         Success  : out Boolean;
+         Map_File : Boolean := True)
+      is
+         Mapped : System.Address;
+         Input  : String_Ptr;
+         FD     : Integer;
+         Length : Integer;
+      begin
+         Free (Doc);
+
+         if Map_File then
+            Mapped := G_Mapped_File_New (File & ASCII.NUL, 0, null);
+
+            if Mapped = System.Null_Address then
+               Success := False;
+            else
+               Create
+                 (Doc, Mapped, null,
+                  Contents => G_Mapped_File_Get_Contents (Mapped),
+                  Length   => Natural (G_Mapped_File_Get_Length (Mapped)),
+                  Success  => Success);
+            end if;
+
+         else
+            FD := Open_Read (File & ASCII.NUL);
+
+            if FD < 0 then
+               Success := False;
+            else
+               Length := Integer (File_Length (FD));
+               Input := new String (1 .. Length);
+               Length := Read (FD, Input.all'Address, Length);
+               Close (FD);
+
+               Create
+                 (Doc, System.Null_Address, Input,
+                  Contents => Input.all'Address,
+                  Length   => Integer'Max (Length, 0),
+                  Success  => Success);
+            end if;
+         end if;
+      end Load;
+
+      -----------------
+      -- Load_Buffer --
+      -----------------
+
+      procedure Load_Buffer
+        (Doc     : in out Document;
+         Buffer  : UTF8_String;
+         Success : out Boolean)
+      is
+         Input : constant String_Ptr := new String (1 .. Buffer'Length);
+      begin
+         Free (Doc);
+         Input.all := Buffer;
+         Create
+           (Doc, System.Null_Address, Input,
+            Contents => Input.all'Address,
+            Length   => Input'Length,
+            Success  => Success);
+      end Load_Buffer;
+
+      ----------
+      -- Free --
+      ----------
+
+      procedure Free (Doc : in out Document) is
+      begin
+         if Doc.Data /= null then
+            if Doc.Data.Mapped /= System.Null_Address then
+               G_Mapped_File_Unref (Doc.Data.Mapped);
+            end if;
+
+            Free (Doc.Data.Input);
+            Unchecked_Free (Doc.Data);
+         end if;
+      end Free;
+
+      ----------
+      -- Root --
+      ----------
+
+      function Root (Doc : Document) return Element is
+      begin
+         if Doc.Data = null or else Doc.Data.Count = No_Element then
+            return No_Element;
+         else
+            return Doc.Data.Elements'First;
+         end if;
+      end Root;
+
+      ------------
+      -- Parent --
+      ------------
+
+      function Parent (Doc : Document; E : Element) return Element is
+      begin
+         return Doc.Data.Elements (E).Parent;
+      end Parent;
+
+      -----------------
+      -- First_Child --
+      -----------------
+
+      function First_Child (Doc : Document; E : Element) return Element is
+      begin
+         return Doc.Data.Elements (E).Child;
+      end First_Child;
+
+      ----------
+      -- Next --
+      ----------
+
+      function Next (Doc : Document; E : Element) return Element is
+      begin
+         return Doc.Data.Elements (E).Next;
+      end Next;
+
+      ---------
+      -- Tag --
+      ---------
+
+      function Tag (Doc : Document; E : Element) return UTF8_String is
+         Item : Element_Data renames Doc.Data.Elements (E);
+      begin
+         return Slice (Doc.Data, Item.Tag_First, Item.Tag_Last);
+      end Tag;
+
+      ----------------
+      -- Attributes --
+      ----------------
+
+      function Attributes (Doc : Document; E : Element) return UTF8_String is
+         Item : Element_Data renames Doc.Data.Elements (E);
+      begin
+         return Slice
+           (Doc.Data, Item.Attributes_First, Item.Attributes_Last);
+      end Attributes;
+
+      -----------
+      -- Value --
+      -----------
+
+      function Value (Doc : Document; E : Element) return UTF8_String is
+         Item : Element_Data renames Doc.Data.Elements (E);
+      begin
+         if Item.Value_Last = 0 then
+            return "";
+         elsif Item.Translate_Value then
+            return Decode_Text
+              (Slice (Doc.Data, Item.Value_First, Item.Value_Last));
+         else
+            return Slice (Doc.Data, Item.Value_First, Item.Value_Last);
+         end if;
+      end Value;
+
+      -------------------
+      -- Get_Attribute --
+      -------------------
+
+      function Get_Attribute
+        (Doc            : Document;
+         E              : Element;
+         Attribute_Name : UTF8_String;
+         Default        : UTF8_String := "") return UTF8_String
+      is
+         Attrs       : constant String := Attributes (Doc, E);
+         Index       : Natural := Attrs'First;
+         Key_First   : Natural;
+         Key_Last    : Natural;
+         Value_First : Natural;
+         Value_Last  : Natural;
+      begin
+         loop
+            Next_Attribute
+              (Attrs, Index, Key_First, Key_Last, Value_First, Value_Last);
+            exit when Key_First = 0;
+
+            if Attrs (Key_First .. Key_Last) = Attribute_Name then
+               return Translate (Attrs (Value_First .. Value_Last));
+            end if;
+         end loop;
+
+         return Default;
+      end Get_Attribute;
+
+      --------------
+      -- Find_Tag --
+      --------------
+
+      function Find_Tag
+        (Doc : Document; E : Element; Tag : UTF8_String) return Element
+      is
+         P : Element := E;
+      begin
+         while P /= No_Element loop
+            declare
+               Item : Element_Data renames Doc.Data.Elements (P);
+            begin
+               if Item.Tag_Last - Item.Tag_First + 1 = Tag'Length
+                 and then Slice (Doc.Data, Item.Tag_First, Item.Tag_Last) =
+                   Tag
+               then
+                  return P;
+               end if;
+
+               P := Item.Next;
+            end;
+         end loop;
+
+         return No_Element;
+      end Find_Tag;
+
+      -------------
+      -- To_Node --
+      -------------
+
+      function To_Node (Doc : Document; E : Element) return Node_Ptr is
+         function Copy (E : Element; Parent : Node_Ptr) return Node_Ptr;
+         --  Copy E and its children, as a child of Parent
+
+         ----------
+         -- Copy --
+         ----------
+
+         function Copy (E : Element; Parent : Node_Ptr) return Node_Ptr is
+            Item  : Element_Data renames Doc.Data.Elements (E);
+            N     : constant Node_Ptr := new Node;
+            Child : Element := Item.Child;
+            Last  : Node_Ptr;
+         begin
+            N.Tag := new String'(Tag (Doc, E));
+            N.Parent := Parent;
+
+            if Item.Attributes_Last >= Item.Attributes_First then
+               N.Attributes := new String'(Attributes (Doc, E));
+            end if;
+
+            if Child = No_Element or else Item.Value_Last /= 0 then
+               N.Value := new String'(Value (Doc, E));
+            end if;
+
+            while Child /= No_Element loop
+               if Last = null then
+                  N.Child := Copy (Child, N);
+                  Last := N.Child;
+               else
+                  Last.Next := Copy (Child, N);
+                  Last := Last.Next;
+               end if;
+
+               Child := Doc.Data.Elements (Child).Next;
+            end loop;
+
+            return N;
+         end Copy;
+
+      begin
+         if E = No_Element then
+            return null;
+         else
+            return Copy (E, null);
+         end if;
+      end To_Node;
+
+   end Documents;
+
 end Glib.XML;
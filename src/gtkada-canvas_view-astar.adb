@@ -24,12 +24,17 @@
 
 with Ada.Containers.Hashed_Maps;
 with Ada.Containers.Ordered_Multisets;
+with Ada.Unchecked_Deallocation;
 
 package body Gtkada.Canvas_View.Astar is
 
    Abort_Path : constant := 200;
    --  Maximum number of Coordinates to examine before an abort.
 
+   Max_Stack_Cells : constant := 2_500;
+   --  Find_Path_In_Grid allocates its arrays on the stack for grids with at
+   --  most that many points. This covers the grids used for link routing.
+
    type Star_Coordinate is record
       P    : Coordinate;
       Gval : Integer;  --  How far we have already gone in the A* algorithm
@@ -219,6 +224,254 @@ package body Gtkada.Canvas_View.Astar is
       end if;
    end Find_Path;
 
+   -----------------------
+   -- Find_Path_In_Grid --
+   -----------------------
+
+   function Find_Path_In_Grid
+     (Self          : User_Data;
+      From, To      : Coordinate;
+      Parent        : Coordinate;
+      Width, Height : Positive;
+      Max_Points    : Natural := 0) return Coordinate_Array
+   is
+      type Cell_Info is record
+         Gval     : Integer := Integer'Last;
+         --  How far we have already gone in the A* algorithm
+
+         Fval     : Integer := Integer'Last;
+         --  Gval plus the estimate of how far is left
+
+         Order    : Natural := 0;
+         --  When the cell was last added to the open set. This is used to
+         --  break ties, so that cells are examined in the same order as
+         --  Find_Path would.
+
+         Parent   : Natural := 0;
+         --  The cell we were coming from (0 for the starting point)
+
+         Heap_Pos : Natural := 0;
+         --  Position in the open set, or 0 if not there
+
+         Closed   : Boolean := False;
+         --  Whether the cell has already been examined
+      end record;
+
+      type Cell_Array is array (Positive range <>) of Cell_Info;
+      type Cell_Array_Access is access all Cell_Array;
+      type Index_Array is array (Positive range <>) of Positive;
+      type Index_Array_Access is access all Index_Array;
+
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Cell_Array, Cell_Array_Access);
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Index_Array, Index_Array_Access);
+
+      On_Stack : constant Boolean := Width * Height <= Max_Stack_Cells;
+
+      Stack_Cells : aliased Cell_Array :=
+        (1 .. (if On_Stack then Width * Height else 0) => <>);
+      Stack_Heap  : aliased Index_Array :=
+        (1 .. (if On_Stack then Width * Height else 0) => 1);
+
+      Cells     : Cell_Array_Access;
+      Heap      : Index_Array_Access;  --  the open set
+      Heap_Last : Natural := 0;
+      Order     : Natural := 0;
+      Examined  : Natural := 0;
+
+      procedure Free;
+      --  Free Cells and Heap, unless they are on the stack
+
+      function In_Grid (P : Coordinate) return Boolean
+        is (P.X in 1 .. Width and then P.Y in 1 .. Height);
+      function Index (P : Coordinate) return Positive
+        is ((P.Y - 1) * Width + P.X);
+      function Coord (Index : Positive) return Coordinate
+        is (((Index - 1) mod Width + 1, (Index - 1) / Width + 1));
+      --  Conversion between coordinates and indexes in Cells
+
+      function Less (C1, C2 : Positive) return Boolean
+        is (Cells (C1).Fval < Cells (C2).Fval
+            or else (Cells (C1).Fval = Cells (C2).Fval
+                     and then Cells (C1).Order < Cells (C2).Order));
+      --  Whether cell C1 should be examined before cell C2
+
+      procedure Swap (Pos1, Pos2 : Positive);
+      procedure Sift_Up (Pos : Positive);
+      procedure Sift_Down (Pos : Positive);
+      --  Maintain the heap property of the open set
+
+      procedure Free is
+      begin
+         if not On_Stack then
+            Unchecked_Free (Cells);
+            Unchecked_Free (Heap);
+         end if;
+      end Free;
+
+      procedure Swap (Pos1, Pos2 : Positive) is
+         Tmp : constant Positive := Heap (Pos1);
+      begin
+         Heap (Pos1) := Heap (Pos2);
+         Heap (Pos2) := Tmp;
+         Cells (Heap (Pos1)).Heap_Pos := Pos1;
+         Cells (Heap (Pos2)).Heap_Pos := Pos2;
+      end Swap;
+
+      procedure Sift_Up (Pos : Positive) is
+         P : Positive := Pos;
+      begin
+         while P > 1 and then Less (Heap (P), Heap (P / 2)) loop
+            Swap (P, P / 2);
+            P := P / 2;
+         end loop;
+      end Sift_Up;
+
+      procedure Sift_Down (Pos : Positive) is
+         P     : Positive := Pos;
+         Child : Positive;
+      begin
+         loop
+            Child := 2 * P;
+            exit when Child > Heap_Last;
+
+            if Child < Heap_Last
+              and then Less (Heap (Child + 1), Heap (Child))
+            then
+               Child := Child + 1;
+            end if;
+
+            exit when not Less (Heap (Child), Heap (P));
+            Swap (P, Child);
+            P := Child;
+         end loop;
+      end Sift_Down;
+
+      Start, Target, Current, Next_Cell : Positive;
+      Current_P, Previous, Next : Coordinate;
+      Cost  : Integer;
+      Count : Natural := 0;
+
+   begin
+      if not In_Grid (From) or else not In_Grid (To) or else From = To then
+         return (From, To);
+      end if;
+
+      if On_Stack then
+         Cells := Stack_Cells'Unchecked_Access;
+         Heap  := Stack_Heap'Unchecked_Access;
+      else
+         Cells := new Cell_Array (1 .. Width * Height);
+         Heap  := new Index_Array (1 .. Width * Height);
+      end if;
+
+      Start  := Index (From);
+      Target := Index (To);
+
+      Cells (Start).Gval := 0;
+      Cells (Start).Fval := Heuristic_Dist (Self, From, To);
+      Heap_Last := 1;
+      Heap (1) := Start;
+      Cells (Start).Heap_Pos := 1;
+
+      while Heap_Last > 0 loop
+         Current := Heap (1);
+         Swap (1, Heap_Last);
+         Heap_Last := Heap_Last - 1;
+         Sift_Down (1);
+
+         Cells (Current).Heap_Pos := 0;
+         Cells (Current).Closed := True;
+
+         Examined := Examined + 1;
+         if Max_Points /= 0 and then Examined >= Max_Points then
+            Free;
+            return (From, To);
+         end if;
+
+         exit when Current = Target;
+
+         Current_P := Coord (Current);
+         if Current = Start then
+            Previous := Parent;
+         else
+            Previous := Coord (Cells (Current).Parent);
+         end if;
+
+         for Num in 1 .. Positive'Last loop
+            Next := Next_Point (Self, Current_P, Num);
+            exit when Next = No_Coordinate;
+
+            if Next /= Previous and then In_Grid (Next) then
+               Next_Cell := Index (Next);
+
+               if not Cells (Next_Cell).Closed then
+                  Cost := Heuristic_Cost (Self, Previous, Current_P, Next);
+
+                  if Cost > 0
+                    and then Cells (Current).Gval + Cost
+                       < Cells (Next_Cell).Gval
+                  then
+                     Order := Order + 1;
+                     Cells (Next_Cell) :=
+                       (Gval     => Cells (Current).Gval + Cost,
+                        Fval     => Cells (Current).Gval + Cost
+                           + Heuristic_Dist (Self, Next, To),
+                        Order    => Order,
+                        Parent   => Current,
+                        Heap_Pos => Cells (Next_Cell).Heap_Pos,
+                        Closed   => False);
+
+                     --  Add to the open set, or move it up since its cost
+                     --  has decreased.
+
+                     if Cells (Next_Cell).Heap_Pos = 0 then
+                        Heap_Last := Heap_Last + 1;
+                        Heap (Heap_Last) := Next_Cell;
+                        Cells (Next_Cell).Heap_Pos := Heap_Last;
+                     end if;
+
+                     Sift_Up (Cells (Next_Cell).Heap_Pos);
+                  end if;
+               end if;
+            end if;
+         end loop;
+      end loop;
+
+      if Cells (Target).Closed then
+         Current := Target;
+         while Current /= Start loop
+            Current := Cells (Current).Parent;
+            Count := Count + 1;
+         end loop;
+      end if;
+
+      declare
+         Arr : Coordinate_Array (1 .. Count + 1);
+      begin
+         if Count = 0 then
+            Free;
+            return (From, To);
+         end if;
+
+         Arr (Arr'First) := From;
+         Current := Target;
+         for J in reverse Arr'First + 1 .. Arr'Last loop
+            Arr (J) := Coord (Current);
+            Current := Cells (Current).Parent;
+         end loop;
+
+         Free;
+         return Arr;
+      end;
+
+   exception
+      when others =>
+         Free;
+         raise;
+   end Find_Path_In_Grid;
+
    --------------------------
    -- Manhattan_Next_Point --
    --------------------------
@@ -0,0 +1,230 @@
+------------------------------------------------------------------------------
+--                  GtkAda - Ada95 binding for Gtk+/Gnome                   --
+--                                                                          --
+--                        Copyright (C) 2018, AdaCore                       --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+with Ada.Exceptions;             use Ada.Exceptions;
+with Ada.Unchecked_Deallocation;
+
+package body Gtkada.Canvas_View.Links.Parallel is
+
+   procedure Layout_Links
+     (Links   : Items_Lists.List;
+      Context : Draw_Context;
+      Tasks   : Positive);
+   --  Compute the layout of Links in parallel. This is used by the models
+   --  for which Set_Layout_Tasks was called.
+
+   ----------------------
+   -- Set_Layout_Tasks --
+   ----------------------
+
+   procedure Set_Layout_Tasks
+     (Self  : not null access Canvas_Model_Record'Class;
+      Count : Positive) is
+   begin
+      Self.Layout_Tasks := Count;
+
+      if Count > 1 then
+         Self.Parallel_Layout := Layout_Links'Access;
+      else
+         Self.Parallel_Layout := null;
+      end if;
+   end Set_Layout_Tasks;
+
+   ----------------------
+   -- Get_Layout_Tasks --
+   ----------------------
+
+   function Get_Layout_Tasks
+     (Self : not null access Canvas_Model_Record'Class) return Positive is
+   begin
+      return Self.Layout_Tasks;
+   end Get_Layout_Tasks;
+
+   ------------------
+   -- Layout_Links --
+   ------------------
+
+   procedure Layout_Links
+     (Links   : Items_Lists.List;
+      Context : Draw_Context;
+      Tasks   : Positive)
+   is
+      type Canvas_Link_Array_Access is access Canvas_Link_Array;
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Canvas_Link_Array, Canvas_Link_Array_Access);
+
+      Arr : Canvas_Link_Array_Access :=
+        new Canvas_Link_Array (1 .. Integer (Links.Length));
+      L   : Items_Lists.Cursor := Links.First;
+   begin
+      for J in Arr'Range loop
+         Arr (J) := Canvas_Link (Items_Lists.Element (L));
+         Items_Lists.Next (L);
+      end loop;
+
+      Compute_Layout_In_Parallel (Arr.all, Context, Tasks);
+      Unchecked_Free (Arr);
+
+   exception
+      when others =>
+         Unchecked_Free (Arr);
+         raise;
+   end Layout_Links;
+
+   --------------------------------
+   -- Compute_Layout_In_Parallel --
+   --------------------------------
+
+   procedure Compute_Layout_In_Parallel
+     (Links   : Canvas_Link_Array;
+      Context : Draw_Context;
+      Tasks   : Positive)
+   is
+      Chunk : constant := 64;
+      --  Number of links that a task reserves at once, to limit contention
+      --  on the dispatcher.
+
+      Computed : array (Links'Range) of Boolean := (others => False);
+      --  The links whose geometry was computed by Work. Each element is
+      --  only modified by the task that reserved the link.
+
+      procedure Free is new Ada.Unchecked_Deallocation
+        (Exception_Occurrence, Exception_Occurrence_Access);
+
+      protected Dispatcher is
+         procedure Next (First, Last : out Natural);
+         --  Reserve the next links to compute. Returns an empty range when
+         --  all links have been reserved, or a task has failed.
+
+         procedure Failed (E : Exception_Occurrence);
+         --  Report an exception in one of the tasks, and stop the others
+
+         function Get_Error return Exception_Occurrence_Access;
+         --  The first exception reported by Failed, if any
+      private
+         Current : Natural := Links'First;
+         Error   : Exception_Occurrence_Access;
+      end Dispatcher;
+
+      procedure Work;
+      --  Compute the geometry of links until there are none left
+
+      task type Worker;
+
+      ----------------
+      -- Dispatcher --
+      ----------------
+
+      protected body Dispatcher is
+         procedure Next (First, Last : out Natural) is
+         begin
+            First := Current;
+            Last := Natural'Min (Current + Chunk - 1, Links'Last);
+            Current := Last + 1;
+         end Next;
+
+         procedure Failed (E : Exception_Occurrence) is
+         begin
+            if Error = null then
+               Error := Save_Occurrence (E);
+            end if;
+            Current := Links'Last + 1;
+         end Failed;
+
+         function Get_Error return Exception_Occurrence_Access is
+         begin
+            return Error;
+         end Get_Error;
+      end Dispatcher;
+
+      ----------
+      -- Work --
+      ----------
+
+      procedure Work is
+         First, Last : Natural;
+      begin
+         loop
+            Dispatcher.Next (First, Last);
+            exit when First > Last;
+
+            for J in First .. Last loop
+               if Links (J).Points = null
+                 and then Is_Independent (Links (J))
+               then
+                  Compute_Geometry (Links (J));
+                  Computed (J) := True;
+               end if;
+            end loop;
+         end loop;
+
+      exception
+         when E : others =>
+            Dispatcher.Failed (E);
+      end Work;
+
+      ------------
+      -- Worker --
+      ------------
+
+      task body Worker is
+      begin
+         Work;
+      end Worker;
+
+      Error : Exception_Occurrence_Access;
+
+   begin
+      --  Geometry phase: the calling task takes its share of the work, so
+      --  that no task is created when Tasks is 1.
+
+      declare
+         Workers : array (2 .. Tasks) of Worker;
+         pragma Unreferenced (Workers);
+      begin
+         Work;
+      end;  --  wait for all workers to terminate
+
+      Error := Dispatcher.Get_Error;
+      if Error /= null then
+         declare
+            E : Exception_Occurrence;
+         begin
+            Save_Occurrence (E, Error.all);
+            Free (Error);
+            Reraise_Occurrence (E);
+         end;
+      end if;
+
+      --  Commit phase, in the calling task
+
+      for J in Links'Range loop
+         if Computed (J) then
+            Commit_Geometry (Links (J), Context);
+         elsif Links (J).Points = null then
+            Links (J).Refresh_Layout (Context);
+         end if;
+      end loop;
+   end Compute_Layout_In_Parallel;
+
+end Gtkada.Canvas_View.Links.Parallel;
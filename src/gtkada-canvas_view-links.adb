@@ -22,6 +22,7 @@
 --                                                                          --
 ------------------------------------------------------------------------------
 
+with Ada.Tags;                      use Ada.Tags;
 with Ada.Unchecked_Deallocation;
 with Cairo;                         use Cairo;
 with Gtkada.Canvas_View.Astar;      use Gtkada.Canvas_View.Astar;
@@ -69,13 +70,33 @@ package body Gtkada.Canvas_View.Links is
       Dim     : Anchors);
    --  Compute the position for the end labels and middle label for the link
 
+   Max_Obstacles : constant := 20;
+   --  Maximum number of items that a link tries to avoid. This bounds the
+   --  size of the grid used to route the link, and thus the cost of
+   --  computing its layout.
+
+   Max_Path_Points : constant := 200;
+   --  Maximum number of points that A* examines when there are no
+   --  obstacles, before it falls back to a direct link (as Find_Path did).
+   --  Such a grid only has 7x7 points, so this is just a safeguard.
+
+   type Obstacle_Array is array (1 .. Max_Obstacles) of Model_Rectangle;
+
    type Layout_Matrix is record
-      X, Y : Gdouble_Array (1 .. 7);
+      X, Y : Gdouble_Array (1 .. 7 + 2 * Max_Obstacles);
+      Last : Natural := 7;
       Dim  : Anchors;
+
+      Obstacles      : Obstacle_Array;
+      Last_Obstacle  : Natural := 0;
    end record;
    --  Mapping from integer to double: the double values indicate positions
    --  in the canvas itself. The integer coordinates are used for the A*
    --  algorithm, since we are working on a non-uniform grid.
+   --  Only the values in 1 .. Last are valid.
+   --  Obstacles are the items (other than the two ends of the link) that the
+   --  link should go around. Each of them adds two lines to the grid along
+   --  each axis, to go around it.
 
    function Manhattan_Dist
       (Self : Layout_Matrix; From, To : Coordinate) return Integer;
@@ -84,6 +105,11 @@ package body Gtkada.Canvas_View.Links is
    function Next_Point is new Manhattan_Next_Point (Layout_Matrix);
    --  Functions for the A* algorithm.
 
+   function Crosses_Obstacle
+      (Self : Layout_Matrix; From, To : Coordinate) return Boolean;
+   --  Whether the segment between the two (adjacent) points of the grid goes
+   --  through one of the obstacles.
+
    function Relative_To_Item
      (From : Model_Point; Wp : Item_Point_Array) return Model_Point;
    function Relative_To_Array
@@ -103,13 +129,21 @@ package body Gtkada.Canvas_View.Links is
    --  so that we can use Astar
 
    procedure Orthogonal_Waypoints
-     (Link       : not null access Canvas_Link_Record'Class;
-      Context    : Draw_Context;
-      Min_Margin : Gdouble;
-      Max_Margin : Gdouble);
+     (Link        : not null access Canvas_Link_Record'Class;
+      Context     : Draw_Context;
+      Min_Margin  : Gdouble;
+      Max_Margin  : Gdouble;
+      Avoid_Items : Boolean := False;
+      Labels      : Boolean := True);
    --  Min_Margin: we do not want lines to be displayed too close to an item,
    --  this is the minimal distance.
    --
+   --  Avoid_Items: whether to go around the other items of the model that
+   --  are near the two ends of the link.
+   --
+   --  Labels: whether to also compute the position of the labels. This is
+   --  the only part that needs a pango layout.
+   --
    --  Max_Margin: On the other hand, we do not want the link to be too far
    --  either, so that for instance if Item1 is linked to both Item2 and Item3,
    --  the two link will share the middle line even when the items are not
@@ -126,6 +160,21 @@ package body Gtkada.Canvas_View.Links is
    --  between Item1 and either Item2 or Item3, it would only be shared
    --  if Item2 and Item3 are at the same y coordinate.
 
+   procedure Straight_Waypoints
+     (Link : not null access Canvas_Link_Record'Class;
+      Dim  : Anchors);
+   procedure Arc_Waypoints
+     (Link   : not null access Canvas_Link_Record'Class;
+      Dim    : Anchors;
+      Offset : Gdouble);
+   --  Compute the points and bounding box of straight and arc links, but not
+   --  the position of their labels.
+
+   procedure Curve_From_Orthogonal
+     (Link : not null access Canvas_Link_Record'Class);
+   --  Transform the points computed by Orthogonal_Waypoints into the control
+   --  points of a bezier curve.
+
    --------------------
    -- Manhattan_Dist --
    --------------------
@@ -138,6 +187,31 @@ package body Gtkada.Canvas_View.Links is
       return abs (From.X - To.X) + abs (From.Y - To.Y);
    end Manhattan_Dist;
 
+   ----------------------
+   -- Crosses_Obstacle --
+   ----------------------
+
+   function Crosses_Obstacle
+      (Self : Layout_Matrix; From, To : Coordinate) return Boolean
+   is
+      --  Since the grid has lines on each side of the obstacles, a segment
+      --  between adjacent points crosses an obstacle only if its end or its
+      --  middle are inside it.
+
+      P : constant Model_Point := (Self.X (To.X), Self.Y (To.Y));
+      M : constant Model_Point :=
+        ((Self.X (From.X) + P.X) / 2.0, (Self.Y (From.Y) + P.Y) / 2.0);
+   begin
+      for O in 1 .. Self.Last_Obstacle loop
+         if Point_In_Rect (Self.Obstacles (O), P)
+           or else Point_In_Rect (Self.Obstacles (O), M)
+         then
+            return True;
+         end if;
+      end loop;
+      return False;
+   end Crosses_Obstacle;
+
    --------------------
    -- Manhattan_Cost --
    --------------------
@@ -146,8 +220,8 @@ package body Gtkada.Canvas_View.Links is
       (Self : Layout_Matrix; Parent, From, To : Coordinate)
       return Integer is
    begin
-      if To.X not in Self.X'Range
-        or else To.Y not in Self.Y'Range
+      if To.X not in 1 .. Self.Last
+        or else To.Y not in 1 .. Self.Last
 
         --  If the target is not a valid destination
         or else abs (Self.X (To.X) - Gdouble'Last) < 0.01
@@ -162,6 +236,11 @@ package body Gtkada.Canvas_View.Links is
       then
          return 1_000_000; --  very expensive, but not impossible if we have to
 
+      elsif Self.Last_Obstacle /= 0
+        and then Crosses_Obstacle (Self, From, To)
+      then
+         return 1_000_000;
+
       else
          --  A bend is costly
 
@@ -175,7 +254,7 @@ package body Gtkada.Canvas_View.Links is
       end if;
    end Manhattan_Cost;
 
-   function Astar_Find is new Find_Path
+   function Astar_Find is new Find_Path_In_Grid
      (User_Data      => Layout_Matrix,
       Heuristic_Cost => Manhattan_Cost,
       Next_Point     => Next_Point,
@@ -546,12 +625,14 @@ package body Gtkada.Canvas_View.Links is
    ----------------------------------------
 
    procedure Compute_Layout_For_Orthogonal_Link
-     (Link    : not null access Canvas_Link_Record'Class;
-      Context : Draw_Context)
+     (Link        : not null access Canvas_Link_Record'Class;
+      Context     : Draw_Context;
+      Avoid_Items : Boolean := False)
    is
    begin
       Orthogonal_Waypoints
-        (Link, Context, Min_Margin => 6.0, Max_Margin => 25.0);
+        (Link, Context, Min_Margin => 6.0, Max_Margin => 25.0,
+         Avoid_Items => Avoid_Items);
    end Compute_Layout_For_Orthogonal_Link;
 
    -------------------
@@ -614,10 +695,12 @@ package body Gtkada.Canvas_View.Links is
    --------------------------
 
    procedure Orthogonal_Waypoints
-     (Link       : not null access Canvas_Link_Record'Class;
-      Context    : Draw_Context;
-      Min_Margin : Gdouble;
-      Max_Margin : Gdouble)
+     (Link        : not null access Canvas_Link_Record'Class;
+      Context     : Draw_Context;
+      Min_Margin  : Gdouble;
+      Max_Margin  : Gdouble;
+      Avoid_Items : Boolean := False;
+      Labels      : Boolean := True)
    is
       Min_Space : constant Gdouble := Link.Style.Get_Line_Width * 3.0;
       --  Minimal space between two boxes to pass a link between them
@@ -706,6 +789,121 @@ package body Gtkada.Canvas_View.Links is
       Matrix : Layout_Matrix;
       Margin_From, Margin_To : Margins;
 
+      procedure Add_Obstacles;
+      --  Add to Matrix the items near the two ends of the link.
+      --  We only look in a window around the two ends, and keep only the
+      --  Max_Obstacles items nearest to the line between the two ends, so
+      --  that the cost remains bounded even in large models.
+
+      -------------------
+      -- Add_Obstacles --
+      -------------------
+
+      procedure Add_Obstacles is
+         From_Item : constant Abstract_Item := Link.From.Get_Toplevel_Item;
+         To_Item   : constant Abstract_Item := Link.To.Get_Toplevel_Item;
+         Window    : Model_Rectangle := Dim.From.Toplevel;
+
+         A : constant Model_Point :=
+           (Dim.From.Toplevel.X + Dim.From.Toplevel.Width / 2.0,
+            Dim.From.Toplevel.Y + Dim.From.Toplevel.Height / 2.0);
+         B : constant Model_Point :=
+           (Dim.To.Toplevel.X + Dim.To.Toplevel.Width / 2.0,
+            Dim.To.Toplevel.Y + Dim.To.Toplevel.Height / 2.0);
+
+         Dist     : array (1 .. Max_Obstacles) of Gdouble;
+         Farthest : Positive := 1;
+
+         function Distance (Box : Model_Rectangle) return Gdouble;
+         --  Squared distance between the center of Box and the segment
+         --  joining the centers of the two ends.
+
+         procedure On_Item (It : not null access Abstract_Item_Record'Class);
+
+         --------------
+         -- Distance --
+         --------------
+
+         function Distance (Box : Model_Rectangle) return Gdouble is
+            Len : constant Gdouble := (B.X - A.X) ** 2 + (B.Y - A.Y) ** 2;
+            C   : constant Model_Point :=
+              (Box.X + Box.Width / 2.0, Box.Y + Box.Height / 2.0);
+            T   : Gdouble := 0.0;
+         begin
+            if Len > 0.0 then
+               T := Gdouble'Max
+                 (0.0, Gdouble'Min
+                    (1.0,
+                     ((C.X - A.X) * (B.X - A.X) + (C.Y - A.Y) * (B.Y - A.Y))
+                     / Len));
+            end if;
+
+            return (C.X - A.X - T * (B.X - A.X)) ** 2
+              + (C.Y - A.Y - T * (B.Y - A.Y)) ** 2;
+         end Distance;
+
+         -------------
+         -- On_Item --
+         -------------
+
+         procedure On_Item
+           (It : not null access Abstract_Item_Record'Class)
+         is
+            Box : Model_Rectangle;
+            D   : Gdouble;
+         begin
+            if Abstract_Item (It) /= From_Item
+              and then Abstract_Item (It) /= To_Item
+            then
+               Box := It.Model_Bounding_Box;
+               D := Distance (Box);
+
+               if Matrix.Last_Obstacle < Max_Obstacles then
+                  Matrix.Last_Obstacle := Matrix.Last_Obstacle + 1;
+                  Matrix.Obstacles (Matrix.Last_Obstacle) := Box;
+                  Dist (Matrix.Last_Obstacle) := D;
+
+               elsif D < Dist (Farthest) then
+                  --  Replace the farthest obstacle found so far
+                  Matrix.Obstacles (Farthest) := Box;
+                  Dist (Farthest) := D;
+
+               else
+                  return;
+               end if;
+
+               for O in 1 .. Matrix.Last_Obstacle loop
+                  if Dist (O) > Dist (Farthest) then
+                     Farthest := O;
+                  end if;
+               end loop;
+            end if;
+         end On_Item;
+
+      begin
+         Union (Window, Dim.To.Toplevel);
+         Window :=
+           (Window.X - Max_Margin,
+            Window.Y - Max_Margin,
+            Window.Width + 2.0 * Max_Margin,
+            Window.Height + 2.0 * Max_Margin);
+
+         Context.Model.For_Each_Item
+           (On_Item'Access, Filter => Kind_Item, In_Area => Window);
+
+         for O in 1 .. Matrix.Last_Obstacle loop
+            declare
+               Box : Model_Rectangle renames Matrix.Obstacles (O);
+            begin
+               Matrix.X (Matrix.Last + 1) := Box.X - Min_Margin;
+               Matrix.X (Matrix.Last + 2) := Box.X + Box.Width + Min_Margin;
+               Matrix.Y (Matrix.Last + 1) := Box.Y - Min_Margin;
+               Matrix.Y (Matrix.Last + 2) := Box.Y + Box.Height + Min_Margin;
+               Matrix.Last := Matrix.Last + 2;
+            end;
+         end loop;
+      end Add_Obstacles;
+
    begin
       Margins_Between_Items
         (Dim.From.Toplevel, Dim.To.Toplevel, Margin_From, Margin_To);
@@ -751,7 +949,10 @@ package body Gtkada.Canvas_View.Links is
          end if;
 
          Link.Bounding_Box := Compute_Bounding_Box (Link.Points.all);
-         Compute_Labels (Link, Context, Dim);
+
+         if Labels then
+            Compute_Labels (Link, Context, Dim);
+         end if;
 
          return;
       end if;
@@ -786,18 +987,24 @@ package body Gtkada.Canvas_View.Links is
          M.Y := Gdouble'Last;  --  no valid horizontal line in between
       end if;
 
-      Matrix :=
-        (Dim => Dim,
-         X => ((FTX1 - Margin_From.Left,  From.X, FTX2 + Margin_From.Right,
-                TTX1 - Margin_To.Left,    To.X,   TTX2 + Margin_To.Right,
-                M.X)),
-         Y => ((FTY1 - Margin_From.Top,   From.Y, FTY2 + Margin_From.Bottom,
-                TTY1 - Margin_To.Top,     To.Y,   TTY2 + Margin_To.Bottom,
-                M.Y)));
-      Sort (Matrix.X);
-      Sort (Matrix.Y);
-
-      for J in Matrix.X'Range loop
+      Matrix.Dim := Dim;
+      Matrix.X (1 .. 7) :=
+        (FTX1 - Margin_From.Left,  From.X, FTX2 + Margin_From.Right,
+         TTX1 - Margin_To.Left,    To.X,   TTX2 + Margin_To.Right,
+         M.X);
+      Matrix.Y (1 .. 7) :=
+        (FTY1 - Margin_From.Top,   From.Y, FTY2 + Margin_From.Bottom,
+         TTY1 - Margin_To.Top,     To.Y,   TTY2 + Margin_To.Bottom,
+         M.Y);
+
+      if Avoid_Items and then Context.Model /= null then
+         Add_Obstacles;
+      end if;
+
+      Sort (Matrix.X (1 .. Matrix.Last));
+      Sort (Matrix.Y (1 .. Matrix.Last));
+
+      for J in 1 .. Matrix.Last loop
          if abs (Matrix.X (J) - P_From.X) < 0.01 then
             C1.X := J;
          end if;
@@ -825,7 +1032,12 @@ package body Gtkada.Canvas_View.Links is
 
       declare
          Path   : constant Coordinate_Array :=
-           Astar_Find (Matrix, C1, C2, Parent => C3);
+           Astar_Find
+             (Matrix, C1, C2, Parent => C3,
+              Width      => Matrix.Last,
+              Height     => Matrix.Last,
+              Max_Points =>
+                (if Matrix.Last_Obstacle = 0 then Max_Path_Points else 0));
          Points : Item_Point_Array (1 .. 4 + Path'Length);
          P      : Integer;
          Along_X : Boolean;
@@ -866,18 +1078,20 @@ package body Gtkada.Canvas_View.Links is
       end;
 
       Link.Bounding_Box := Compute_Bounding_Box (Link.Points.all);
-      Compute_Labels (Link, Context, Dim);
+
+      if Labels then
+         Compute_Labels (Link, Context, Dim);
+      end if;
    end Orthogonal_Waypoints;
 
-   --------------------------------------
-   -- Compute_Layout_For_Straight_Link --
-   --------------------------------------
+   ------------------------
+   -- Straight_Waypoints --
+   ------------------------
 
-   procedure Compute_Layout_For_Straight_Link
-     (Link    : not null access Canvas_Link_Record'Class;
-      Context : Draw_Context)
+   procedure Straight_Waypoints
+     (Link : not null access Canvas_Link_Record'Class;
+      Dim  : Anchors)
    is
-      Dim : constant Anchors := Compute_Anchors (Link);
       Tmp, Tmp2 : Item_Point;
       Pos : Item_Coordinate;
    begin
@@ -940,20 +1154,31 @@ package body Gtkada.Canvas_View.Links is
       end if;
 
       Link.Bounding_Box := Compute_Bounding_Box (Link.Points.all);
-      Compute_Labels (Link, Context, Dim);
-   end Compute_Layout_For_Straight_Link;
+   end Straight_Waypoints;
 
-   ---------------------------------
-   -- Compute_Layout_For_Arc_Link --
-   ---------------------------------
+   --------------------------------------
+   -- Compute_Layout_For_Straight_Link --
+   --------------------------------------
 
-   procedure Compute_Layout_For_Arc_Link
+   procedure Compute_Layout_For_Straight_Link
      (Link    : not null access Canvas_Link_Record'Class;
-      Context : Draw_Context;
-      Offset  : Gdouble := 10.0)
+      Context : Draw_Context)
    is
       Dim : constant Anchors := Compute_Anchors (Link);
+   begin
+      Straight_Waypoints (Link, Dim);
+      Compute_Labels (Link, Context, Dim);
+   end Compute_Layout_For_Straight_Link;
+
+   -------------------
+   -- Arc_Waypoints --
+   -------------------
 
+   procedure Arc_Waypoints
+     (Link   : not null access Canvas_Link_Record'Class;
+      Dim    : Anchors;
+      Offset : Gdouble)
+   is
       function Get_Wp return Item_Point_Array;
       --  Return the waypoints to use
 
@@ -1039,25 +1264,33 @@ package body Gtkada.Canvas_View.Links is
 
       Link.Bounding_Box := Compute_Bounding_Box
         (Link.Points.all, Relative => False);
-      Compute_Labels (Link, Context, Dim);
-   end Compute_Layout_For_Arc_Link;
+   end Arc_Waypoints;
 
-   -----------------------------------
-   -- Compute_Layout_For_Curve_Link --
-   -----------------------------------
+   ---------------------------------
+   -- Compute_Layout_For_Arc_Link --
+   ---------------------------------
 
-   procedure Compute_Layout_For_Curve_Link
+   procedure Compute_Layout_For_Arc_Link
      (Link    : not null access Canvas_Link_Record'Class;
-      Context : Draw_Context)
+      Context : Draw_Context;
+      Offset  : Gdouble := 10.0)
    is
-      P : Item_Point_Array_Access;
-      L : Integer;
+      Dim : constant Anchors := Compute_Anchors (Link);
    begin
-      Orthogonal_Waypoints
-        (Link, Context, Min_Margin => 6.0, Max_Margin => Gdouble'Last);
+      Arc_Waypoints (Link, Dim, Offset);
+      Compute_Labels (Link, Context, Dim);
+   end Compute_Layout_For_Arc_Link;
 
-      P := Link.Points;
+   ---------------------------
+   -- Curve_From_Orthogonal --
+   ---------------------------
 
+   procedure Curve_From_Orthogonal
+     (Link : not null access Canvas_Link_Record'Class)
+   is
+      P : Item_Point_Array_Access := Link.Points;
+      L : Integer;
+   begin
       if P'Length <= 2 then
          null;  --  degenerate case, handled in Draw_Link
       elsif P'Length = 3 then
@@ -1096,8 +1329,79 @@ package body Gtkada.Canvas_View.Links is
 
          Unchecked_Free (P);
       end if;
+   end Curve_From_Orthogonal;
+
+   -----------------------------------
+   -- Compute_Layout_For_Curve_Link --
+   -----------------------------------
+
+   procedure Compute_Layout_For_Curve_Link
+     (Link    : not null access Canvas_Link_Record'Class;
+      Context : Draw_Context) is
+   begin
+      Orthogonal_Waypoints
+        (Link, Context, Min_Margin => 6.0, Max_Margin => Gdouble'Last);
+      Curve_From_Orthogonal (Link);
    end Compute_Layout_For_Curve_Link;
 
+   --------------------
+   -- Is_Independent --
+   --------------------
+
+   function Is_Independent
+     (Link : not null access Canvas_Link_Record'Class) return Boolean is
+   begin
+      return Link.all'Tag = Canvas_Link_Record'Tag
+        and then Link.Routing /= Orthogonal_Avoid
+        and then not Link.From.Is_Link
+        and then not Link.To.Is_Link;
+   end Is_Independent;
+
+   ----------------------
+   -- Compute_Geometry --
+   ----------------------
+
+   procedure Compute_Geometry
+     (Link : not null access Canvas_Link_Record'Class)
+   is
+      No_Context : constant Draw_Context := (others => <>);
+   begin
+      case Link.Routing is
+         when Orthogonal =>
+            Orthogonal_Waypoints
+              (Link, No_Context, Min_Margin => 6.0, Max_Margin => 25.0,
+               Labels => False);
+         when Curve =>
+            Orthogonal_Waypoints
+              (Link, No_Context, Min_Margin => 6.0,
+               Max_Margin => Gdouble'Last, Labels => False);
+         when Straight =>
+            Straight_Waypoints (Link, Compute_Anchors (Link));
+         when Arc =>
+            Arc_Waypoints (Link, Compute_Anchors (Link), Link.Offset);
+         when Orthogonal_Avoid =>
+            raise Program_Error with "link needs to query the model";
+      end case;
+   end Compute_Geometry;
+
+   ---------------------
+   -- Commit_Geometry --
+   ---------------------
+
+   procedure Commit_Geometry
+     (Link    : not null access Canvas_Link_Record'Class;
+      Context : Draw_Context) is
+   begin
+      --  As in Compute_Layout_For_Curve_Link, the labels are placed along
+      --  the orthogonal path, before it is transformed into a curve.
+
+      Compute_Labels (Link, Context, Compute_Anchors (Link));
+
+      if Link.Routing = Curve then
+         Curve_From_Orthogonal (Link);
+      end if;
+   end Commit_Geometry;
+
    ------------------
    -- Prepare_Path --
    ------------------
@@ -1109,7 +1413,7 @@ package body Gtkada.Canvas_View.Links is
       P    : constant Item_Point_Array_Access := Link.Points;
    begin
       case Link.Routing is
-         when Straight | Orthogonal =>
+         when Straight | Orthogonal | Orthogonal_Avoid =>
             return Link.Style.Path_Polyline (Context.Cr, P.all);
 
          when Curve =>
@@ -23,34 +23,117 @@
 
 with Ada.Containers.Hashed_Maps;
 with Ada.Containers.Indefinite_Doubly_Linked_Lists;
+with Ada.Unchecked_Deallocation;
 with Glib.Graphs;               use Glib.Graphs;
 with Glib.Graphs.Layouts;
+with Glib.Object;               use Glib.Object;
+with Gtk.Handlers;              use Gtk.Handlers;
 with Gtkada.Canvas_View.Views;  use Gtkada.Canvas_View.Views;
 
 package body Gtkada.Canvas_View.Models.Layers is
 
+   procedure Get_Size (V : Vertex_Access; Width, Height : out Gdouble);
+   procedure Set_Position (V : Vertex_Access; X, Y : Gdouble);
+
+   package Graph_Layouts is new Glib.Graphs.Layouts
+     (Get_Size     => Get_Size,
+      Set_Position => Set_Position);
+   use type Graph_Layouts.Vertex_Place;
+
    type Canvas_Vertex is new Vertex with record
       Item  : Abstract_Item;
       View  : Canvas_View;
+
+      Place         : Graph_Layouts.Vertex_Place := Graph_Layouts.No_Place;
+      Width, Height : Gdouble := 0.0;
+      Seen          : Natural := 0;
+      --  For incremental layouts: the place of the item and its size in the
+      --  previous layout, and the last layout in which it was part of the
+      --  model.
    end record;
    type Canvas_Vertex_Access is access all Canvas_Vertex'Class;
 
    type Canvas_Edge is new Edge with record
       Item  : Canvas_Link;
+      Seen  : Natural := 0;
    end record;
    type Canvas_Edge_Access is access all Canvas_Edge'Class;
 
-   procedure Get_Size (V : Vertex_Access; Width, Height : out Gdouble);
-   procedure Set_Position (V : Vertex_Access; X, Y : Gdouble);
-
-   package Graph_Layouts is new Glib.Graphs.Layouts
-     (Get_Size     => Get_Size,
-      Set_Position => Set_Position);
-
    type Canvas_Dummy_Vertex is new Graph_Layouts.Base_Dummy_Vertex with record
       Pos   : Gtkada.Style.Point;
    end record;
 
+   type Long_Edge (Size : Natural) is record
+      Edge : Canvas_Link;
+      Dummies : Vertices_Array (1 .. Size);
+      --  Set when the edge was split into smaller edges with dummy
+      --  vertices. This is used to create the waypoints for long edges.
+   end record;
+   package Long_Edge_Lists
+      is new Ada.Containers.Indefinite_Doubly_Linked_Lists (Long_Edge);
+   use Long_Edge_Lists;
+
+   package Items_Maps is new Ada.Containers.Hashed_Maps
+     (Key_Type        => Abstract_Item,
+      Element_Type    => Vertex_Access,
+      Hash            => Gtkada.Canvas_View.Hash,
+      Equivalent_Keys => "=");
+   use Items_Maps;
+
+   package Links_Maps is new Ada.Containers.Hashed_Maps
+     (Key_Type        => Abstract_Item,
+      Element_Type    => Edge_Access,
+      Hash            => Gtkada.Canvas_View.Hash,
+      Equivalent_Keys => "=");
+
+   type Cache_Watcher_Record is new GObject_Record with record
+      Data : Cache_Data_Access;
+   end record;
+   type Cache_Watcher is access all Cache_Watcher_Record'Class;
+   --  Receives the item_destroyed signal of the model for a cache. This is
+   --  a separate object so that the handler is disconnected when the cache
+   --  is freed.
+
+   type Cache_Data is record
+      G          : Graph;
+      Items      : Items_Maps.Map;
+      Links      : Links_Maps.Map;
+      --  The graph used for the previous layout, and the vertex and edge for
+      --  each item and link of the model. The maps are indexed by the
+      --  address of the items, so destroyed items are removed immediately,
+      --  before a new item can be allocated at the same address.
+
+      Model      : Canvas_Model;
+      Watcher    : Cache_Watcher;
+      --  The model that Watcher monitors
+
+      Generation : Natural := 0;
+      --  Incremented for each layout, to find the items that were removed
+
+      Horizontal           : Boolean := True;
+      Space_Between_Items  : Gdouble := 0.0;
+      Space_Between_Layers : Gdouble := 0.0;
+      --  The settings of the previous layout
+   end record;
+
+   function Get_Data
+     (Cache : in out Layout_Cache) return not null Cache_Data_Access;
+   --  Return the data for Cache, allocating it on first use
+
+   procedure Watch_Model
+     (Data  : not null Cache_Data_Access;
+      Model : not null access Canvas_Model_Record'Class);
+   --  Make sure that the items destroyed in Model are removed from Data
+
+   procedure On_Cache_Item_Destroyed
+     (Watcher : access GObject_Record'Class;
+      Item    : Abstract_Item);
+   --  Remove Item from the cache, and its vertex or edge from the graph
+
+   procedure Set_Long_Edge_Waypoints (Long_Edges : Long_Edge_Lists.List);
+   --  Set the waypoints of the long links from the position of the dummy
+   --  vertices that replaced them
+
    --------------
    -- Get_Size --
    --------------
@@ -73,7 +156,11 @@ package body Gtkada.Canvas_View.Models.Layers is
       if V.all in Canvas_Vertex'Class then
          V2 := Canvas_Vertex_Access (V);
 
-         if V2.View /= null
+         if V2.Item.Position = (X, Y) then
+            --  Nothing to do. This is frequent for incremental layouts
+            null;
+
+         elsif V2.View /= null
            and then V2.Item.Position /= No_Position
          then
             Animate_Position (V2.Item, (X, Y)).Start (V2.View);
@@ -85,6 +172,126 @@ package body Gtkada.Canvas_View.Models.Layers is
       end if;
    end Set_Position;
 
+   --------------
+   -- Get_Data --
+   --------------
+
+   function Get_Data
+     (Cache : in out Layout_Cache) return not null Cache_Data_Access is
+   begin
+      if Cache.Data = null then
+         Cache.Data := new Cache_Data;
+         Set_Directed (Cache.Data.G, True);
+         Set_Use_Arena (Cache.Data.G, True);
+      end if;
+      return Cache.Data;
+   end Get_Data;
+
+   -----------------
+   -- Watch_Model --
+   -----------------
+
+   procedure Watch_Model
+     (Data  : not null Cache_Data_Access;
+      Model : not null access Canvas_Model_Record'Class)
+   is
+      Id : Handler_Id;
+      pragma Unreferenced (Id);
+   begin
+      if Data.Model /= Canvas_Model (Model) then
+         if Data.Watcher /= null then
+            Data.Watcher.Data := null;
+            Unref (Data.Watcher);
+         end if;
+
+         Data.Model := Canvas_Model (Model);
+         Data.Watcher := new Cache_Watcher_Record;
+         Glib.Object.Initialize (Data.Watcher);
+         Data.Watcher.Data := Data;
+         Id := Model.On_Item_Destroyed
+           (On_Cache_Item_Destroyed'Access, Slot => Data.Watcher);
+      end if;
+   end Watch_Model;
+
+   -----------------------------
+   -- On_Cache_Item_Destroyed --
+   -----------------------------
+
+   procedure On_Cache_Item_Destroyed
+     (Watcher : access GObject_Record'Class;
+      Item    : Abstract_Item)
+   is
+      Data  : constant Cache_Data_Access := Cache_Watcher (Watcher).Data;
+      C     : Items_Maps.Cursor;
+      L     : Links_Maps.Cursor;
+      V     : Vertex_Access;
+      E     : Canvas_Edge_Access;
+      Eit   : Edge_Iterator;
+      Edges : Items_Lists.List;
+   begin
+      if Data = null then
+         return;
+      end if;
+
+      L := Data.Links.Find (Item);
+      if Links_Maps.Has_Element (L) then
+         Remove (Data.G, Links_Maps.Element (L));
+         Data.Links.Delete (L);
+         return;
+      end if;
+
+      C := Data.Items.Find (Item);
+      if Has_Element (C) then
+         --  Removing the vertex also removes its edges, which must not
+         --  remain in Data.Links.
+
+         V := Element (C);
+         for Incoming in Boolean loop
+            if Incoming then
+               Eit := First (Data.G, Dest => V);
+            else
+               Eit := First (Data.G, Src => V);
+            end if;
+
+            while not At_End (Eit) loop
+               E := Canvas_Edge_Access (Get (Eit));
+               Edges.Append (Abstract_Item (E.Item));
+               Next (Eit);
+            end loop;
+         end loop;
+
+         for Link of Edges loop
+            Data.Links.Exclude (Link);
+         end loop;
+
+         Remove (Data.G, V);
+         Data.Items.Delete (C);
+      end if;
+   end On_Cache_Item_Destroyed;
+
+   -----------------------------
+   -- Set_Long_Edge_Waypoints --
+   -----------------------------
+
+   procedure Set_Long_Edge_Waypoints (Long_Edges : Long_Edge_Lists.List) is
+      C : Long_Edge_Lists.Cursor := Long_Edges.First;
+   begin
+      while Has_Element (C) loop
+         declare
+            E : constant Long_Edge := Element (C);
+            WP : Item_Point_Array (E.Dummies'Range);
+         begin
+            for D in WP'Range loop
+               WP (D) := Canvas_Dummy_Vertex (E.Dummies (D).all).Pos;
+            end loop;
+
+            E.Edge.Set_Waypoints (WP);
+         end;
+
+         Next (C);
+      end loop;
+   end Set_Long_Edge_Waypoints;
+
    ------------
    -- Layout --
    ------------
@@ -95,7 +302,13 @@ package body Gtkada.Canvas_View.Models.Layers is
       Horizontal           : Boolean := True;
       Add_Waypoints        : Boolean := False;
       Space_Between_Items  : Gdouble := 10.0;
-      Space_Between_Layers : Gdouble := 20.0)
+      Space_Between_Layers : Gdouble := 20.0;
+      Sweeps               : Positive := 8;
+      Tasks                : Positive := 1;
+      Runner               : Glib.Graphs.Parallel_Runner := null;
+      Transpose            : Boolean := False;
+      Time_Budget          : Duration := Duration'Last;
+      Optimal_Ranking      : Boolean := False)
    is
       procedure Replaced_With_Dummy_Vertices
         (Replaced_Edge : Edge_Access;
@@ -105,16 +318,6 @@ package body Gtkada.Canvas_View.Models.Layers is
         (Dummy_Vertex                 => Canvas_Dummy_Vertex,
          Replaced_With_Dummy_Vertices => Replaced_With_Dummy_Vertices);
 
-      type Long_Edge (Size : Natural) is record
-         Edge : Canvas_Link;
-         Dummies : Vertices_Array (1 .. Size);
-         --  Set when the edge was split into smaller edges with dummy
-         --  vertices. This is used to create the waypoints for long edges.
-      end record;
-      package Long_Edge_Lists
-         is new Ada.Containers.Indefinite_Doubly_Linked_Lists (Long_Edge);
-      use Long_Edge_Lists;
-
       Long_Edges : Long_Edge_Lists.List;
 
       ----------------------------------
@@ -135,13 +338,6 @@ package body Gtkada.Canvas_View.Models.Layers is
          end if;
       end Replaced_With_Dummy_Vertices;
 
-      package Items_Maps is new Ada.Containers.Hashed_Maps
-        (Key_Type        => Abstract_Item,
-         Element_Type    => Vertex_Access,
-         Hash            => Gtkada.Canvas_View.Hash,
-         Equivalent_Keys => "=");
-      use Items_Maps;
-
       G     : Graph;
       Items : Items_Maps.Map;
 
@@ -151,8 +347,9 @@ package body Gtkada.Canvas_View.Models.Layers is
       procedure On_Item (It : not null access Abstract_Item_Record'Class) is
          V : constant Vertex_Access := new Canvas_Vertex'
            (Vertex with
-            Item => Abstract_Item (It),
-            View => Canvas_View (View));
+            Item   => Abstract_Item (It),
+            View   => Canvas_View (View),
+            others => <>);
       begin
          Add_Vertex (G, V);
          Items.Include (Abstract_Item (It), V);
@@ -185,38 +382,311 @@ package body Gtkada.Canvas_View.Models.Layers is
          Add_Edge (G, E, V1, V2);
       end On_Link;
 
-      C : Long_Edge_Lists.Cursor;
-
    begin
       Set_Directed (G, True);
+      Set_Use_Arena (G, True);
       Self.For_Each_Item (On_Item'Access, Filter => Kind_Item);
       Self.For_Each_Item (On_Link'Access, Filter => Kind_Link);
       Layered_Layouts.Layout
         (G,
          Horizontal           => Horizontal,
          Space_Between_Layers => Space_Between_Layers,
-         Space_Between_Items  => Space_Between_Items);
+         Space_Between_Items  => Space_Between_Items,
+         Ordering             =>
+           (Sweeps      => Sweeps,
+            Tasks       => Tasks,
+            Runner      => Runner,
+            Transpose   => Transpose,
+            Time_Budget => Time_Budget),
+         Ranking              =>
+           (if Optimal_Ranking
+            then Graph_Layouts.Network_Simplex
+            else Graph_Layouts.Tight_Tree));
 
       if Add_Waypoints then
-         C := Long_Edges.First;
-         while Has_Element (C) loop
-            declare
-               E : constant Long_Edge := Element (C);
-               WP : Item_Point_Array (E.Dummies'Range);
-            begin
-               for D in WP'Range loop
-                  WP (D) := Canvas_Dummy_Vertex (E.Dummies (D).all).Pos;
-               end loop;
-
-               E.Edge.Set_Waypoints (WP);
-            end;
-
-            Next (C);
-         end loop;
+         Set_Long_Edge_Waypoints (Long_Edges);
       end if;
 
       Destroy (G);
       Self.Refresh_Layout;  --  recompute the links, and refresh views
    end Layout;
 
+   ------------------------
+   -- Incremental_Layout --
+   ------------------------
+
+   procedure Incremental_Layout
+     (Self                 : not null access Canvas_Model_Record'Class;
+      Cache                : in out Layout_Cache;
+      View                 : access Canvas_View_Record'Class := null;
+      Horizontal           : Boolean := True;
+      Add_Waypoints        : Boolean := False;
+      Space_Between_Items  : Gdouble := 10.0;
+      Space_Between_Layers : Gdouble := 20.0)
+   is
+      procedure Replaced_With_Dummy_Vertices
+        (Replaced_Edge : Edge_Access;
+         Dummies       : Vertices_Array);
+
+      package Layered_Layouts is new Graph_Layouts.Layered_Layouts
+        (Dummy_Vertex                 => Canvas_Dummy_Vertex,
+         Replaced_With_Dummy_Vertices => Replaced_With_Dummy_Vertices);
+
+      Long_Edges : Long_Edge_Lists.List;
+      --  The edges replaced with dummy vertices. They are restored after the
+      --  layout, so that the graph can be reused.
+
+      procedure On_Item (It : not null access Abstract_Item_Record'Class);
+      procedure On_Link (It : not null access Abstract_Item_Record'Class);
+      --  Add the new items and links to the graph
+
+      function Previous (V : Vertex_Access) return Graph_Layouts.Vertex_Place
+        is (Canvas_Vertex_Access (V).Place);
+      procedure Placed
+        (V : Vertex_Access; Place : Graph_Layouts.Vertex_Place);
+
+      Data  : Cache_Data renames Get_Data (Cache).all;
+      Fixed : Boolean := False;
+      --  Whether at least one item keeps its place from the previous layout
+
+      ----------------------------------
+      -- Replaced_With_Dummy_Vertices --
+      ----------------------------------
+
+      procedure Replaced_With_Dummy_Vertices
+        (Replaced_Edge : Edge_Access;
+         Dummies       : Vertices_Array)
+      is
+         E : constant Canvas_Edge_Access := Canvas_Edge_Access (Replaced_Edge);
+      begin
+         Long_Edges.Append
+           (Long_Edge'(Size    => Dummies'Length,
+                       Edge    => E.Item,
+                       Dummies => Dummies));
+      end Replaced_With_Dummy_Vertices;
+
+      ------------
+      -- Placed --
+      ------------
+
+      procedure Placed
+        (V : Vertex_Access; Place : Graph_Layouts.Vertex_Place) is
+      begin
+         Canvas_Vertex_Access (V).Place := Place;
+      end Placed;
+
+      -------------
+      -- On_Item --
+      -------------
+
+      procedure On_Item (It : not null access Abstract_Item_Record'Class) is
+         C : constant Items_Maps.Cursor :=
+           Data.Items.Find (Abstract_Item (It));
+         B : constant Model_Rectangle := It.Model_Bounding_Box;
+         V : Canvas_Vertex_Access;
+      begin
+         if Has_Element (C) then
+            V := Canvas_Vertex_Access (Element (C));
+         else
+            V := new Canvas_Vertex'
+              (Vertex with Item => Abstract_Item (It), others => <>);
+            Add_Vertex (Data.G, V);
+            Data.Items.Insert (Abstract_Item (It), Vertex_Access (V));
+         end if;
+
+         V.View := Canvas_View (View);
+         V.Seen := Data.Generation;
+
+         --  A resized item is placed again
+
+         if B.Width /= V.Width or else B.Height /= V.Height then
+            V.Width  := B.Width;
+            V.Height := B.Height;
+            V.Place  := Graph_Layouts.No_Place;
+         end if;
+
+         Fixed := Fixed or else V.Place /= Graph_Layouts.No_Place;
+      end On_Item;
+
+      -------------
+      -- On_Link --
+      -------------
+
+      procedure On_Link (It : not null access Abstract_Item_Record'Class) is
+         C      : Links_Maps.Cursor;
+         V1, V2 : Canvas_Vertex_Access;
+         E      : Canvas_Edge_Access;
+      begin
+         if It.all not in Canvas_Link_Record'Class then
+            --  custom edges unsupported, since we don't know their head or
+            --  tail
+            return;
+         end if;
+
+         --  Ignore link-to-link
+         if Canvas_Link (It).From.Is_Link
+           or else Canvas_Link (It).To.Is_Link
+         then
+            return;
+         end if;
+
+         --  Remove existing waypoints
+         Canvas_Link (It).Set_Waypoints ((1 .. 0 => <>));
+
+         C := Data.Links.Find (Abstract_Item (It));
+         if Links_Maps.Has_Element (C) then
+            Canvas_Edge_Access (Links_Maps.Element (C)).Seen :=
+              Data.Generation;
+         else
+            --  The ends of a new link are placed again
+
+            V1 := Canvas_Vertex_Access
+              (Data.Items.Element (Canvas_Link (It).From.Get_Toplevel_Item));
+            V2 := Canvas_Vertex_Access
+              (Data.Items.Element (Canvas_Link (It).To.Get_Toplevel_Item));
+            V1.Place := Graph_Layouts.No_Place;
+            V2.Place := Graph_Layouts.No_Place;
+
+            E := new Canvas_Edge;
+            E.Item := Canvas_Link (It);
+            E.Seen := Data.Generation;
+            Add_Edge (Data.G, E, V1, V2);
+            Data.Links.Insert (Abstract_Item (It), Edge_Access (E));
+         end if;
+      end On_Link;
+
+      Stale : Items_Lists.List;
+      V     : Canvas_Vertex_Access;
+      E     : Canvas_Edge_Access;
+      Eit   : Edge_Iterator;
+
+   begin
+      Watch_Model (Get_Data (Cache), Self);
+      Data.Generation := Data.Generation + 1;
+      Self.For_Each_Item (On_Item'Access, Filter => Kind_Item);
+      Self.For_Each_Item (On_Link'Access, Filter => Kind_Link);
+
+      --  Remove the links and items that are no longer in the model. The
+      --  edges are removed first, so that removing a vertex never removes
+      --  edges that are still in Data.Links.
+
+      for C in Data.Links.Iterate loop
+         if Canvas_Edge_Access (Links_Maps.Element (C)).Seen
+           /= Data.Generation
+         then
+            Stale.Append (Links_Maps.Key (C));
+         end if;
+      end loop;
+
+      for Link of Stale loop
+         Remove (Data.G, Data.Links.Element (Link));
+         Data.Links.Delete (Link);
+      end loop;
+
+      Stale.Clear;
+      for C in Data.Items.Iterate loop
+         if Canvas_Vertex_Access (Element (C)).Seen /= Data.Generation then
+            Stale.Append (Key (C));
+         end if;
+      end loop;
+
+      for Item of Stale loop
+         Remove (Data.G, Data.Items.Element (Item));
+         Data.Items.Delete (Item);
+      end loop;
+
+      --  Everything is placed again when the settings change
+
+      if Horizontal /= Data.Horizontal
+        or else Space_Between_Items /= Data.Space_Between_Items
+        or else Space_Between_Layers /= Data.Space_Between_Layers
+      then
+         Data.Horizontal           := Horizontal;
+         Data.Space_Between_Items  := Space_Between_Items;
+         Data.Space_Between_Layers := Space_Between_Layers;
+         Fixed := False;
+      end if;
+
+      if Fixed then
+         Layered_Layouts.Incremental_Layout
+           (Data.G,
+            Previous             => Previous'Access,
+            Horizontal           => Horizontal,
+            Space_Between_Layers => Space_Between_Layers,
+            Space_Between_Items  => Space_Between_Items,
+            Placed               => Placed'Access);
+      else
+         Layered_Layouts.Layout
+           (Data.G,
+            Horizontal           => Horizontal,
+            Space_Between_Layers => Space_Between_Layers,
+            Space_Between_Items  => Space_Between_Items,
+            Placed               => Placed'Access);
+      end if;
+
+      if Add_Waypoints then
+         Set_Long_Edge_Waypoints (Long_Edges);
+      end if;
+
+      --  Restore the graph: remove the dummy vertices, add the long edges
+      --  again, and give back their direction to the edges that were
+      --  reverted to make the graph acyclic.
+
+      for Long of Long_Edges loop
+         for D of Long.Dummies loop
+            Remove (Data.G, D);
+         end loop;
+
+         E := new Canvas_Edge;
+         E.Item := Long.Edge;
+         E.Seen := Data.Generation;
+         Add_Edge
+           (Data.G, E,
+            Data.Items.Element (Long.Edge.From.Get_Toplevel_Item),
+            Data.Items.Element (Long.Edge.To.Get_Toplevel_Item));
+         Data.Links.Replace (Abstract_Item (Long.Edge), Edge_Access (E));
+      end loop;
+
+      Stale.Clear;
+      Eit := First (Data.G);
+      while not At_End (Eit) loop
+         E := Canvas_Edge_Access (Get (Eit));
+         V := Canvas_Vertex_Access (Get_Src (E));
+         Next (Eit);
+
+         if V.Item /= E.Item.From.Get_Toplevel_Item then
+            Stale.Append (Abstract_Item (E.Item));
+         end if;
+      end loop;
+
+      for Link of Stale loop
+         Revert_Edge (Data.G, Data.Links.Element (Link));
+      end loop;
+
+      --  Dummy vertices are given new indexes at each layout
+
+      Renumber (Data.G);
+
+      Self.Refresh_Layout;  --  recompute the links, and refresh views
+   end Incremental_Layout;
+
+   ----------
+   -- Free --
+   ----------
+
+   procedure Free (Cache : in out Layout_Cache) is
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Cache_Data, Cache_Data_Access);
+   begin
+      if Cache.Data /= null then
+         if Cache.Data.Watcher /= null then
+            Cache.Data.Watcher.Data := null;
+            Unref (Cache.Data.Watcher);
+         end if;
+
+         Destroy (Cache.Data.G);
+         Unchecked_Free (Cache.Data);
+      end if;
+   end Free;
+
 end Gtkada.Canvas_View.Models.Layers;
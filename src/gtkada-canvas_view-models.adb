@@ -31,14 +31,36 @@ package body Gtkada.Canvas_View.Models is
         (Model : not null access GObject_Record'Class);
       --  Called when the layout in the model has changed, to refresh the tree
 
+      procedure On_Item_Destroyed
+        (Model : access GObject_Record'Class;
+         Item  : Abstract_Item);
+      --  Called when an item is destroyed, to remove it from the trees
+
+      procedure Update_Trees (Self : not null access Rtree_Model_Record'Class);
+      --  Insert new items in the trees, and move the ones whose bounding box
+      --  has changed since the last call.
+      --  When the trees are empty, or a large part of the items have changed,
+      --  the trees are rebuilt via Bulk_Load instead.
+
+      procedure Move_Item
+        (Self : not null access Rtree_Model_Record'Class;
+         Item : not null access Abstract_Item_Record'Class);
+      --  Insert Item in the trees, or move it if its bounding box has changed
+
+      Bulk_Load_Ratio : constant := 4;
+      --  The trees are rebuilt when more than 1 / Bulk_Load_Ratio of the
+      --  items have changed since the last update.
+
       -------------
       -- Gtk_New --
       -------------
 
-      procedure Gtk_New (Self : out Rtree_Model) is
+      procedure Gtk_New
+         (Self   : out Rtree_Model;
+          Policy : Split_Policy := Linear) is
       begin
          Self := new Rtree_Model_Record;
-         Rtree_Models.Initialize (Self);
+         Rtree_Models.Initialize (Self, Policy);
       end Gtk_New;
 
       ----------------
@@ -46,13 +68,17 @@ package body Gtkada.Canvas_View.Models is
       ----------------
 
       procedure Initialize
-         (Self : not null access Rtree_Model_Record'Class)
+         (Self   : not null access Rtree_Model_Record'Class;
+          Policy : Split_Policy := Linear)
       is
          Id : Handler_Id;
          pragma Unreferenced (Id);
       begin
          Gtkada.Canvas_View.Initialize (Self);
+         Self.Items_Tree.Set_Split_Policy (Policy);
+         Self.Links_Tree.Set_Split_Policy (Policy);
          Id := Self.On_Layout_Changed (On_Layout_Changed'Access);
+         Id := Self.On_Item_Destroyed (On_Item_Destroyed'Access);
       end Initialize;
 
       --------------------
@@ -64,42 +90,189 @@ package body Gtkada.Canvas_View.Models is
           Send_Signal : Boolean := True)
       is
       begin
-         --  Clear the trees, since the inherited refresh_layout will
-         --  call for_each_item, and this would not behave correctly
-         --  when Refresh_Layout is called just after removing items from
-         --  the underlying model.
+         --  The trees do not need to be cleared: destroyed items have already
+         --  been removed from them, and the inherited refresh_layout calls
+         --  for_each_item without an area, so it does not use the trees.
 
-         Self.Items_Tree.Clear;
-         Self.Links_Tree.Clear;
+         Self.In_Refresh := True;
          Canvas_Model_Record (Self.all).Refresh_Layout (Send_Signal);
+         Self.In_Refresh := False;
+
+         if not Send_Signal then
+            Update_Trees (Self);
+         end if;
+
+      exception
+         when others =>
+            Self.In_Refresh := False;
+            raise;
       end Refresh_Layout;
 
-      -----------------------
-      -- On_Layout_Changed --
-      -----------------------
+      ---------------
+      -- Move_Item --
+      ---------------
 
-      procedure On_Layout_Changed
-        (Model : not null access GObject_Record'Class)
+      procedure Move_Item
+        (Self : not null access Rtree_Model_Record'Class;
+         Item : not null access Abstract_Item_Record'Class)
       is
-         Self : constant Rtree_Model := Rtree_Model (Model);
+         It  : constant Abstract_Item := Abstract_Item (Item);
+         Box : constant Model_Rectangle := Item.Model_Bounding_Box;
+         B   : constant Item_Boxes.Cursor := Self.Boxes.Find (It);
+      begin
+         if not Item_Boxes.Has_Element (B) then
+            if Item.Is_Link then
+               Self.Links_Tree.Insert (Item);
+            else
+               Self.Items_Tree.Insert (Item);
+            end if;
+            Self.Boxes.Insert (It, Box);
+
+         elsif Item_Boxes.Element (B) /= Box then
+            if Item.Is_Link then
+               Self.Links_Tree.Update (Item, Item_Boxes.Element (B), Box);
+            else
+               Self.Items_Tree.Update (Item, Item_Boxes.Element (B), Box);
+            end if;
+            Self.Boxes.Replace_Element (B, Box);
+         end if;
+      end Move_Item;
+
+      -----------------
+      -- Items_Moved --
+      -----------------
+
+      overriding procedure Items_Moved
+        (Self  : not null access Rtree_Model_Record;
+         Items : Item_Sets.Set)
+      is
+         procedure On_Link (It : not null access Abstract_Item_Record'Class);
+         procedure On_Link (It : not null access Abstract_Item_Record'Class) is
+         begin
+            Move_Item (Self, It);
+         end On_Link;
+
+      begin
+         --  Nothing to do if the trees have not been filled yet: the next
+         --  layout_changed will load them.
+
+         if Self.Boxes.Is_Empty then
+            return;
+         end if;
+
+         for Item of Items loop
+            Move_Item (Self, Item);
+         end loop;
+
+         Self.For_Each_Link (On_Link'Access, From_Or_To => Items);
+      end Items_Moved;
+
+      ------------------
+      -- Update_Trees --
+      ------------------
+
+      procedure Update_Trees (Self : not null access Rtree_Model_Record'Class)
+      is
+         use Items_Lists;
+         Changed : Items_Lists.List;
+         C       : Items_Lists.Cursor;
 
          procedure On_Item (It : not null access Abstract_Item_Record'Class);
+         --  Store in Changed the items that are new or have moved
+
+         procedure Reload;
+         --  Rebuild both trees from scratch
+
          procedure On_Item (It : not null access Abstract_Item_Record'Class) is
+            Cur : constant Item_Boxes.Cursor :=
+               Self.Boxes.Find (Abstract_Item (It));
          begin
-            if It.Is_Link then
-               Self.Links_Tree.Insert (It);
-            else
-               Self.Items_Tree.Insert (It);
+            if not Item_Boxes.Has_Element (Cur)
+              or else Item_Boxes.Element (Cur) /= It.Model_Bounding_Box
+            then
+               Changed.Append (Abstract_Item (It));
             end if;
          end On_Item;
+
+         procedure Reload is
+            Items, Links : Items_Lists.List;
+
+            procedure Add (It : not null access Abstract_Item_Record'Class);
+            procedure Add (It : not null access Abstract_Item_Record'Class) is
+            begin
+               if It.Is_Link then
+                  Links.Append (Abstract_Item (It));
+               else
+                  Items.Append (Abstract_Item (It));
+               end if;
+               Self.Boxes.Include (Abstract_Item (It), It.Model_Bounding_Box);
+            end Add;
+         begin
+            Self.Boxes.Clear;
+            Self.For_Each_Item (Add'Access, In_Area => No_Rectangle);
+            Self.Items_Tree.Bulk_Load (Items);
+            Self.Links_Tree.Bulk_Load (Links);
+         end Reload;
+
       begin
-         Self.Items_Tree.Clear;
-         Self.Links_Tree.Clear;
-         Base_Model_Record (Self.all).Refresh_Layout   --  inherited
-           (Send_Signal => False);
          Self.For_Each_Item (On_Item'Access, In_Area => No_Rectangle);
+
+         if Changed.Is_Empty then
+            return;
+
+         elsif Self.Boxes.Is_Empty
+           or else Natural (Changed.Length) >
+              Natural (Self.Boxes.Length) / Bulk_Load_Ratio
+         then
+            Reload;
+
+         else
+            C := Changed.First;
+            while Has_Element (C) loop
+               Move_Item (Self, Element (C));
+               Next (C);
+            end loop;
+         end if;
+      end Update_Trees;
+
+      -----------------------
+      -- On_Layout_Changed --
+      -----------------------
+
+      procedure On_Layout_Changed
+        (Model : not null access GObject_Record'Class)
+      is
+         Self : constant Rtree_Model := Rtree_Model (Model);
+      begin
+         if not Self.In_Refresh then
+            Base_Model_Record (Self.all).Refresh_Layout   --  inherited
+              (Send_Signal => False);
+         end if;
+
+         Update_Trees (Self);
       end On_Layout_Changed;
 
+      -----------------------
+      -- On_Item_Destroyed --
+      -----------------------
+
+      procedure On_Item_Destroyed
+        (Model : access GObject_Record'Class;
+         Item  : Abstract_Item)
+      is
+         Self : constant Rtree_Model := Rtree_Model (Model);
+         C    : Item_Boxes.Cursor := Self.Boxes.Find (Item);
+      begin
+         if Item_Boxes.Has_Element (C) then
+            if Item.Is_Link then
+               Self.Links_Tree.Delete (Item, Item_Boxes.Element (C));
+            else
+               Self.Items_Tree.Delete (Item, Item_Boxes.Element (C));
+            end if;
+            Self.Boxes.Delete (C);
+         end if;
+      end On_Item_Destroyed;
+
       -------------------
       -- For_Each_Item --
       -------------------
@@ -22,13 +22,18 @@
 ------------------------------------------------------------------------------
 
 with Ada.Containers.Doubly_Linked_Lists;
+with Ada.Containers.Generic_Array_Sort;
 with Ada.Text_IO;   use Ada.Text_IO;
 with Ada.Unchecked_Deallocation;
 
 package body Gtkada.Canvas_View.Rtrees is
+   use Gdouble_Elementary_Functions;
 
    package Box_Lists is new Ada.Containers.Doubly_Linked_Lists (Box_Access);
 
+   procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+      (Box'Class, Box_Access);
+
    function Choose_Leaf_Node
       (Self : Rtree; Rect : Model_Rectangle) return Box_Access;
    --  Choose the best node to insert Rect into, starting at the root.
@@ -60,7 +65,107 @@ package body Gtkada.Canvas_View.Rtrees is
    --  the number of children is kept below the threshold.
 
    procedure Recompute_Bounding_Box (Self : Box_Access);
-   --  Recompute the tightest bounding box for all children of Self.
+   --  Recompute the tightest bounding box for all children of Self, and then
+   --  for each of its ancestors.
+
+   procedure Adjust_Path (Node : Box_Access);
+   --  Same as Recompute_Bounding_Box, after the box of one of the children
+   --  of Node has changed (grown or shrunk), or a child was removed. This
+   --  stops at the first ancestor whose box is unchanged, since the boxes
+   --  above it are then unchanged too.
+
+   procedure Remove_Child (Self : Box_Access; Child : Box_Access);
+   --  Remove a child, and compact the list of children. This doesn't update
+   --  the bounding boxes.
+
+   function Children_Count (Self : Box_Access) return Natural;
+   --  Number of children of Self
+
+   function Contains (Outer, Inner : Model_Rectangle) return Boolean;
+   --  Whether Inner is fully included in Outer
+
+   function Find_Leaf
+      (Self : Rtree;
+       Item : not null access Abstract_Item_Record'Class;
+       Rect : Model_Rectangle) return Box_Access;
+   --  Return the leaf that stores Item, or null if it is not in the tree.
+   --  Rect is the bounding box that was stored for Item, and is used to
+   --  only traverse the nodes that might contain it.
+
+   procedure Insert_Leaf
+      (Self           : in out Rtree;
+       Child          : not null Box_Access;
+       Allow_Reinsert : Boolean := True);
+   --  Insert an existing leaf in the tree, splitting nodes as needed.
+   --  Allow_Reinsert is only relevant for the R_Star policy, and is set to
+   --  False while performing a forced reinsert, so that it happens only once
+   --  per insertion.
+
+   procedure Linear_Split
+      (Self : Rtree; Node : not null Box_Access; New_Node : out Box_Access);
+   procedure R_Star_Split
+      (Self : Rtree; Node : not null Box_Access; New_Node : out Box_Access);
+   --  Node has too many children, and some of them are moved to a new
+   --  sibling node New_Node. The bounding boxes of Node and New_Node are
+   --  updated, but New_Node is not added to the tree.
+
+   procedure Forced_Reinsert (Self : in out Rtree; Node : not null Box_Access);
+   --  Node has too many children (and only contains leaves). The ones that
+   --  are furthest from its center are removed and inserted again.
+
+   function Least_Overlap_Enlargement
+      (Nodes : Box_Array; Rect : Model_Rectangle)
+      return not null Box_Access;
+   --  Returns the node from Nodes whose overlap with its siblings would
+   --  increase the least if it had to contain Rect. Ties are resolved via
+   --  Least_Enlargement.
+
+   function Overlap (R1, R2 : Model_Rectangle) return Gdouble;
+   --  Area of the intersection of the two rectangles
+
+   type Rect_Array is array (Natural range <>) of Model_Rectangle;
+
+   type Split_Order is (By_Low_X, By_High_X, By_Low_Y, By_High_Y);
+   --  The various orders in which R_Star_Split sorts the children
+
+   function Low_X_Less (Left, Right : Box_Access) return Boolean
+      is (Left.Rect.X < Right.Rect.X);
+   function High_X_Less (Left, Right : Box_Access) return Boolean
+      is (Left.Rect.X + Left.Rect.Width < Right.Rect.X + Right.Rect.Width);
+   function Low_Y_Less (Left, Right : Box_Access) return Boolean
+      is (Left.Rect.Y < Right.Rect.Y);
+   function High_Y_Less (Left, Right : Box_Access) return Boolean
+      is (Left.Rect.Y + Left.Rect.Height < Right.Rect.Y + Right.Rect.Height);
+
+   procedure Sort_By_Low_X is new Ada.Containers.Generic_Array_Sort
+      (Natural, Box_Access, Box_Array, Low_X_Less);
+   procedure Sort_By_High_X is new Ada.Containers.Generic_Array_Sort
+      (Natural, Box_Access, Box_Array, High_X_Less);
+   procedure Sort_By_Low_Y is new Ada.Containers.Generic_Array_Sort
+      (Natural, Box_Access, Box_Array, Low_Y_Less);
+   procedure Sort_By_High_Y is new Ada.Containers.Generic_Array_Sort
+      (Natural, Box_Access, Box_Array, High_Y_Less);
+
+   function Center_X_Less (Left, Right : Box_Access) return Boolean;
+   function Center_Y_Less (Left, Right : Box_Access) return Boolean;
+   --  Compare the centers of the bounding boxes of two nodes
+
+   procedure Sort_By_X is new Ada.Containers.Generic_Array_Sort
+      (Natural, Box_Access, Box_Array, Center_X_Less);
+   procedure Sort_By_Y is new Ada.Containers.Generic_Array_Sort
+      (Natural, Box_Access, Box_Array, Center_Y_Less);
+
+   function Pack
+      (Self : Rtree; Entries : Box_Array) return not null Box_Access;
+   --  Group Entries (which are either leaves or nodes of the same level) into
+   --  new nodes, using Sort-Tile-Recursive, and then do the same for the
+   --  upper levels until a single node remains. This node is returned.
+
+   procedure Condense_Tree (Self : in out Rtree; Node : Box_Access);
+   --  Called after a leaf was removed from Node. Underfull nodes are removed
+   --  from the tree (walking up towards the root), and the leaves they
+   --  contained are inserted again. Bounding boxes are updated, and the root
+   --  is replaced with its only child when possible.
 
    ---------------
    -- Add_Child --
@@ -103,6 +208,154 @@ package body Gtkada.Canvas_View.Rtrees is
       end loop;
    end Recompute_Bounding_Box;
 
+   -----------------
+   -- Adjust_Path --
+   -----------------
+
+   procedure Adjust_Path (Node : Box_Access) is
+      C   : Box_Access;
+      P   : Box_Access := Node;
+      Old : Model_Rectangle;
+   begin
+      while P /= null loop
+         Old := P.Rect;
+         C := P.Children (P.Children'First);
+         if C = null then
+            P.Rect := (0.0, 0.0, 0.0, 0.0);
+         else
+            P.Rect := C.Rect;
+
+            for Child in P.Children'First + 1 .. P.Children'Last loop
+               C := P.Children (Child);
+               exit when C = null;
+               Union (P.Rect, C.Rect);
+            end loop;
+         end if;
+
+         exit when P.Rect = Old;
+         P := P.Parent;
+      end loop;
+   end Adjust_Path;
+
+   ------------------
+   -- Remove_Child --
+   ------------------
+
+   procedure Remove_Child (Self : Box_Access; Child : Box_Access) is
+      Last : Natural := Self.Children'First - 1;
+   begin
+      for C in Self.Children'Range loop
+         exit when Self.Children (C) = null;
+         if Self.Children (C) /= Child then
+            Last := Last + 1;
+            Self.Children (Last) := Self.Children (C);
+         end if;
+      end loop;
+
+      for C in Last + 1 .. Self.Children'Last loop
+         Self.Children (C) := null;
+      end loop;
+
+      Child.Parent := null;
+   end Remove_Child;
+
+   --------------------
+   -- Children_Count --
+   --------------------
+
+   function Children_Count (Self : Box_Access) return Natural is
+      Count : Natural := 0;
+   begin
+      for C in Self.Children'Range loop
+         exit when Self.Children (C) = null;
+         Count := Count + 1;
+      end loop;
+      return Count;
+   end Children_Count;
+
+   --------------
+   -- Contains --
+   --------------
+
+   function Contains (Outer, Inner : Model_Rectangle) return Boolean is
+   begin
+      return Outer.X <= Inner.X
+        and then Outer.Y <= Inner.Y
+        and then Inner.X + Inner.Width <= Outer.X + Outer.Width
+        and then Inner.Y + Inner.Height <= Outer.Y + Outer.Height;
+   end Contains;
+
+   -------------
+   -- Overlap --
+   -------------
+
+   function Overlap (R1, R2 : Model_Rectangle) return Gdouble is
+      W : constant Gdouble :=
+         Gdouble'Min (R1.X + R1.Width, R2.X + R2.Width)
+         - Gdouble'Max (R1.X, R2.X);
+      H : constant Gdouble :=
+         Gdouble'Min (R1.Y + R1.Height, R2.Y + R2.Height)
+         - Gdouble'Max (R1.Y, R2.Y);
+   begin
+      if W <= 0.0 or else H <= 0.0 then
+         return 0.0;
+      else
+         return W * H;
+      end if;
+   end Overlap;
+
+   -------------------------------
+   -- Least_Overlap_Enlargement --
+   -------------------------------
+
+   function Least_Overlap_Enlargement
+      (Nodes : Box_Array; Rect : Model_Rectangle)
+      return not null Box_Access
+   is
+      Best_Choice  : Box_Access;
+      Best_Overlap : Gdouble := Gdouble'Last;
+      Candidates   : Box_Array (Nodes'Range) := (others => null);
+      Last         : Natural := Nodes'First - 1;
+      N            : Box_Access;
+      Enlarged     : Model_Rectangle;
+      Increase     : Gdouble;
+   begin
+      for C in Nodes'Range loop
+         N := Nodes (C);
+         exit when N = null;
+
+         Enlarged := N.Rect;
+         Union (Enlarged, Rect);
+
+         Increase := 0.0;
+         for C2 in Nodes'Range loop
+            exit when Nodes (C2) = null;
+            if C2 /= C then
+               Increase := Increase
+                  + Overlap (Enlarged, Nodes (C2).Rect)
+                  - Overlap (N.Rect, Nodes (C2).Rect);
+            end if;
+         end loop;
+
+         if Increase < Best_Overlap then
+            Best_Overlap := Increase;
+            Best_Choice := N;
+            Candidates := (others => null);
+            Last := Nodes'First;
+            Candidates (Last) := N;
+         elsif Increase = Best_Overlap then
+            Last := Last + 1;
+            Candidates (Last) := N;
+         end if;
+      end loop;
+
+      if Last = Nodes'First then
+         return Best_Choice;
+      else
+         return Least_Enlargement (Candidates, Rect);
+      end if;
+   end Least_Overlap_Enlargement;
+
    -----------------------
    -- Least_Enlargement --
    -----------------------
@@ -154,7 +407,18 @@ package body Gtkada.Canvas_View.Rtrees is
          C := Best_Choice.Children (Best_Choice.Children'First);
          exit when C = null or else C.Object /= null;
 
-         Best_Choice := Least_Enlargement (Best_Choice.Children, Rect);
+         --  With R_Star, when the children contain leaves, we try to
+         --  minimize the overlap between them.
+
+         if Self.Policy = R_Star
+           and then C.Children (C.Children'First) /= null
+           and then C.Children (C.Children'First).Object /= null
+         then
+            Best_Choice :=
+               Least_Overlap_Enlargement (Best_Choice.Children, Rect);
+         else
+            Best_Choice := Least_Enlargement (Best_Choice.Children, Rect);
+         end if;
       end loop;
       return Best_Choice;
    end Choose_Leaf_Node;
@@ -276,6 +540,24 @@ package body Gtkada.Canvas_View.Rtrees is
       end if;
    end Internal_Find;
 
+   ----------------------
+   -- Set_Split_Policy --
+   ----------------------
+
+   procedure Set_Split_Policy (Self : in out Rtree; Policy : Split_Policy) is
+   begin
+      Self.Policy := Policy;
+   end Set_Split_Policy;
+
+   ----------------------
+   -- Get_Split_Policy --
+   ----------------------
+
+   function Get_Split_Policy (Self : Rtree) return Split_Policy is
+   begin
+      return Self.Policy;
+   end Get_Split_Policy;
+
    ----------
    -- Find --
    ----------
@@ -303,13 +585,26 @@ package body Gtkada.Canvas_View.Rtrees is
       (Self : in out Rtree;
        Item : not null access Abstract_Item_Record'Class)
    is
-      Child : constant Box_Access := new Box'
-         (Max_Children_Plus_1 => 0,
-          Rect         => Item.Model_Bounding_Box,
-          Object       => Abstract_Item (Item),
-          others       => <>);
-      Parent, P, P2 : Box_Access;
-      N1, N2        : Box_Access;
+   begin
+      Insert_Leaf
+         (Self,
+          new Box'
+             (Max_Children_Plus_1 => 0,
+              Rect         => Item.Model_Bounding_Box,
+              Object       => Abstract_Item (Item),
+              others       => <>));
+   end Insert;
+
+   -----------------
+   -- Insert_Leaf --
+   -----------------
+
+   procedure Insert_Leaf
+      (Self           : in out Rtree;
+       Child          : not null Box_Access;
+       Allow_Reinsert : Boolean := True)
+   is
+      Parent, P     : Box_Access;
       New_Parent    : Box_Access;
       Old_Root      : Box_Access;
    begin
@@ -339,6 +634,19 @@ package body Gtkada.Canvas_View.Rtrees is
             P := P.Parent;
          end loop;
 
+         --  With R_Star, the first overflow is handled by reinserting some
+         --  of the children rather than splitting, which often results in a
+         --  better organization of the tree.
+
+         if Self.Policy = R_Star
+           and then Allow_Reinsert
+           and then Parent /= Self.Root
+           and then Parent.Children (Parent.Children'Last) /= null
+         then
+            Forced_Reinsert (Self, Parent);
+            return;
+         end if;
+
          --  Now split the nodes as needed when they are full: starting with
          --  the new parent A, we check if it has too many children. If yes,
          --  its parent will have one more child B. The children of A are then
@@ -350,34 +658,12 @@ package body Gtkada.Canvas_View.Rtrees is
 
          P := Parent;
          while P /= null and then P.Children (P.Children'Last) /= null loop
-            Linear_Pick_Seeds
-               (Width  => P.Rect.Width,
-                Height => P.Rect.Height,
-                Nodes  => P.Children,
-                Node1  => N1,
-                Node2  => N2);
-
-            New_Parent := new Box'
-               (Max_Children_Plus_1 => Self.Max_Children + 1,
-                Rect                => N2.Rect,
-                others              => <>);
-            Add_Child (New_Parent, N2);
-
-            declare
-               Nodes : constant Box_Array := P.Children;
-            begin
-               P.Children := (1 => N1, others => null);
-               P.Rect := N1.Rect;
-
-               for C in Nodes'Range loop
-                  exit when Nodes (C) = null;
-                  if Nodes (C) /= N1 and then Nodes (C) /= N2 then
-                     P2 := Least_Enlargement ((P, New_Parent), Nodes (C).Rect);
-                     Add_Child (P2, Nodes (C));
-                     Union (P2.Rect, Nodes (C).Rect);
-                  end if;
-               end loop;
-            end;
+            case Self.Policy is
+               when Linear =>
+                  Linear_Split (Self, P, New_Parent);
+               when R_Star =>
+                  R_Star_Split (Self, P, New_Parent);
+            end case;
 
             --  If we are splitting the root node, we need to create a new
             --  root
@@ -398,15 +684,488 @@ package body Gtkada.Canvas_View.Rtrees is
             P := P.Parent;
          end loop;
       end if;
-   end Insert;
+   end Insert_Leaf;
+
+   ------------------
+   -- Linear_Split --
+   ------------------
+
+   procedure Linear_Split
+      (Self : Rtree; Node : not null Box_Access; New_Node : out Box_Access)
+   is
+      N1, N2 : Box_Access;
+      P2     : Box_Access;
+      Nodes  : constant Box_Array := Node.Children;
+   begin
+      Linear_Pick_Seeds
+         (Width  => Node.Rect.Width,
+          Height => Node.Rect.Height,
+          Nodes  => Nodes,
+          Node1  => N1,
+          Node2  => N2);
+
+      New_Node := new Box'
+         (Max_Children_Plus_1 => Self.Max_Children + 1,
+          Rect                => N2.Rect,
+          others              => <>);
+      Add_Child (New_Node, N2);
+
+      Node.Children := (1 => N1, others => null);
+      Node.Rect := N1.Rect;
+
+      for C in Nodes'Range loop
+         exit when Nodes (C) = null;
+         if Nodes (C) /= N1 and then Nodes (C) /= N2 then
+            P2 := Least_Enlargement ((Node, New_Node), Nodes (C).Rect);
+            Add_Child (P2, Nodes (C));
+            Union (P2.Rect, Nodes (C).Rect);
+         end if;
+      end loop;
+   end Linear_Split;
+
+   ------------------
+   -- R_Star_Split --
+   ------------------
+
+   procedure R_Star_Split
+      (Self : Rtree; Node : not null Box_Access; New_Node : out Box_Access)
+   is
+      Nodes  : Box_Array := Node.Children;
+      First  : constant Natural := Nodes'First;
+      Last   : constant Natural := Nodes'Last;
+
+      --  Each group must have at least Min entries
+
+      Min    : constant Positive :=
+         Positive'Min (Self.Min_Children, Nodes'Length / 2);
+
+      Prefix, Suffix : Rect_Array (Nodes'Range);
+      --  Prefix (K) is the bounding box of Nodes (First .. K), and Suffix (K)
+      --  the bounding box of Nodes (K .. Last).
+
+      Margin : array (Split_Order) of Gdouble := (others => 0.0);
+      Best_Order   : Split_Order := By_Low_X;
+      Best_K       : Natural := First + Min - 1;
+      Best_Overlap : Gdouble := Gdouble'Last;
+      Best_Area    : Gdouble := Gdouble'Last;
+      Ov, Area     : Gdouble;
+      Use_X        : Boolean;
+
+      procedure Sort (Order : Split_Order);
+      --  Sort Nodes in the given order, and compute Prefix and Suffix
+
+      procedure Sort (Order : Split_Order) is
+      begin
+         case Order is
+            when By_Low_X  => Sort_By_Low_X (Nodes);
+            when By_High_X => Sort_By_High_X (Nodes);
+            when By_Low_Y  => Sort_By_Low_Y (Nodes);
+            when By_High_Y => Sort_By_High_Y (Nodes);
+         end case;
+
+         Prefix (First) := Nodes (First).Rect;
+         for K in First + 1 .. Last loop
+            Prefix (K) := Prefix (K - 1);
+            Union (Prefix (K), Nodes (K).Rect);
+         end loop;
+
+         Suffix (Last) := Nodes (Last).Rect;
+         for K in reverse First .. Last - 1 loop
+            Suffix (K) := Suffix (K + 1);
+            Union (Suffix (K), Nodes (K).Rect);
+         end loop;
+      end Sort;
+
+   begin
+      --  Choose the split axis: the one for which the sum of the perimeters
+      --  of all possible distributions is the smallest.
+
+      for Order in Split_Order loop
+         Sort (Order);
+         for K in First + Min - 1 .. Last - Min loop
+            Margin (Order) := Margin (Order)
+               + Prefix (K).Width + Prefix (K).Height
+               + Suffix (K + 1).Width + Suffix (K + 1).Height;
+         end loop;
+      end loop;
+
+      Use_X := Margin (By_Low_X) + Margin (By_High_X)
+         <= Margin (By_Low_Y) + Margin (By_High_Y);
+
+      --  Along that axis, choose the distribution with the least overlap
+      --  between the two groups, then with the least total area.
+
+      for Order in Split_Order loop
+         if (Order in By_Low_X .. By_High_X) = Use_X then
+            Sort (Order);
+            for K in First + Min - 1 .. Last - Min loop
+               Ov := Overlap (Prefix (K), Suffix (K + 1));
+               Area := Prefix (K).Width * Prefix (K).Height
+                  + Suffix (K + 1).Width * Suffix (K + 1).Height;
+
+               if Ov < Best_Overlap
+                 or else (Ov = Best_Overlap and then Area < Best_Area)
+               then
+                  Best_Order   := Order;
+                  Best_K       := K;
+                  Best_Overlap := Ov;
+                  Best_Area    := Area;
+               end if;
+            end loop;
+         end if;
+      end loop;
+
+      Sort (Best_Order);
+
+      New_Node := new Box'
+         (Max_Children_Plus_1 => Self.Max_Children + 1,
+          Rect                => Suffix (Best_K + 1),
+          others              => <>);
+
+      Node.Children := (others => null);
+      Node.Rect := Prefix (Best_K);
+
+      for C in First .. Best_K loop
+         Add_Child (Node, Nodes (C));
+      end loop;
+
+      for C in Best_K + 1 .. Last loop
+         Add_Child (New_Node, Nodes (C));
+      end loop;
+   end R_Star_Split;
+
+   ---------------------
+   -- Forced_Reinsert --
+   ---------------------
+
+   procedure Forced_Reinsert
+      (Self : in out Rtree; Node : not null Box_Access)
+   is
+      Nodes : Box_Array := Node.Children;
+
+      Count : constant Positive :=
+         Positive'Max (1, Nodes'Length * 3 / 10);
+      --  Number of children to reinsert, as recommended in the paper
+
+      Center_X : constant Gdouble := Node.Rect.X * 2.0 + Node.Rect.Width;
+      Center_Y : constant Gdouble := Node.Rect.Y * 2.0 + Node.Rect.Height;
+
+      function Distance (B : Box_Access) return Gdouble
+         is ((B.Rect.X * 2.0 + B.Rect.Width - Center_X) ** 2
+             + (B.Rect.Y * 2.0 + B.Rect.Height - Center_Y) ** 2);
+      --  Distance from the center of Node (squared and scaled, since we
+      --  only need to compare them).
+
+      function Closer (Left, Right : Box_Access) return Boolean
+         is (Distance (Left) < Distance (Right));
+
+      procedure Sort_By_Distance is new Ada.Containers.Generic_Array_Sort
+         (Natural, Box_Access, Box_Array, Closer);
+
+      Kept : constant Natural := Nodes'Last - Count;
+   begin
+      Sort_By_Distance (Nodes);
+
+      Node.Children := (others => null);
+      for C in Nodes'First .. Kept loop
+         Add_Child (Node, Nodes (C));
+      end loop;
+      Recompute_Bounding_Box (Node);
+
+      --  Reinsert starting with the closest ones
+
+      for C in Kept + 1 .. Nodes'Last loop
+         Nodes (C).Parent := null;
+         Insert_Leaf (Self, Nodes (C), Allow_Reinsert => False);
+      end loop;
+   end Forced_Reinsert;
+
+   -------------------
+   -- Center_X_Less --
+   -------------------
+
+   function Center_X_Less (Left, Right : Box_Access) return Boolean is
+   begin
+      return Left.Rect.X * 2.0 + Left.Rect.Width
+         < Right.Rect.X * 2.0 + Right.Rect.Width;
+   end Center_X_Less;
+
+   -------------------
+   -- Center_Y_Less --
+   -------------------
+
+   function Center_Y_Less (Left, Right : Box_Access) return Boolean is
+   begin
+      return Left.Rect.Y * 2.0 + Left.Rect.Height
+         < Right.Rect.Y * 2.0 + Right.Rect.Height;
+   end Center_Y_Less;
+
+   ----------
+   -- Pack --
+   ----------
+
+   function Pack
+      (Self : Rtree; Entries : Box_Array) return not null Box_Access
+   is
+      M      : constant Positive := Self.Max_Children;
+      Count  : constant Positive := Entries'Length;
+      Nodes  : constant Positive := (Count + M - 1) / M;
+
+      --  Each slice must contain at least Min_Children entries, otherwise
+      --  its only node would be underfull.
+      Slices : constant Positive := Integer'Max
+         (1, Integer'Min
+            (Positive (Gdouble'Ceiling (Sqrt (Gdouble (Nodes)))),
+             Count / Self.Min_Children));
+      Sorted : Box_Array := Entries;
+
+      Parents : Box_Array (1 .. Nodes + Slices);
+      Last    : Natural := 0;
+      Lo, Hi, Len, Groups : Natural;
+      N       : Box_Access;
+   begin
+      --  Split into vertical slices of roughly Slices * M entries each
+
+      Sort_By_X (Sorted);
+
+      for S in 0 .. Slices - 1 loop
+         Lo  := Sorted'First + S * Count / Slices;
+         Hi  := Sorted'First + (S + 1) * Count / Slices - 1;
+         Len := Hi - Lo + 1;
+
+         --  Cut each slice into nodes. The entries are spread evenly among
+         --  the nodes rather than filling all nodes but the last: this
+         --  rebalances the last two nodes, so that the last one is not
+         --  underfull (each node gets at least Max_Children / 2 entries
+         --  when there are several of them).
+
+         Sort_By_Y (Sorted (Lo .. Hi));
+         Groups := (Len + M - 1) / M;
+
+         for G in 0 .. Groups - 1 loop
+            N := new Box'
+               (Max_Children_Plus_1 => M + 1,
+                others              => <>);
+            for C in Lo + G * Len / Groups
+               .. Lo + (G + 1) * Len / Groups - 1
+            loop
+               Add_Child (N, Sorted (C));
+            end loop;
+            Recompute_Bounding_Box (N);
+
+            Last := Last + 1;
+            Parents (Last) := N;
+         end loop;
+      end loop;
+
+      if Last = 1 then
+         return Parents (1);
+      else
+         return Pack (Self, Parents (1 .. Last));
+      end if;
+   end Pack;
+
+   ---------------
+   -- Bulk_Load --
+   ---------------
+
+   procedure Bulk_Load
+      (Self  : in out Rtree;
+       Items : Items_Lists.List)
+   is
+      use Items_Lists;
+      Leaves : Box_Array (1 .. Natural (Items.Length));
+      C      : Items_Lists.Cursor := Items.First;
+   begin
+      Clear (Self);
+
+      for L in Leaves'Range loop
+         Leaves (L) := new Box'
+            (Max_Children_Plus_1 => 0,
+             Rect                => Element (C).Model_Bounding_Box,
+             Object              => Element (C),
+             others              => <>);
+         Next (C);
+      end loop;
+
+      if Leaves'Length /= 0 then
+         Self.Root := Pack (Self, Leaves);
+      end if;
+   end Bulk_Load;
+
+   ---------------
+   -- Find_Leaf --
+   ---------------
+
+   function Find_Leaf
+      (Self : Rtree;
+       Item : not null access Abstract_Item_Record'Class;
+       Rect : Model_Rectangle) return Box_Access
+   is
+      use Box_Lists;
+      To_Analyze : Box_Lists.List;
+      Current, C : Box_Access;
+   begin
+      if Self.Root /= null then
+         To_Analyze.Append (Box_Access'(Self.Root));
+         while not To_Analyze.Is_Empty loop
+            Current := To_Analyze.First_Element;
+            To_Analyze.Delete_First;
+
+            for Child in Current.Children'Range loop
+               C := Current.Children (Child);
+               exit when C = null;
+
+               if C.Object /= null then
+                  if C.Object = Abstract_Item (Item) then
+                     return C;
+                  end if;
+               elsif Intersects (Rect, C.Rect) then
+                  To_Analyze.Append (C);
+               end if;
+            end loop;
+         end loop;
+      end if;
+      return null;
+   end Find_Leaf;
+
+   -------------------
+   -- Condense_Tree --
+   -------------------
+
+   procedure Condense_Tree (Self : in out Rtree; Node : Box_Access) is
+      use Box_Lists;
+      Orphans : Box_Lists.List;
+      N, P    : Box_Access := Node;
+      C       : Box_Lists.Cursor;
+
+      procedure Collect_Leaves (B : in out Box_Access);
+      --  Move all the leaves below B to Orphans, and free B and the nodes
+      --  below it.
+
+      procedure Collect_Leaves (B : in out Box_Access) is
+      begin
+         if B.Object /= null then
+            B.Parent := null;
+            Orphans.Append (B);
+         else
+            for Child in B.Children'Range loop
+               exit when B.Children (Child) = null;
+               Collect_Leaves (B.Children (Child));
+            end loop;
+            Unchecked_Free (B);
+         end if;
+      end Collect_Leaves;
+
+   begin
+      --  Only the nodes on the path from Node to the root might have lost a
+      --  child, and a node can only become underfull if its child was
+      --  removed, so we stop at the first node that has enough children.
+
+      while N /= Self.Root
+        and then Children_Count (N) < Self.Min_Children
+      loop
+         P := N.Parent;
+         Remove_Child (P, N);
+         Collect_Leaves (N);
+         N := P;
+      end loop;
+
+      --  Shrink the boxes on the path to the root, since they might have
+      --  been enclosing the removed leaf.
+
+      Adjust_Path (N);
+
+      --  Shorten the tree if the root has a single non-leaf child
+
+      loop
+         P := Self.Root.Children (Self.Root.Children'First);
+
+         if P = null then
+            Unchecked_Free (Self.Root);
+            exit;
+         end if;
+
+         exit when P.Object /= null
+           or else Self.Root.Children (Self.Root.Children'First + 1) /= null;
+
+         P.Parent := null;
+         Unchecked_Free (Self.Root);
+         Self.Root := P;
+      end loop;
+
+      --  Reinsert the leaves of the nodes we removed
+
+      C := Orphans.First;
+      while Has_Element (C) loop
+         Insert_Leaf (Self, Element (C));
+         Next (C);
+      end loop;
+   end Condense_Tree;
+
+   ------------
+   -- Delete --
+   ------------
+
+   procedure Delete
+      (Self    : in out Rtree;
+       Item    : not null access Abstract_Item_Record'Class;
+       Old_Box : Model_Rectangle)
+   is
+      Leaf   : Box_Access := Find_Leaf (Self, Item, Old_Box);
+      Parent : Box_Access;
+   begin
+      if Leaf /= null then
+         Parent := Leaf.Parent;
+         Remove_Child (Parent, Leaf);
+         Unchecked_Free (Leaf);
+         Condense_Tree (Self, Parent);
+      end if;
+   end Delete;
+
+   ------------
+   -- Update --
+   ------------
+
+   procedure Update
+      (Self    : in out Rtree;
+       Item    : not null access Abstract_Item_Record'Class;
+       Old_Box : Model_Rectangle;
+       New_Box : Model_Rectangle)
+   is
+      Leaf   : constant Box_Access := Find_Leaf (Self, Item, Old_Box);
+      Parent : Box_Access;
+   begin
+      if Leaf = null then
+         Insert_Leaf
+            (Self,
+             new Box'
+                (Max_Children_Plus_1 => 0,
+                 Rect                => New_Box,
+                 Object              => Abstract_Item (Item),
+                 others              => <>));
+
+      elsif Contains (Leaf.Parent.Rect, New_Box) then
+         --  Small moves within the parent node: we only need to adjust the
+         --  bounding boxes on the path to the root (which might shrink).
+
+         Leaf.Rect := New_Box;
+         Adjust_Path (Leaf.Parent);
+
+      else
+         Parent := Leaf.Parent;
+         Remove_Child (Parent, Leaf);
+         Condense_Tree (Self, Parent);
+         Leaf.Rect := New_Box;
+         Insert_Leaf (Self, Leaf);
+      end if;
+   end Update;
 
    -----------
    -- Clear --
    -----------
 
    procedure Clear (Self : in out Rtree) is
-      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
-         (Box'Class, Box_Access);
       procedure Recurse (B : in out Box_Access);
       procedure Recurse (B : in out Box_Access) is
       begin
@@ -465,6 +1224,73 @@ package body Gtkada.Canvas_View.Rtrees is
       end if;
    end Dump_Debug;
 
+   -------------------------
+   -- Count_Visited_Nodes --
+   -------------------------
+
+   function Count_Visited_Nodes
+      (Self : Rtree; Rect : Model_Rectangle) return Natural
+   is
+      use Box_Lists;
+      To_Analyze : Box_Lists.List;
+      Current, C : Box_Access;
+      Count      : Natural := 0;
+   begin
+      if Self.Root /= null then
+         To_Analyze.Append (Box_Access'(Self.Root));
+         while not To_Analyze.Is_Empty loop
+            Current := To_Analyze.First_Element;
+            To_Analyze.Delete_First;
+            Count := Count + 1;
+
+            for Child in Current.Children'Range loop
+               C := Current.Children (Child);
+               exit when C = null;
+
+               if Rect = No_Rectangle
+                  or else Intersects (Rect, C.Rect)
+               then
+                  if C.Object /= null then
+                     Count := Count + 1;
+                  else
+                     To_Analyze.Append (C);
+                  end if;
+               end if;
+            end loop;
+         end loop;
+      end if;
+      return Count;
+   end Count_Visited_Nodes;
+
+   -----------------------
+   -- Min_Node_Children --
+   -----------------------
+
+   function Min_Node_Children (Self : Rtree) return Natural is
+      Result : Natural := Natural'Last;
+
+      procedure Internal (B : Box_Access);
+      procedure Internal (B : Box_Access) is
+      begin
+         if B.Object = null then
+            if B /= Self.Root then
+               Result := Natural'Min (Result, Children_Count (B));
+            end if;
+
+            for C in B.Children'Range loop
+               exit when B.Children (C) = null;
+               Internal (B.Children (C));
+            end loop;
+         end if;
+      end Internal;
+
+   begin
+      if Self.Root /= null then
+         Internal (Self.Root);
+      end if;
+      return Result;
+   end Min_Node_Children;
+
    ------------------
    -- Bounding_Box --
    ------------------
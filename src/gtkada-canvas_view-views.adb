@@ -23,8 +23,12 @@
 ------------------------------------------------------------------------------
 
 with Ada.Containers.Doubly_Linked_Lists;
+with Ada.Containers.Hashed_Maps;
 with Ada.Tags;          use Ada.Tags;
 with Cairo;             use Cairo;
+with Cairo.Image_Surface; use Cairo.Image_Surface;
+with Cairo.Surface;
+with Gdk.Frame_Clock;   use Gdk.Frame_Clock;
 with Gdk.Types.Keysyms; use Gdk.Types.Keysyms;
 with Glib;              use Glib;
 with Glib.Main;         use Glib.Main;
@@ -34,18 +38,15 @@ with Gtk.Enums;         use Gtk.Enums;
 with Gtk.Handlers;      use Gtk.Handlers;
 with Gtk.Widget;        use Gtk.Widget;
 with System;            use System;
+with System.Storage_Elements; use System.Storage_Elements;
 
 package body Gtkada.Canvas_View.Views is
    use Gdouble_Elementary_Functions;
 
-   Min_Animation_Interval : constant Duration := 2.0 * 0.017;
-   --  (in seconds). This is computed for a refresh rate of 60Hs,
-   --  with 1s / 60.
-   --  The animation loop will not do anything if called more often than that.
-
-   Animation_Interval : constant Guint := 30;
-   --  (in milliseconds). How long we give the application to perform one
-   --  iteration of the animation loop.
+   Frame_Budget : constant Duration := 0.008;
+   --  (in seconds). How long we give the application to perform one
+   --  iteration of the animation loop, before each frame. This leaves time
+   --  to draw the frame at a refresh rate of 60Hz.
 
    procedure On_Monitored_Destroyed
      (Minimap : System.Address; Monitored : System.Address);
@@ -65,6 +66,34 @@ package body Gtkada.Canvas_View.Views is
       return Boolean;
    --  React to events in the minimap
 
+   procedure Monitor_Model
+     (Self  : not null access Minimap_View_Record'Class;
+      Model : Canvas_Model);
+   --  Watch the changes in Model, which damage the thumbnail of the minimap
+
+   procedure Discard_Thumbnail
+     (Self : not null access Minimap_View_Record'Class);
+   --  Free the thumbnail, so that the whole model is drawn again
+
+   procedure Damage_Thumbnail
+     (Self : not null access Minimap_View_Record'Class;
+      Item : access Abstract_Item_Record'Class);
+   procedure Damage_Thumbnail
+     (Self : not null access Minimap_View_Record'Class;
+      Area : Model_Rectangle);
+   --  Mark the area of Item (or Area) as needing to be drawn again in the
+   --  thumbnail, or the whole thumbnail if Item is null.
+
+   procedure On_Minimap_Layout_Changed
+     (Minimap : not null access GObject_Record'Class);
+   procedure On_Minimap_Item_Changed
+     (Minimap : access GObject_Record'Class;
+      Item    : Abstract_Item);
+   procedure On_Minimap_Selection_Changed
+     (Minimap : not null access GObject_Record'Class;
+      Item    : Abstract_Item);
+   --  Called when the model displayed in the minimap changes
+
    procedure Start_Continuous_Scrolling
      (Self    : not null access Canvas_View_Record'Class;
       Dx, Dy  : Model_Coordinate := 0.0);
@@ -85,18 +114,67 @@ package body Gtkada.Canvas_View.Views is
      (Animator_Access);
    use Animator_Lists;
 
+   package Slot_Lists is new Ada.Containers.Doubly_Linked_Lists
+     (Animator_Lists.Cursor);
+   --  The animators of an item, as positions in the animation queue
+
+   function Hash (Owner : System.Address) return Ada.Containers.Hash_Type;
+
+   package Slot_Maps is new Ada.Containers.Hashed_Maps
+     (Key_Type        => System.Address,
+      Element_Type    => Slot_Lists.List,
+      Hash            => Hash,
+      Equivalent_Keys => "=",
+      "="             => Slot_Lists."=");
+
    type Animation_Data is new Base_Animation_Data with record
-      Last_Run : Ada.Calendar.Time := No_Time;
       Queue    : Animator_Lists.List;
       Current  : Animator_Lists.Cursor := Animator_Lists.No_Element;
+
+      Slots    : Slot_Maps.Map;
+      --  The animators of each item (or of each view, for animators that
+      --  are not for a specific item), so that they can be found without
+      --  traversing the queue.
+
+      Running  : Natural := 0;
+      --  Number of nested calls to Animation_Iteration in progress. An
+      --  animator can terminate animations (for instance by destroying its
+      --  item), so while this is not 0 nothing is freed: see Removed and
+      --  Stopped.
+
+      Removed  : Animator_Lists.List;
+      --  The animators removed while Running. Their element in Queue is set
+      --  to null, and they are freed at the end of the iteration.
+
+      Stopped  : Boolean := False;
+      --  Whether Stop_Animation was called while Running, in which case the
+      --  animation data is freed at the end of the iteration.
    end record;
    type Animation_Data_Access is access all Animation_Data;
 
-   procedure On_Animate_Destroy (View : in out Canvas_View);
-   --  Called when the animation queue terminates
+   function Owner
+     (Anim : not null access Animator'Class) return System.Address;
+   --  The key of the slot of Anim in Animation_Data.Slots
+
+   procedure Remove_Animator
+     (Data : not null Animation_Data_Access;
+      C    : in out Animator_Lists.Cursor);
+   --  Remove the animator at C from the queue, and free it (or only mark it
+   --  as removed while an iteration is running).
+
+   procedure End_Iteration (Self : not null access Canvas_View_Record'Class);
+   --  Called when Animation_Iteration returns: free the animators removed
+   --  during the outermost iteration, and the animation data if
+   --  Stop_Animation was called meanwhile.
+
+   function On_Animate_Tick
+     (Widget      : not null access Gtk_Widget_Record'Class;
+      Frame_Clock : not null access Gdk_Frame_Clock_Record'Class)
+      return Boolean;
+   --  Perform one step of animation, before a frame is drawn
 
-   function On_Animate (View : Canvas_View) return Boolean;
-   --  Perform one step of animation
+   procedure Stop_Animation (Self : not null access Canvas_View_Record'Class);
+   --  Remove the tick callback, and free the animation queue
 
    procedure Animation_Iteration
      (Self     : not null access Canvas_View_Record'Class;
@@ -444,7 +522,12 @@ package body Gtkada.Canvas_View.Views is
             Cancel_Continuous_Scrolling (Self);
          end if;
 
-         Self.Queue_Draw;
+         --  Move_Dragged_Items has already redrawn the items and their
+         --  links, but the smart guides might extend over the whole view.
+
+         if Self.Snap.Smart_Guides and then Event.Allow_Snapping then
+            Self.Queue_Draw;
+         end if;
 
       elsif Event.Event_Type = Start_Drag then
          --  Remove the waypoints for all the links that will be impacted.
@@ -803,7 +886,6 @@ package body Gtkada.Canvas_View.Views is
             Move_Dragged_Items
               (Self, Dx => Dx, Dy => Dy, From_Initial => True);
             Self.Dragged_Items.Clear;
-            Self.Queue_Draw;
          end if;
 
          return True;
@@ -822,7 +904,7 @@ package body Gtkada.Canvas_View.Views is
       Screen : constant Model_Rectangle := Self.Get_Visible_Area;
 
       procedure Add_Guides
-        (Guides              : in out Smart_Guide_Lists.List;
+        (Guides              : in out Smart_Guide_Maps.Map;
          Start, Middle, Last : Model_Coordinate;
          Min, Max            : Model_Coordinate);
 
@@ -835,62 +917,37 @@ package body Gtkada.Canvas_View.Views is
       ----------------
 
       procedure Add_Guides
-        (Guides              : in out Smart_Guide_Lists.List;
+        (Guides              : in out Smart_Guide_Maps.Map;
          Start, Middle, Last : Model_Coordinate;
          Min, Max            : Model_Coordinate)
       is
-         procedure Update_Guide (Guide : in out Smart_Guide);
-         procedure Update_Guide (Guide : in out Smart_Guide) is
+         procedure Update_Guide
+           (Pos : Model_Coordinate; Guide : in out Smart_Guide);
+         procedure Update_Guide
+           (Pos : Model_Coordinate; Guide : in out Smart_Guide)
+         is
+            pragma Unreferenced (Pos);
          begin
             Guide.Min := Model_Coordinate'Min (Guide.Min, Min);
             Guide.Max := Model_Coordinate'Max (Guide.Max, Max);
          end Update_Guide;
 
-         use Smart_Guide_Lists;
-         Found_Start, Found_Middle, Found_End : Boolean := False;
-         C : Smart_Guide_Lists.Cursor := Guides.First;
-         Pos : Model_Coordinate;
-
-      begin
-         while Has_Element (C) loop
-            Pos := Element (C).Pos;
-            if Pos = Start then
-               Found_Start := True;
-               Guides.Update_Element (C, Update_Guide'Access);
-            elsif Pos = Middle then
-               Found_Middle := True;
-               Guides.Update_Element (C, Update_Guide'Access);
-            elsif Pos = Last then
-               Found_End := True;
+         procedure Add (Pos : Model_Coordinate);
+         procedure Add (Pos : Model_Coordinate) is
+            C        : Smart_Guide_Maps.Cursor;
+            Inserted : Boolean;
+         begin
+            Guides.Insert
+              (Pos, (Pos => Pos, Min => Min, Max => Max), C, Inserted);
+            if not Inserted then
                Guides.Update_Element (C, Update_Guide'Access);
             end if;
+         end Add;
 
-            Next (C);
-         end loop;
-
-         if not Found_Start then
-            Guides.Append
-              ((Pos        => Start,
-                Min        => Min,
-                Max        => Max,
-                Visible    => False));
-         end if;
-
-         if not Found_Middle then
-            Guides.Append
-              ((Pos        => Middle,
-                Min        => Min,
-                Max        => Max,
-                Visible    => False));
-         end if;
-
-         if not Found_End then
-            Guides.Append
-              ((Pos        => Last,
-                Min        => Min,
-                Max        => Max,
-                Visible    => False));
-         end if;
+      begin
+         Add (Start);
+         Add (Middle);
+         Add (Last);
       end Add_Guides;
 
       ------------------
@@ -926,8 +983,7 @@ package body Gtkada.Canvas_View.Views is
       end Process_Item;
 
    begin
-      Self.Snap.Hguides.Clear;
-      Self.Snap.Vguides.Clear;
+      Free_Smart_Guides (Self);
 
       if Self.Model = null then
          return;
@@ -945,6 +1001,8 @@ package body Gtkada.Canvas_View.Views is
    begin
       Self.Snap.Hguides.Clear;
       Self.Snap.Vguides.Clear;
+      Self.Snap.Visible_Hguides.Clear;
+      Self.Snap.Visible_Vguides.Clear;
    end Free_Smart_Guides;
 
    -------------------------
@@ -957,40 +1015,68 @@ package body Gtkada.Canvas_View.Views is
       Size       : Model_Coordinate;
       Horizontal : Boolean) return Model_Coordinate
    is
-      use Smart_Guide_Lists;
-      C      : Smart_Guide_Lists.Cursor;
+      use Smart_Guide_Maps;
+      Margin : constant Model_Coordinate := Self.Snap.Margin;
       Result : Model_Coordinate := Pos;
 
-      procedure Update_Guide (Guide : in out Smart_Guide);
-      procedure Update_Guide (Guide : in out Smart_Guide) is
+      procedure Snap
+        (Guides  : Smart_Guide_Maps.Map;
+         Visible : in out Smart_Guide_Lists.List);
+      --  Snap to the guides within Margin of one of the edges or of the
+      --  middle of the item, and make them visible.
+
+      ----------
+      -- Snap --
+      ----------
+
+      procedure Snap
+        (Guides  : Smart_Guide_Maps.Map;
+         Visible : in out Smart_Guide_Lists.List)
+      is
+         Offsets : constant array (1 .. 3) of Model_Coordinate :=
+           (0.0, Size / 2.0, Size);
+         From    : Model_Coordinate := Model_Coordinate'First;
+         To      : Model_Coordinate;
+         C       : Smart_Guide_Maps.Cursor;
+         Guide   : Smart_Guide;
       begin
-         if abs (Guide.Pos - Pos) < Self.Snap.Margin then
-            Guide.Visible := True;
-            Result := Guide.Pos;
-         elsif abs (Guide.Pos - Pos - Size / 2.0) < Self.Snap.Margin then
-            Guide.Visible := True;
-            Result := Guide.Pos - Size / 2.0;
-         elsif abs (Guide.Pos - Pos - Size) < Self.Snap.Margin then
-            Guide.Visible := True;
-            Result := Guide.Pos - Size;
-         else
-            Guide.Visible := False;
-         end if;
-      end Update_Guide;
+         Visible.Clear;
+
+         --  Guides are sorted, so we only look at the ones that are close
+         --  enough to snap to. A guide is only tested once, even when the
+         --  ranges overlap for small items.
+
+         for Offset of Offsets loop
+            From := Model_Coordinate'Max (From, Pos + Offset - Margin);
+            To   := Pos + Offset + Margin;
+            C    := Guides.Ceiling (From);
+
+            while Has_Element (C) and then Key (C) < To loop
+               Guide := Element (C);
+
+               if abs (Guide.Pos - Pos) < Margin then
+                  Visible.Append (Guide);
+                  Result := Guide.Pos;
+               elsif abs (Guide.Pos - Pos - Size / 2.0) < Margin then
+                  Visible.Append (Guide);
+                  Result := Guide.Pos - Size / 2.0;
+               elsif abs (Guide.Pos - Pos - Size) < Margin then
+                  Visible.Append (Guide);
+                  Result := Guide.Pos - Size;
+               end if;
+
+               Next (C);
+            end loop;
+
+            From := To;
+         end loop;
+      end Snap;
 
    begin
       if Horizontal then
-         C := Self.Snap.Hguides.First;
-         while Has_Element (C) loop
-            Self.Snap.Hguides.Update_Element (C, Update_Guide'Access);
-            Next (C);
-         end loop;
+         Snap (Self.Snap.Hguides, Self.Snap.Visible_Hguides);
       else
-         C := Self.Snap.Vguides.First;
-         while Has_Element (C) loop
-            Self.Snap.Vguides.Update_Element (C, Update_Guide'Access);
-            Next (C);
-         end loop;
+         Snap (Self.Snap.Vguides, Self.Snap.Visible_Vguides);
       end if;
 
       return Result;
@@ -1005,38 +1091,41 @@ package body Gtkada.Canvas_View.Views is
       Context  : Draw_Context;
       For_Item : not null access Abstract_Item_Record'Class)
    is
-      use Smart_Guide_Lists;
       Box    : constant Model_Rectangle := For_Item.Model_Bounding_Box;
-      C      : Smart_Guide_Lists.Cursor;
-      Guide  : Smart_Guide;
+      Screen : constant Model_Rectangle := Self.Get_Visible_Area;
       From, To : Model_Coordinate;
    begin
-      C := Self.Snap.Hguides.First;
-      while Has_Element (C) loop
-         Guide := Element (C);
-         if Guide.Visible then
-            From := Model_Coordinate'Min (Guide.Min, Box.X);
-            To   := Model_Coordinate'Max (Guide.Max, Box.X + Box.Width);
+      --  Only draw the part of the guides that is on screen: they can span
+      --  the whole model when the view is zoomed out.
+
+      for Guide of Self.Snap.Visible_Hguides loop
+         if Guide.Pos >= Screen.Y
+           and then Guide.Pos <= Screen.Y + Screen.Height
+         then
+            From := Model_Coordinate'Max
+              (Model_Coordinate'Min (Guide.Min, Box.X), Screen.X);
+            To   := Model_Coordinate'Min
+              (Model_Coordinate'Max (Guide.Max, Box.X + Box.Width),
+               Screen.X + Screen.Width);
             Self.Snap.Style.Draw_Polyline
               (Cr     => Context.Cr,
                Points => ((From, Guide.Pos), (To, Guide.Pos)));
          end if;
-
-         Next (C);
       end loop;
 
-      C := Self.Snap.Vguides.First;
-      while Has_Element (C) loop
-         Guide := Element (C);
-         if Guide.Visible then
-            From := Model_Coordinate'Min (Guide.Min, Box.Y);
-            To   := Model_Coordinate'Max (Guide.Max, Box.Y + Box.Height);
+      for Guide of Self.Snap.Visible_Vguides loop
+         if Guide.Pos >= Screen.X
+           and then Guide.Pos <= Screen.X + Screen.Width
+         then
+            From := Model_Coordinate'Max
+              (Model_Coordinate'Min (Guide.Min, Box.Y), Screen.Y);
+            To   := Model_Coordinate'Min
+              (Model_Coordinate'Max (Guide.Max, Box.Y + Box.Height),
+               Screen.Y + Screen.Height);
             Self.Snap.Style.Draw_Polyline
               (Cr     => Context.Cr,
                Points => ((Guide.Pos, From), (Guide.Pos, To)));
          end if;
-
-         Next (C);
       end loop;
    end Draw_Visible_Smart_Guides;
 
@@ -1068,6 +1157,133 @@ package body Gtkada.Canvas_View.Views is
       Self.On_Item_Event (On_Minimap_Item_Event'Access);
    end Initialize;
 
+   -----------------------
+   -- Discard_Thumbnail --
+   -----------------------
+
+   procedure Discard_Thumbnail
+     (Self : not null access Minimap_View_Record'Class) is
+   begin
+      if Self.Thumbnail /= Null_Surface then
+         Cairo.Surface.Destroy (Self.Thumbnail);
+         Self.Thumbnail := Null_Surface;
+      end if;
+
+      Self.Thumbnail_Damage := No_Rectangle;
+   end Discard_Thumbnail;
+
+   ----------------------
+   -- Damage_Thumbnail --
+   ----------------------
+
+   procedure Damage_Thumbnail
+     (Self : not null access Minimap_View_Record'Class;
+      Item : access Abstract_Item_Record'Class)
+   is
+   begin
+      if Item = null then
+         Discard_Thumbnail (Self);
+      else
+         Damage_Thumbnail (Self, Item.Model_Bounding_Box);
+      end if;
+   end Damage_Thumbnail;
+
+   procedure Damage_Thumbnail
+     (Self : not null access Minimap_View_Record'Class;
+      Area : Model_Rectangle)
+   is
+      --  Items can draw outside of their bounding box (selection outline,
+      --  arrows,...)
+      Margin : constant Model_Coordinate := 16.0;
+      Box    : constant Model_Rectangle :=
+        (Area.X - Margin, Area.Y - Margin,
+         Area.Width + 2.0 * Margin, Area.Height + 2.0 * Margin);
+   begin
+      if Self.Thumbnail = Null_Surface then
+         return;
+      elsif Self.Thumbnail_Damage = No_Rectangle then
+         Self.Thumbnail_Damage := Box;
+      else
+         Union (Self.Thumbnail_Damage, Box);
+      end if;
+   end Damage_Thumbnail;
+
+   ----------------------------
+   -- Monitored_Area_Damaged --
+   ----------------------------
+
+   overriding procedure Monitored_Area_Damaged
+     (Self : not null access Minimap_View_Record;
+      Area : Model_Rectangle) is
+   begin
+      Damage_Thumbnail (Self, Area);
+      Self.Queue_Draw;
+   end Monitored_Area_Damaged;
+
+   -------------------------------
+   -- On_Minimap_Layout_Changed --
+   -------------------------------
+
+   procedure On_Minimap_Layout_Changed
+     (Minimap : not null access GObject_Record'Class) is
+   begin
+      Discard_Thumbnail (Minimap_View (Minimap));
+   end On_Minimap_Layout_Changed;
+
+   -----------------------------
+   -- On_Minimap_Item_Changed --
+   -----------------------------
+
+   procedure On_Minimap_Item_Changed
+     (Minimap : access GObject_Record'Class;
+      Item    : Abstract_Item) is
+   begin
+      Damage_Thumbnail (Minimap_View (Minimap), Item);
+   end On_Minimap_Item_Changed;
+
+   ----------------------------------
+   -- On_Minimap_Selection_Changed --
+   ----------------------------------
+
+   procedure On_Minimap_Selection_Changed
+     (Minimap : not null access GObject_Record'Class;
+      Item    : Abstract_Item) is
+   begin
+      Damage_Thumbnail (Minimap_View (Minimap), Item);
+   end On_Minimap_Selection_Changed;
+
+   -------------------
+   -- Monitor_Model --
+   -------------------
+
+   procedure Monitor_Model
+     (Self  : not null access Minimap_View_Record'Class;
+      Model : Canvas_Model) is
+   begin
+      if Self.Thumbnail_Model = Model then
+         return;
+      end if;
+
+      if Self.Thumbnail_Model /= null then
+         for Id in Self.Thumbnail_Ids'Range loop
+            Disconnect (Self.Thumbnail_Model, Self.Thumbnail_Ids (Id));
+         end loop;
+      end if;
+
+      Discard_Thumbnail (Self);
+      Self.Thumbnail_Model := Model;
+
+      if Model /= null then
+         Self.Thumbnail_Ids :=
+           (Model.On_Layout_Changed (On_Minimap_Layout_Changed'Access, Self),
+            Model.On_Item_Contents_Changed
+              (On_Minimap_Item_Changed'Access, Self),
+            Model.On_Item_Destroyed (On_Minimap_Item_Changed'Access, Self),
+            Model.On_Selection_Changed
+              (On_Minimap_Selection_Changed'Access, Self));
+      end if;
+   end Monitor_Model;
+
    -------------
    -- Monitor --
    -------------
@@ -1076,10 +1292,18 @@ package body Gtkada.Canvas_View.Views is
      (Self : not null access Minimap_View_Record;
       View : access Canvas_View_Record'Class := null)
    is
+      C : View_Lists.Cursor;
    begin
       if Self.Monitored /= null then
          Weak_Unref (Self.Monitored, On_Monitored_Destroyed'Access,
                      Get_Object (Self));
+
+         C := Self.Monitored.Monitors.Find (Canvas_View (Self));
+         if View_Lists.Has_Element (C) then
+            Self.Monitored.Monitors.Delete (C);
+         end if;
+
+         Monitor_Model (Self, null);
          Self.Set_Model (null);
          Disconnect (Self.Monitored, Self.Viewport_Changed_Id);
       end if;
@@ -1088,6 +1312,7 @@ package body Gtkada.Canvas_View.Views is
       if View /= null then
          Weak_Ref (Self.Monitored, On_Monitored_Destroyed'Access,
                    Get_Object (Self));
+         Self.Monitored.Monitors.Append (Canvas_View (Self));
 
          Self.Viewport_Changed_Id := View.On_Viewport_Changed
              (On_Monitored_Viewport_Changed'Access, Self);
@@ -1105,8 +1330,14 @@ package body Gtkada.Canvas_View.Views is
    is
       Self : constant Minimap_View := Minimap_View (Minimap);
    begin
+      Monitor_Model (Self, Self.Monitored.Model);
       Self.Set_Model (Self.Monitored.Model);
       Self.Scale_To_Fit (Max_Scale => Gdouble'Last);
+
+      --  The thumbnail is still valid if the minimap was not scrolled or
+      --  zoomed, but the visible area needs to be drawn at its new position
+
+      Self.Queue_Draw;
    end On_Monitored_Viewport_Changed;
 
    ------------------------
@@ -1116,6 +1347,7 @@ package body Gtkada.Canvas_View.Views is
    procedure On_Destroy_Minimap (Minimap : access Gtk_Widget_Record'Class) is
    begin
       Minimap_View (Minimap).Monitor (null);
+      Discard_Thumbnail (Minimap_View (Minimap));
    end On_Destroy_Minimap;
 
    ----------------------------
@@ -1130,6 +1362,7 @@ package body Gtkada.Canvas_View.Views is
         Minimap_View (Get_User_Data_Or_Null (Minimap));
    begin
       Self.Monitored := null;
+      Monitor_Model (Self, null);
       Self.Queue_Draw;
    end On_Monitored_Destroyed;
 
@@ -1142,9 +1375,77 @@ package body Gtkada.Canvas_View.Views is
       Context : Draw_Context;
       Area    : Model_Rectangle)
    is
-      Box : Model_Rectangle;
+      Width  : constant Gint := Self.Get_Allocated_Width;
+      Height : constant Gint := Self.Get_Allocated_Height;
+      Factor : constant Gint := Self.Get_Scale_Factor;
+      Box    : Model_Rectangle;
+      Cr     : Cairo_Context;
    begin
-      Canvas_View_Record (Self.all).Draw_Internal (Context, Area); --  inherit
+      if Width <= 1 or else Height <= 1 then
+         --  Not allocated yet, no need for a thumbnail
+         Canvas_View_Record (Self.all).Draw_Internal (Context, Area);
+
+      else
+         if Self.Thumbnail /= Null_Surface
+           and then (Self.Thumbnail_Scale /= Self.Scale
+                     or else Self.Thumbnail_Topleft /= Self.Topleft
+                     or else Self.Thumbnail_Width /= Width
+                     or else Self.Thumbnail_Height /= Height
+                     or else Self.Thumbnail_Factor /= Factor)
+         then
+            Discard_Thumbnail (Self);
+         end if;
+
+         if Self.Thumbnail = Null_Surface then
+            --  Render at the resolution of the screen, but keep drawing in
+            --  logical pixels thanks to the device scale.
+
+            Self.Thumbnail := Cairo.Image_Surface.Create
+              (Cairo_Format_ARGB32, Width * Factor, Height * Factor);
+            Cairo.Surface.Set_Device_Scale
+              (Self.Thumbnail, Gdouble (Factor), Gdouble (Factor));
+            Self.Thumbnail_Scale   := Self.Scale;
+            Self.Thumbnail_Topleft := Self.Topleft;
+            Self.Thumbnail_Width   := Width;
+            Self.Thumbnail_Height  := Height;
+            Self.Thumbnail_Factor  := Factor;
+            Self.Thumbnail_Damage  := Self.Get_Visible_Area;
+         end if;
+
+         --  Render the damaged part of the model, with the same transformation
+         --  as the view.
+
+         if Self.Thumbnail_Damage /= No_Rectangle then
+            Box := Self.Thumbnail_Damage;
+            Self.Thumbnail_Damage := No_Rectangle;
+
+            Cr := Create (Self.Thumbnail);
+            Scale (Cr, Self.Scale, Self.Scale);
+            Translate (Cr, -Self.Topleft.X, -Self.Topleft.Y);
+            Rectangle (Cr, Box.X, Box.Y, Box.Width, Box.Height);
+            Clip (Cr);
+
+            Set_Operator (Cr, Cairo_Operator_Clear);
+            Paint (Cr);
+            Set_Operator (Cr, Cairo_Operator_Over);
+
+            Canvas_View_Record (Self.all).Draw_Internal
+              (Context =>
+                 (Cr     => Cr,
+                  Layout => Context.Layout,
+                  View   => Context.View,
+                  Model  => Context.Model),
+               Area    => Box);
+            Destroy (Cr);
+         end if;
+
+         Save (Context.Cr);
+         Translate (Context.Cr, Self.Topleft.X, Self.Topleft.Y);
+         Scale (Context.Cr, 1.0 / Self.Scale, 1.0 / Self.Scale);
+         Set_Source_Surface (Context.Cr, Self.Thumbnail, 0.0, 0.0);
+         Paint (Context.Cr);
+         Restore (Context.Cr);
+      end if;
 
       if Self.Monitored /= null then
          Box := Self.Monitored.Get_Visible_Area;
@@ -1290,7 +1591,22 @@ package body Gtkada.Canvas_View.Views is
       BB   : Item_Rectangle;
       X, Y : Model_Coordinate;
       Pos  : Gtkada.Style.Point;
+
+      procedure Queue_Draw_Dragged_Items;
+      --  Redraw the current area of the dragged items and their links
+
+      procedure Queue_Draw_Dragged_Items is
+         Cur : Item_Drag_Infos.Cursor := Self.Dragged_Items.First;
+      begin
+         while Has_Element (Cur) loop
+            Self.Queue_Draw_Item (Element (Cur).Item);
+            Next (Cur);
+         end loop;
+      end Queue_Draw_Dragged_Items;
+
    begin
+      Queue_Draw_Dragged_Items;  --  old area
+
       while Has_Element (C) loop
          It := Element (C);
 
@@ -1337,6 +1653,7 @@ package body Gtkada.Canvas_View.Views is
       end loop;
 
       Refresh_Link_Layout (Self.Model, Self.Dragged_Items);
+      Queue_Draw_Dragged_Items;  --  new area
    end Move_Dragged_Items;
 
    -------------------
@@ -1596,17 +1913,169 @@ package body Gtkada.Canvas_View.Views is
       return 0;
    end Execute;
 
-   ------------------------
-   -- On_Animate_Destroy --
-   ------------------------
+   ----------
+   -- Hash --
+   ----------
+
+   function Hash (Owner : System.Address) return Ada.Containers.Hash_Type is
+   begin
+      return Ada.Containers.Hash_Type
+        (To_Integer (Owner)
+         mod Integer_Address (Ada.Containers.Hash_Type'Last));
+   end Hash;
+
+   -----------
+   -- Owner --
+   -----------
+
+   function Owner
+     (Anim : not null access Animator'Class) return System.Address is
+   begin
+      if Anim.Item /= null then
+         return Anim.Item.all'Address;
+      elsif Anim.View /= null then
+         return Anim.View.all'Address;
+      else
+         return Null_Address;
+      end if;
+   end Owner;
+
+   ---------------------
+   -- Remove_Animator --
+   ---------------------
+
+   procedure Remove_Animator
+     (Data : not null Animation_Data_Access;
+      C    : in out Animator_Lists.Cursor)
+   is
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Animator'Class, Animator_Access);
+
+      Anim  : Animator_Access := Element (C);
+      S     : Slot_Maps.Cursor;
+      Empty : Boolean := False;
+   begin
+      if Anim = null then
+         return;  --  already removed during the current iteration
+      end if;
+
+      S := Data.Slots.Find (Owner (Anim));
+      if Slot_Maps.Has_Element (S) then
+         declare
+            Slot : Slot_Lists.List renames
+              Data.Slots.Reference (S).Element.all;
+            P    : Slot_Lists.Cursor := Slot.Find (C);
+         begin
+            if Slot_Lists.Has_Element (P) then
+               Slot.Delete (P);
+            end if;
+            Empty := Slot.Is_Empty;
+         end;
+
+         if Empty then
+            Data.Slots.Delete (S);
+         end if;
+      end if;
+
+      if Data.Running /= 0 then
+         Data.Queue.Replace_Element (C, null);
+         Data.Removed.Append (Anim);
+         return;
+      end if;
+
+      if Data.Current = C then
+         Next (Data.Current);
+      end if;
+
+      Data.Queue.Delete (C);
+      Anim.Destroy;
+      Unchecked_Free (Anim);
+   end Remove_Animator;
+
+   -------------------
+   -- End_Iteration --
+   -------------------
+
+   procedure End_Iteration (Self : not null access Canvas_View_Record'Class)
+   is
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Animator'Class, Animator_Access);
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Base_Animation_Data'Class, Base_Animation_Data_Access);
+      Data  : constant Animation_Data_Access :=
+        Animation_Data_Access (Self.Animation_Data);
+      C, C2 : Animator_Lists.Cursor;
+      Anim  : Animator_Access;
+   begin
+      Data.Running := Data.Running - 1;
+      if Data.Running /= 0 then
+         return;
+      end if;
 
-   procedure On_Animate_Destroy (View : in out Canvas_View) is
+      C := Data.Queue.First;
+      while Has_Element (C) loop
+         C2 := C;
+         Next (C);
+
+         if Element (C2) = null then
+            if Data.Current = C2 then
+               Next (Data.Current);
+            end if;
+            Data.Queue.Delete (C2);
+         end if;
+      end loop;
+
+      while not Data.Removed.Is_Empty loop
+         Anim := Data.Removed.First_Element;
+         Data.Removed.Delete_First;
+         Anim.Destroy;
+         Unchecked_Free (Anim);
+      end loop;
+
+      if Data.Stopped then
+         Data.Stopped := False;
+
+         --  Animators might have been started after Stop_Animation
+
+         if Data.Queue.Is_Empty then
+            Unchecked_Free (Self.Animation_Data);
+         end if;
+      end if;
+   end End_Iteration;
+
+   --------------------
+   -- Stop_Animation --
+   --------------------
+
+   procedure Stop_Animation
+     (Self : not null access Canvas_View_Record'Class)
+   is
       procedure Unchecked_Free is new Ada.Unchecked_Deallocation
         (Base_Animation_Data'Class, Base_Animation_Data_Access);
+      Data  : constant Animation_Data_Access :=
+        Animation_Data_Access (Self.Animation_Data);
+      C, C2 : Animator_Lists.Cursor;
    begin
-      View.Id_Animation := No_Source_Id;
-      Unchecked_Free (View.Animation_Data);
-   end On_Animate_Destroy;
+      if Self.Id_Animation /= 0 then
+         Self.Remove_Tick_Callback (Self.Id_Animation);
+         Self.Id_Animation := 0;
+      end if;
+
+      if Data /= null then
+         C := Data.Queue.First;
+         while Has_Element (C) loop
+            C2 := C;
+            Next (C);
+            Remove_Animator (Data, C2);
+         end loop;
+
+         if Data.Running /= 0 then
+            Data.Stopped := True;
+         else
+            Unchecked_Free (Self.Animation_Data);
+         end if;
+      end if;
+   end Stop_Animation;
 
    -----------
    -- Start --
@@ -1616,8 +2085,11 @@ package body Gtkada.Canvas_View.Views is
      (Self : access Animator'Class;
       View : not null access Canvas_View_Record'Class)
    is
-      Data : Animation_Data_Access;
-      C    : Animator_Lists.Cursor;
+      Data     : Animation_Data_Access;
+      Key      : System.Address;
+      S        : Slot_Maps.Cursor;
+      Old      : Animator_Lists.Cursor := Animator_Lists.No_Element;
+      Inserted : Boolean;
    begin
       if Self = null then
          return;
@@ -1627,42 +2099,47 @@ package body Gtkada.Canvas_View.Views is
          View.Animation_Data := new Animation_Data;
       end if;
 
-      if View.Id_Animation = No_Source_Id then
-         --  Use an idle rather than a timeout: a timeout would execute after
-         --  n milliseconds, then after (n + execution time for On_Animate)
-         --  milliseconds, and so on, so the quality of the animation degrades.
+      if View.Id_Animation = 0 then
+         --  Use the frame clock rather than an idle or a timeout: an idle
+         --  would keep the CPU busy, and a timeout would not be synchronized
+         --  with the refresh of the screen.
 
-         View.Id_Animation := View_Sources.Idle_Add
-           (On_Animate'Access,
-            Canvas_View (View),
-            Notify => On_Animate_Destroy'Access);
+         View.Id_Animation := View.Add_Tick_Callback (On_Animate_Tick'Access);
       end if;
 
       Data := Animation_Data_Access (View.Animation_Data);
+      Key  := Owner (Self);
 
       --  Do we need to remove any of the previous animators ?
 
       if Self.Is_Unique_For_Item then
-         C := Data.Queue.First;
-         while Has_Element (C) loop
-            if Element (C)'Tag = Self'Tag
-              and then Element (C).Item = Self.Item
-              and then Element (C).View = Self.View
-            then
-               if Data.Current = C then
-                  Next (Data.Current);
+         S := Data.Slots.Find (Key);
+
+         if Slot_Maps.Has_Element (S) then
+            for P of Slot_Maps.Element (S) loop
+               if Element (P)'Tag = Self'Tag
+                 and then Element (P).Item = Self.Item
+                 and then Element (P).View = Self.View
+               then
+                  --  No need to search for others, it is unique.
+                  Old := P;
+                  exit;
                end if;
+            end loop;
 
-               --  No need to search for others, it is unique.
-               Data.Queue.Delete (C);
-               exit;
-            end if;
+            if Has_Element (Old) then
+               if Element (Old) = Animator_Access (Self) then
+                  return;  --  already started
+               end if;
 
-            Next (C);
-         end loop;
+               Remove_Animator (Data, Old);
+            end if;
+         end if;
       end if;
 
       Data.Queue.Append (Animator_Access (Self));
+      Data.Slots.Insert (Key, Slot_Lists.Empty_List, S, Inserted);
+      Data.Slots.Reference (S).Append (Data.Queue.Last);
    end Start;
 
    -------------------------
@@ -1689,100 +2166,125 @@ package body Gtkada.Canvas_View.Views is
       --  once per iteration.
 
    begin
-      if not Has_Element (Data.Current) then
-         Data.Current := Data.Queue.First;
-      end if;
+      Data.Running := Data.Running + 1;
 
-      while Count < Max_Count
-        and then Has_Element (Data.Current)
-        and then (Current = No_Time or else Clock - Current < Max_Time)
-      loop
-         Anim := Element (Data.Current);
-
-         --  Move to the next element, in case the current animator is removed
-         Previous := Data.Current;
-         Next (Data.Current);
+      begin
          if not Has_Element (Data.Current) then
             Data.Current := Data.Queue.First;
          end if;
 
-         --  Initialize first time animators;
+         while Count < Max_Count
+           and then Has_Element (Data.Current)
+           and then (Current = No_Time or else Clock - Current < Max_Time)
+         loop
+            Anim := Element (Data.Current);
+
+            --  Move to the next element, in case the animator is removed
+            Previous := Data.Current;
+            Next (Data.Current);
+            if not Has_Element (Data.Current) then
+               Data.Current := Data.Queue.First;
+            end if;
 
-         if Anim.Start = No_Time then
-            Anim.Start := Current;
-         end if;
+            --  Skip the animators removed earlier in this iteration
 
-         --  Perform the animation
+            if Anim /= null then
+               --  Initialize first time animators;
 
-         if Current = No_Time then
-            Progress := 1.0;
-         else
-            Progress := (Current - Anim.Start) / Anim.Duration;
-            if Progress > 1.0 then
-               Progress := 1.0;
-            end if;
-         end if;
+               if Anim.Start = No_Time then
+                  Anim.Start := Current;
+               end if;
 
-         Local_Status := Anim.Execute (Animation_Progress (Progress));
-         Status := Local_Status or Status;
+               --  Perform the animation
 
-         if Local_Status = Needs_Refresh_Links_From_Item
-           and then (Status and Needs_Refresh_All_Links) = 0
-           and then (Status and Needs_Refresh_Layout) = 0
-         then
-            Items.Include
-              (Abstract_Item (Anim.Item),
-               Item_Drag_Info'(Item => Abstract_Item (Anim.Item), Pos => <>));
-         end if;
+               if Current = No_Time then
+                  Progress := 1.0;
+               else
+                  Progress := (Current - Anim.Start) / Anim.Duration;
+                  if Progress > 1.0 then
+                     Progress := 1.0;
+                  end if;
+               end if;
+
+               Local_Status := Anim.Execute (Animation_Progress (Progress));
+               Status := Local_Status or Status;
+
+               --  Execute might have removed the animator (and destroyed its
+               --  item), in which case there is nothing left to do with it.
+
+               if Element (Previous) = Anim then
+                  if Local_Status = Needs_Refresh_Links_From_Item
+                    and then (Status and Needs_Refresh_All_Links) = 0
+                    and then (Status and Needs_Refresh_Layout) = 0
+                  then
+                     Items.Include
+                       (Abstract_Item (Anim.Item),
+                        Item_Drag_Info'
+                          (Item => Abstract_Item (Anim.Item), Pos => <>));
+                  end if;
 
-         --  Destroy terminated animators
-         if Progress >= 1.0 then
-            Anim.Destroy;
-            Data.Queue.Delete (Previous);
-            if Data.Queue.Is_Empty then
-               Data.Current := No_Element;
+                  --  Destroy terminated animators
+                  if Progress >= 1.0 then
+                     Remove_Animator (Data, Previous);
+                  end if;
+               end if;
             end if;
-         end if;
 
-         Count := Count + 1;
-      end loop;
+            Count := Count + 1;
+         end loop;
 
-      --  No need to refresh if the canvas is being destroyed
-      if Current /= No_Time then
-         if (Status and Needs_Refresh_Layout) /= 0 then
-            Self.Model.Refresh_Layout;
-         elsif (Status and Needs_Refresh_All_Links) /= 0 then
-            Self.Model.Refresh_Link_Layout;
-            Self.Model.Layout_Changed;
-         elsif (Status and Needs_Refresh_Links_From_Item) /= 0 then
-            Self.Model.Refresh_Link_Layout (Items);
-            Self.Model.Layout_Changed;
+         --  No need to refresh if the canvas is being destroyed
+         if Current /= No_Time then
+            if (Status and Needs_Refresh_Layout) /= 0 then
+               Self.Model.Refresh_Layout;
+            elsif (Status and Needs_Refresh_All_Links) /= 0 then
+               Self.Model.Refresh_Link_Layout;
+               Self.Model.Layout_Changed;
+            elsif (Status and Needs_Refresh_Links_From_Item) /= 0 then
+               Self.Model.Refresh_Link_Layout (Items);
+               Self.Model.Layout_Changed;
+            end if;
          end if;
-      end if;
+
+      exception
+         when others =>
+            End_Iteration (Self);
+            raise;
+      end;
+
+      End_Iteration (Self);
    end Animation_Iteration;
 
-   ----------------
-   -- On_Animate --
-   ----------------
+   ---------------------
+   -- On_Animate_Tick --
+   ---------------------
 
-   function On_Animate (View : Canvas_View) return Boolean is
-      Now : constant Ada.Calendar.Time := Clock;
-      Data : constant Animation_Data_Access :=
-        Animation_Data_Access (View.Animation_Data);
+   function On_Animate_Tick
+     (Widget      : not null access Gtk_Widget_Record'Class;
+      Frame_Clock : not null access Gdk_Frame_Clock_Record'Class)
+      return Boolean
+   is
+      pragma Unreferenced (Frame_Clock);
+      procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+        (Base_Animation_Data'Class, Base_Animation_Data_Access);
+      View : constant Canvas_View := Canvas_View (Widget);
    begin
-      --  No need to do anywork if we are called too often
-      if Data.Last_Run = No_Time
-        or else (Now - Data.Last_Run > Min_Animation_Interval)
-      then
-         Data.Last_Run := Now;
-         Animation_Iteration
-           (View,
-            Current  => Now,
-            Max_Time => Duration (Animation_Interval) / 1000.0);
+      Animation_Iteration (View, Current => Clock, Max_Time => Frame_Budget);
+
+      if View.Animation_Data = null then
+         --  An animator called Terminate_Animation, which already removed
+         --  this callback.
+         return False;
+
+      elsif Animation_Data_Access (View.Animation_Data).Queue.Is_Empty then
+         --  gtk+ removes the callback when we return False
+         View.Id_Animation := 0;
+         Unchecked_Free (View.Animation_Data);
+         return False;
       end if;
 
-      return not Data.Queue.Is_Empty;
-   end On_Animate;
+      return True;
+   end On_Animate_Tick;
 
    -------------------------
    -- Terminate_Animation --
@@ -1791,12 +2293,12 @@ package body Gtkada.Canvas_View.Views is
    procedure Terminate_Animation
      (Self : not null access Canvas_View_Record'Class) is
    begin
-      if Self.Id_Animation /= No_Source_Id then
+      if Self.Animation_Data /= null then
          Animation_Iteration
            (Self,
             Current  => GNAT.Calendar.No_Time,
             Max_Time => Duration'Last);
-         Remove (Self.Id_Animation);
+         Stop_Animation (Self);
       end if;
    end Terminate_Animation;
 
@@ -1808,29 +2310,44 @@ package body Gtkada.Canvas_View.Views is
      (Self : not null access Canvas_View_Record'Class;
       Item : access Abstract_Item_Record'Class := null)
    is
-      Data  : constant Animation_Data_Access :=
+      Data : constant Animation_Data_Access :=
         Animation_Data_Access (Self.Animation_Data);
+      S     : Slot_Maps.Cursor;
       C, C2 : Animator_Lists.Cursor;
    begin
       if Data /= null then
-         C := Data.Queue.First;
-         while Has_Element (C) loop
-            C2 := C;
-            Next (C);
+         if Item /= null then
+            --  Only the slot of the item needs to be looked at
 
-            if (Item /= null and then Element (C2).Item = Item)
-              or else (Item = null and then Element (C2).View = Self)
-            then
-               if Data.Current = C2 then
-                  Next (Data.Current);
+            loop
+               S := Data.Slots.Find (Item.all'Address);
+               exit when not Slot_Maps.Has_Element (S);
+               C := Slot_Maps.Element (S).First_Element;
+               Remove_Animator (Data, C);
+            end loop;
+
+         else
+            --  The animators of the view include those of its items, which
+            --  are stored in other slots.
+
+            C := Data.Queue.First;
+            while Has_Element (C) loop
+               C2 := C;
+               Next (C);
+
+               if Element (C2) /= null
+                 and then Element (C2).View = Self
+               then
+                  Remove_Animator (Data, C2);
                end if;
+            end loop;
+         end if;
 
-               Data.Queue.Delete (C2);
-            end if;
-         end loop;
+         --  While an iteration is running, it checks for an empty queue
+         --  itself when it ends.
 
-         if Data.Queue.Is_Empty then
-            Remove (Self.Id_Animation);
+         if Data.Running = 0 and then Data.Queue.Is_Empty then
+            Stop_Animation (Self);
          end if;
       end if;
    end Terminate_Animation_For_Item;
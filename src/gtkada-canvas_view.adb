@@ -29,6 +29,7 @@ with System;
 with Cairo;                              use Cairo;
 with Cairo.Matrix;                       use Cairo.Matrix;
 with Cairo.Pattern;                      use Cairo.Pattern;
+with Cairo.Image_Surface;
 with Cairo.Png;
 with Cairo.PDF;                          use Cairo.PDF;
 with Cairo.Surface;
@@ -39,6 +40,7 @@ with Glib.Values;                        use Glib.Values;
 with Gdk;                                use Gdk;
 with Gdk.Cairo;                          use Gdk.Cairo;
 with Gdk.RGBA;                           use Gdk.RGBA;
+with Gdk.Screen;
 with Gdk.Types.Keysyms;                  use Gdk.Types.Keysyms;
 with Gdk.Window_Attr;                    use Gdk.Window_Attr;
 with Gdk.Window;                         use Gdk.Window;
@@ -90,6 +92,16 @@ package body Gtkada.Canvas_View is
    --  Minimal amount the mouse should move before we start dragging (this is
    --  the square).
 
+   Damage_Margin        : constant Model_Coordinate := 16.0;
+   Damage_Margin_Pixels : constant View_Coordinate := 4.0;
+   --  Extra area redrawn around damaged items, for the parts that are drawn
+   --  outside of their bounding box (arrow heads, shadows,...), and for the
+   --  selection outline and antialiasing.
+
+   Max_Damage_Rectangles : constant := 16;
+   --  When the area to redraw is made of more rectangles than this, we
+   --  redraw their bounding box in one go rather than each of them.
+
    Fixed_Size : constant Size := (Unit_Pixels, Gdouble'First);
    --  When this is set for the max size of an item, it indicates that the min
    --  size is in fact a hard-coded size that the widget must respect.
@@ -140,6 +152,49 @@ package body Gtkada.Canvas_View is
       Area : Model_Rectangle := No_Rectangle);
    --  Redraw the canvas (clear area, set transformation matrix and call Draw)
 
+   procedure Refresh_From_Tile_Cache
+     (Self : not null access Canvas_View_Record'Class;
+      Cr   : Cairo.Cairo_Context);
+   --  Redraw the canvas by copying the tiles from the cache, which are
+   --  rendered first if needed.
+
+   function Get_Tile
+     (Self : not null access Canvas_View_Record'Class;
+      Key  : Tile_Key) return Cairo.Cairo_Surface;
+   --  Return the image for the given tile, rendering it if it is not in the
+   --  cache. Older tiles are discarded when the cache exceeds its budget.
+
+   procedure Invalidate_Tiles
+     (Self : not null access Canvas_View_Record'Class;
+      Area : Model_Rectangle);
+   --  Discard the tiles that intersect Area
+
+   function Get_Text_Layout
+     (Self          : not null access Canvas_View_Record'Class;
+      Item          : not null access Abstract_Item_Record'Class;
+      Style         : Drawing_Style;
+      Text          : String;
+      Width, Height : Model_Coordinate) return Pango_Layout;
+   --  Return a layout prepared to draw Text with Style for Item, reusing the
+   --  one from the cache when it was prepared for the same parameters.
+   --  Return null if the cache is disabled.
+
+   procedure Discard_Text_Layout
+     (Self : not null access Canvas_View_Record'Class;
+      Item : Abstract_Item);
+   --  Free the layout cached for Item, if any
+
+   procedure Clear_Text_Layouts
+     (Self : not null access Canvas_View_Record'Class);
+   --  Free all the cached layouts
+
+   procedure On_View_Style_Updated (Self : access Gtk_Widget_Record'Class);
+   procedure On_View_Screen_Changed
+     (Self            : access Gtk_Widget_Record'Class;
+      Previous_Screen : access Gdk.Screen.Gdk_Screen_Record'Class);
+   --  The fonts or resolution of the view might have changed, so the cached
+   --  layouts need to be prepared again
+
    procedure On_Layout_Changed_For_View
      (View : not null access GObject_Record'Class);
    procedure On_Item_Contents_Changed_For_View
@@ -185,6 +240,24 @@ package body Gtkada.Canvas_View is
    --  Whether the item's size is above the visibility threshold, i.e. whether
    --  the item is visible.
 
+   function Draw_Simplified_Items (Context : Draw_Context) return Boolean
+     is (Context.View /= null
+         and then Context.View.Scale < Context.View.Detail_Threshold);
+   --  Whether items should be drawn via Draw_Simplified (see
+   --  Set_Detail_Threshold)
+
+   procedure Path_Simplified_Link
+     (Self : not null access Canvas_Link_Record'Class;
+      Cr   : Cairo_Context);
+   --  Add a polyline going through the waypoints of Self to the current path
+   --  of Cr.
+
+   function Simplified_Line_Width
+     (Self    : not null access Canvas_Link_Record'Class;
+      Context : Draw_Context) return Gdouble;
+   --  The line width used to draw Self in simplified mode. This is never
+   --  less than one pixel, so that links remain visible at small scales.
+
    procedure Resize_Fill_Pattern
      (Self : not null access Container_Item_Record'Class);
    --  Resize the fill pattern so that it extends to the whole item, instead of
@@ -195,6 +268,15 @@ package body Gtkada.Canvas_View is
       In_Model : not null access Canvas_Model_Record'Class);
    --  Free the memory used by Self
 
+   procedure Index_Link
+     (Self : not null access List_Canvas_Model_Record'Class;
+      Link : not null access Abstract_Item_Record'Class);
+   procedure Unindex_Link
+     (Self : not null access List_Canvas_Model_Record'Class;
+      Link : not null access Abstract_Item_Record'Class);
+   --  Register (or unregister) Link in the index of links attached to its
+   --  ends.
+
    function On_Button_Event
      (View  : access Gtk_Widget_Record'Class;
       Event : Gdk_Event_Button) return Boolean;
@@ -504,6 +586,7 @@ package body Gtkada.Canvas_View is
       Self  : constant Canvas_View := Canvas_View (View);
       Alloc : Gtk_Allocation;
    begin
+      Invalidate_Tile_Cache (Self);
       Self.Get_Allocation (Alloc);
 
       --  On_Adjustments_Set will be called anyway when Size_Allocate is called
@@ -525,10 +608,46 @@ package body Gtkada.Canvas_View is
      (View : not null access GObject_Record'Class;
       Item : Abstract_Item)
    is
-      pragma Unreferenced (Item);
-      Self  : constant Canvas_View := Canvas_View (View);
+      Self : constant Canvas_View := Canvas_View (View);
+
+      procedure Add_Selected
+        (It : not null access Abstract_Item_Record'Class);
+      --  Add a selected item to Self.Selection_Drawn
+
+      procedure Add_Selected
+        (It : not null access Abstract_Item_Record'Class) is
+      begin
+         Self.Selection_Drawn.Include (Abstract_Item (It));
+         Self.Queue_Draw_Item (It, With_Links => False);
+      end Add_Selected;
+
+      use Item_Sets;
+      C : Item_Sets.Cursor;
    begin
-      Self.Queue_Draw;
+      --  Only the items whose selection status has changed need to be
+      --  redrawn. When the whole selection changes, we redraw the items that
+      --  were previously selected, and those that are now selected.
+
+      if Item /= null then
+         Self.Queue_Draw_Item (Item, With_Links => False);
+
+         if Self.Model.Is_Selected (Item) then
+            Self.Selection_Drawn.Include (Item);
+         else
+            Self.Selection_Drawn.Exclude (Item);
+         end if;
+
+      else
+         C := Self.Selection_Drawn.First;
+         while Has_Element (C) loop
+            Self.Queue_Draw_Item (Element (C), With_Links => False);
+            Next (C);
+         end loop;
+
+         Self.Selection_Drawn.Clear;
+         Self.Model.For_Each_Item
+           (Add_Selected'Access, Selected_Only => True);
+      end if;
    end On_Selection_Changed_For_View;
 
    -----------------------------------------
@@ -539,19 +658,11 @@ package body Gtkada.Canvas_View is
      (View : access GObject_Record'Class;
       Item : Abstract_Item)
    is
-      pragma Unreferenced (Item);
       Self : constant Canvas_View := Canvas_View (View);
-
-      --  ??? Ideally we should only redraw the minimal area
---        Rect : constant View_Rectangle :=
---          Self.Model_To_View (Item.Model_Bounding_Box);
    begin
-      Self.Queue_Draw;
---        Self.Queue_Draw_Area
---          (X      => Gint (Rect.X),
---           Y      => Gint (Rect.Y),
---           Width  => Gint (Rect.Width),
---           Height => Gint (Rect.Height));
+      --  The size of the item has not changed, so its links have not moved
+
+      Self.Queue_Draw_Item (Item, With_Links => False);
    end On_Item_Contents_Changed_For_View;
 
    --------------------------------
@@ -580,6 +691,8 @@ package body Gtkada.Canvas_View is
          Cancel_Inline_Editing (Self);
       end if;
 
+      Self.Selection_Drawn.Exclude (Item);
+      Discard_Text_Layout (Self, Item);
       Terminate_Animation_For_Item (Self, Item);
    end On_Item_Destroyed_For_View;
 
@@ -624,6 +737,8 @@ package body Gtkada.Canvas_View is
       Self.On_Motion_Notify_Event (On_Motion_Notify_Event'Access);
       Self.On_Key_Press_Event (On_Key_Event'Access);
       Self.On_Scroll_Event (On_Scroll_Event'Access);
+      Self.On_Style_Updated (On_View_Style_Updated'Access);
+      Self.On_Screen_Changed (On_View_Screen_Changed'Access);
 
       Self.Set_Can_Focus (True);
 
@@ -642,7 +757,8 @@ package body Gtkada.Canvas_View is
    begin
       Context := (Cr     => Gdk.Cairo.Create (Self.Get_Window),
                   View   => Canvas_View (Self),
-                  Layout => null);
+                  Layout => null,
+                  Model  => Self.Model);
 
       Details.Toplevel_Item := Self.Model.Toplevel_Item_At
         (Details.M_Point, Context => Context);
@@ -1033,6 +1149,9 @@ package body Gtkada.Canvas_View is
       end if;
 
       Self.Model := Canvas_Model (Model);
+      Self.Selection_Drawn.Clear;
+      Invalidate_Tile_Cache (Self);
+      Clear_Text_Layouts (Self);
 
       if Self.Model /= null then
          Ref (Self.Model);
@@ -1163,6 +1282,499 @@ package body Gtkada.Canvas_View is
       return View_Class_Record.The_Type;
    end View_Get_Type;
 
+   ---------------------------
+   -- Queue_Draw_Model_Area --
+   ---------------------------
+
+   procedure Queue_Draw_Model_Area
+     (Self : not null access Canvas_View_Record'Class;
+      Area : Model_Rectangle)
+   is
+      Margin : constant Model_Coordinate :=
+        Damage_Margin + Damage_Margin_Pixels / Self.Scale;
+      Alloc  : Gtk_Allocation;
+      Rect   : View_Rectangle;
+      X1, Y1, X2, Y2 : View_Coordinate;
+   begin
+      if Area = No_Rectangle then
+         return;
+      end if;
+
+      for M of Self.Monitors loop
+         M.Monitored_Area_Damaged (Area);
+      end loop;
+
+      Invalidate_Tiles
+        (Self,
+         (Area.X - Margin, Area.Y - Margin,
+          Area.Width + 2.0 * Margin, Area.Height + 2.0 * Margin));
+
+      Self.Get_Allocation (Alloc);
+      Rect := Self.Model_To_View
+        ((Area.X - Margin, Area.Y - Margin,
+          Area.Width + 2.0 * Margin, Area.Height + 2.0 * Margin));
+
+      --  Only invalidate the visible part, which also avoids overflows when
+      --  converting to integers.
+
+      X1 := View_Coordinate'Max (Rect.X, 0.0);
+      Y1 := View_Coordinate'Max (Rect.Y, 0.0);
+      X2 := View_Coordinate'Min
+        (Rect.X + Rect.Width, View_Coordinate (Alloc.Width));
+      Y2 := View_Coordinate'Min
+        (Rect.Y + Rect.Height, View_Coordinate (Alloc.Height));
+
+      if X1 < X2 and then Y1 < Y2 then
+         Self.Queue_Draw_Area
+           (X      => Gint (View_Coordinate'Floor (X1)),
+            Y      => Gint (View_Coordinate'Floor (Y1)),
+            Width  => Gint (View_Coordinate'Ceiling (X2 - X1)) + 1,
+            Height => Gint (View_Coordinate'Ceiling (Y2 - Y1)) + 1);
+      end if;
+   end Queue_Draw_Model_Area;
+
+   ---------------------
+   -- Queue_Draw_Item --
+   ---------------------
+
+   procedure Queue_Draw_Item
+     (Self       : not null access Canvas_View_Record'Class;
+      Item       : not null access Abstract_Item_Record'Class;
+      With_Links : Boolean := True)
+   is
+      procedure Damage_Link
+        (It : not null access Abstract_Item_Record'Class);
+      --  Damage the area of a link and its labels
+
+      procedure Damage_Link
+        (It : not null access Abstract_Item_Record'Class)
+      is
+         Link : Canvas_Link;
+      begin
+         Self.Queue_Draw_Model_Area (It.Model_Bounding_Box);
+
+         if It.all in Canvas_Link_Record'Class then
+            Link := Canvas_Link (It);
+
+            if Link.Label /= null then
+               Self.Queue_Draw_Model_Area (Link.Label.Model_Bounding_Box);
+            end if;
+
+            if Link.Label_From /= null then
+               Self.Queue_Draw_Model_Area
+                 (Link.Label_From.Model_Bounding_Box);
+            end if;
+
+            if Link.Label_To /= null then
+               Self.Queue_Draw_Model_Area (Link.Label_To.Model_Bounding_Box);
+            end if;
+         end if;
+      end Damage_Link;
+
+      Toplevel : constant Abstract_Item := Item.Get_Toplevel_Item;
+      S        : Item_Sets.Set;
+   begin
+      if Toplevel.Is_Link then
+         Damage_Link (Toplevel);
+      else
+         Self.Queue_Draw_Model_Area (Toplevel.Model_Bounding_Box);
+      end if;
+
+      if With_Links and then Self.Model /= null then
+         S.Include (Toplevel);
+         Self.Model.For_Each_Link (Damage_Link'Access, From_Or_To => S);
+      end if;
+   end Queue_Draw_Item;
+
+   ----------
+   -- Hash --
+   ----------
+
+   function Hash (Key : Tile_Key) return Ada.Containers.Hash_Type is
+      use type Ada.Containers.Hash_Type;
+   begin
+      return Ada.Containers.Hash_Type'Mod (Key.Col) * 65_599
+        + Ada.Containers.Hash_Type'Mod (Key.Row);
+   end Hash;
+
+   ---------------------------
+   -- Set_Tile_Cache_Budget --
+   ---------------------------
+
+   procedure Set_Tile_Cache_Budget
+     (Self   : not null access Canvas_View_Record'Class;
+      Budget : Natural) is
+   begin
+      Self.Tile_Cache.Budget := Budget;
+      Invalidate_Tile_Cache (Self);
+      Self.Queue_Draw;
+   end Set_Tile_Cache_Budget;
+
+   ---------------------------
+   -- Get_Tile_Cache_Budget --
+   ---------------------------
+
+   function Get_Tile_Cache_Budget
+     (Self : not null access Canvas_View_Record'Class) return Natural is
+   begin
+      return Self.Tile_Cache.Budget;
+   end Get_Tile_Cache_Budget;
+
+   --------------------------------
+   -- Set_Text_Layout_Cache_Size --
+   --------------------------------
+
+   procedure Set_Text_Layout_Cache_Size
+     (Self        : not null access Canvas_View_Record'Class;
+      Max_Layouts : Natural) is
+   begin
+      Self.Text_Layouts.Max_Layouts := Max_Layouts;
+
+      while Natural (Self.Text_Layouts.Lru.Length) > Max_Layouts loop
+         Discard_Text_Layout (Self, Self.Text_Layouts.Lru.Last_Element);
+      end loop;
+   end Set_Text_Layout_Cache_Size;
+
+   --------------------------------
+   -- Get_Text_Layout_Cache_Size --
+   --------------------------------
+
+   function Get_Text_Layout_Cache_Size
+     (Self : not null access Canvas_View_Record'Class) return Natural is
+   begin
+      return Self.Text_Layouts.Max_Layouts;
+   end Get_Text_Layout_Cache_Size;
+
+   -------------------------
+   -- Discard_Text_Layout --
+   -------------------------
+
+   procedure Discard_Text_Layout
+     (Self : not null access Canvas_View_Record'Class;
+      Item : Abstract_Item)
+   is
+      Cache : Text_Layout_Cache_Data renames Self.Text_Layouts;
+      C     : Text_Layout_Maps.Cursor := Cache.Layouts.Find (Item);
+      Info  : Text_Layout_Info;
+   begin
+      if Text_Layout_Maps.Has_Element (C) then
+         Info := Text_Layout_Maps.Element (C);
+         Unref (Info.Layout);
+         Free (Info.Text);
+         Free (Info.Font.Name);
+         Cache.Lru.Delete (Info.Lru);
+         Cache.Layouts.Delete (C);
+      end if;
+   end Discard_Text_Layout;
+
+   ------------------------
+   -- Clear_Text_Layouts --
+   ------------------------
+
+   procedure Clear_Text_Layouts
+     (Self : not null access Canvas_View_Record'Class) is
+   begin
+      while not Self.Text_Layouts.Lru.Is_Empty loop
+         Discard_Text_Layout (Self, Self.Text_Layouts.Lru.First_Element);
+      end loop;
+   end Clear_Text_Layouts;
+
+   ---------------------------
+   -- On_View_Style_Updated --
+   ---------------------------
+
+   procedure On_View_Style_Updated (Self : access Gtk_Widget_Record'Class) is
+   begin
+      Clear_Text_Layouts (Canvas_View (Self));
+   end On_View_Style_Updated;
+
+   ----------------------------
+   -- On_View_Screen_Changed --
+   ----------------------------
+
+   procedure On_View_Screen_Changed
+     (Self            : access Gtk_Widget_Record'Class;
+      Previous_Screen : access Gdk.Screen.Gdk_Screen_Record'Class)
+   is
+      pragma Unreferenced (Previous_Screen);
+   begin
+      Clear_Text_Layouts (Canvas_View (Self));
+   end On_View_Screen_Changed;
+
+   ---------------------
+   -- Get_Text_Layout --
+   ---------------------
+
+   function Get_Text_Layout
+     (Self          : not null access Canvas_View_Record'Class;
+      Item          : not null access Abstract_Item_Record'Class;
+      Style         : Drawing_Style;
+      Text          : String;
+      Width, Height : Model_Coordinate) return Pango_Layout
+   is
+      Cache : Text_Layout_Cache_Data renames Self.Text_Layouts;
+      Font  : constant Font_Style := Style.Get_Font;
+      C     : Text_Layout_Maps.Cursor;
+      Info  : Text_Layout_Info;
+      Same  : Font_Style;
+   begin
+      if Cache.Max_Layouts = 0 or else Font.Name = null then
+         return null;
+      end if;
+
+      C := Cache.Layouts.Find (Abstract_Item (Item));
+
+      if Text_Layout_Maps.Has_Element (C) then
+         Info := Text_Layout_Maps.Element (C);
+
+         --  The font description is compared by value, since the style
+         --  might have been given a new one with the same attributes.
+
+         Same := Info.Font;
+         Same.Name := Font.Name;
+
+         if Info.Text.all = Text
+           and then Info.Width = Width
+           and then Info.Height = Height
+           and then Same = Font
+           and then Pango.Font.Equal (Info.Font.Name, Font.Name)
+         then
+            Cache.Lru.Splice (Before => Cache.Lru.First, Position => Info.Lru);
+            return Info.Layout;
+         end if;
+
+         Discard_Text_Layout (Self, Abstract_Item (Item));
+      end if;
+
+      if Natural (Cache.Lru.Length) >= Cache.Max_Layouts then
+         Discard_Text_Layout (Self, Cache.Lru.Last_Element);
+      end if;
+
+      Info.Layout := Self.Create_Pango_Layout;
+      Style.Prepare_Text
+        (Info.Layout, Text, Max_Width => Width, Max_Height => Height);
+      Info.Text   := new String'(Text);
+      Info.Font   := Copy (Font);
+      Info.Width  := Width;
+      Info.Height := Height;
+
+      Cache.Lru.Prepend (Abstract_Item (Item));
+      Info.Lru := Cache.Lru.First;
+      Cache.Layouts.Insert (Abstract_Item (Item), Info);
+      return Info.Layout;
+   end Get_Text_Layout;
+
+   --------------------------
+   -- Set_Detail_Threshold --
+   --------------------------
+
+   procedure Set_Detail_Threshold
+     (Self  : not null access Canvas_View_Record'Class;
+      Scale : Gdouble := 0.0) is
+   begin
+      Self.Detail_Threshold := Scale;
+      Invalidate_Tile_Cache (Self);
+      Self.Queue_Draw;
+   end Set_Detail_Threshold;
+
+   --------------------------
+   -- Get_Detail_Threshold --
+   --------------------------
+
+   function Get_Detail_Threshold
+     (Self : not null access Canvas_View_Record'Class) return Gdouble is
+   begin
+      return Self.Detail_Threshold;
+   end Get_Detail_Threshold;
+
+   ---------------------------
+   -- Invalidate_Tile_Cache --
+   ---------------------------
+
+   procedure Invalidate_Tile_Cache
+     (Self : not null access Canvas_View_Record'Class)
+   is
+      use Tile_Maps;
+      C : Tile_Maps.Cursor := Self.Tile_Cache.Tiles.First;
+   begin
+      while Has_Element (C) loop
+         Cairo.Surface.Destroy (Element (C).Surface);
+         Next (C);
+      end loop;
+
+      Self.Tile_Cache.Tiles.Clear;
+      Self.Tile_Cache.Lru.Clear;
+   end Invalidate_Tile_Cache;
+
+   ----------------------
+   -- Invalidate_Tiles --
+   ----------------------
+
+   procedure Invalidate_Tiles
+     (Self : not null access Canvas_View_Record'Class;
+      Area : Model_Rectangle)
+   is
+      Cache : Tile_Cache_Data renames Self.Tile_Cache;
+      X1 : constant Gdouble := Area.X * Cache.Scale;
+      Y1 : constant Gdouble := Area.Y * Cache.Scale;
+      X2 : constant Gdouble := (Area.X + Area.Width) * Cache.Scale;
+      Y2 : constant Gdouble := (Area.Y + Area.Height) * Cache.Scale;
+      L  : Tile_Lists.Cursor := Cache.Lru.First;
+      Next_L : Tile_Lists.Cursor;
+      Key : Tile_Key;
+      C  : Tile_Maps.Cursor;
+   begin
+      while Tile_Lists.Has_Element (L) loop
+         Next_L := Tile_Lists.Next (L);
+         Key := Tile_Lists.Element (L);
+
+         if Gdouble (Key.Col * Tile_Size) < X2
+           and then Gdouble ((Key.Col + 1) * Tile_Size) > X1
+           and then Gdouble (Key.Row * Tile_Size) < Y2
+           and then Gdouble ((Key.Row + 1) * Tile_Size) > Y1
+         then
+            C := Cache.Tiles.Find (Key);
+            Cairo.Surface.Destroy (Tile_Maps.Element (C).Surface);
+            Cache.Tiles.Delete (C);
+            Cache.Lru.Delete (L);
+         end if;
+
+         L := Next_L;
+      end loop;
+   end Invalidate_Tiles;
+
+   --------------
+   -- Get_Tile --
+   --------------
+
+   function Get_Tile
+     (Self : not null access Canvas_View_Record'Class;
+      Key  : Tile_Key) return Cairo.Cairo_Surface
+   is
+      Cache      : Tile_Cache_Data renames Self.Tile_Cache;
+      Pixels     : constant Gint := Tile_Size * Cache.Scale_Factor;
+      Tile_Bytes : constant Natural := Natural (Pixels * Pixels) * 4;
+      --  ARGB32
+      C          : constant Tile_Maps.Cursor := Cache.Tiles.Find (Key);
+      Tile       : Tile_Info;
+      Size       : Model_Coordinate;
+      Area       : Model_Rectangle;
+      Cr         : Cairo_Context;
+      Last       : Tile_Lists.Cursor;
+   begin
+      if Tile_Maps.Has_Element (C) then
+         Tile := Tile_Maps.Element (C);
+         Cache.Lru.Splice (Before => Cache.Lru.First, Position => Tile.Lru);
+         return Tile.Surface;
+      end if;
+
+      --  Render the tile. The items that are slightly outside of the tile are
+      --  also drawn, since they might have parts (arrows, shadows,...) that
+      --  extend outside of their bounding box.
+
+      Size := Gdouble (Tile_Size) / Self.Scale;
+      Area := (Gdouble (Key.Col) * Size, Gdouble (Key.Row) * Size,
+               Size, Size);
+
+      --  The tile is rendered at the resolution of the screen, but the
+      --  device scale lets us keep drawing in logical pixels.
+
+      Tile.Surface := Cairo.Image_Surface.Create
+        (Cairo_Format_ARGB32, Pixels, Pixels);
+      Cairo.Surface.Set_Device_Scale
+        (Tile.Surface,
+         Gdouble (Cache.Scale_Factor), Gdouble (Cache.Scale_Factor));
+      Cr := Create (Tile.Surface);
+      Scale (Cr, Self.Scale, Self.Scale);
+      Translate (Cr, -Area.X, -Area.Y);
+
+      begin
+         Self.Draw_Internal
+           (Context =>
+              (Cr     => Cr,
+               Layout => Self.Layout,
+               View   => Canvas_View (Self),
+               Model  => Self.Model),
+            Area    =>
+              (Area.X - Damage_Margin, Area.Y - Damage_Margin,
+               Area.Width + 2.0 * Damage_Margin,
+               Area.Height + 2.0 * Damage_Margin));
+      exception
+         when others =>
+            Destroy (Cr);
+            Cairo.Surface.Destroy (Tile.Surface);
+            raise;
+      end;
+
+      Destroy (Cr);
+
+      Cache.Lru.Prepend (Key);
+      Tile.Lru := Cache.Lru.First;
+      Cache.Tiles.Insert (Key, Tile);
+
+      --  Discard the least recently displayed tiles if we are above budget,
+      --  but always keep the new tile.
+
+      while Cache.Lru.Length > 1
+        and then Natural (Cache.Lru.Length) > Cache.Budget / Tile_Bytes
+      loop
+         Last := Cache.Lru.Last;
+         Cairo.Surface.Destroy
+           (Cache.Tiles.Element (Tile_Lists.Element (Last)).Surface);
+         Cache.Tiles.Delete (Tile_Lists.Element (Last));
+         Cache.Lru.Delete (Last);
+      end loop;
+
+      return Tile.Surface;
+   end Get_Tile;
+
+   -----------------------------
+   -- Refresh_From_Tile_Cache --
+   -----------------------------
+
+   procedure Refresh_From_Tile_Cache
+     (Self : not null access Canvas_View_Record'Class;
+      Cr   : Cairo.Cairo_Context)
+   is
+      Factor : constant Gint := Self.Get_Scale_Factor;
+      F      : constant Gdouble := Gdouble (Factor);
+
+      --  The position of the view in the pixel grid of the tiles. This is
+      --  rounded so that the tiles are copied on device pixel boundaries,
+      --  and thus without blurring.
+      Ox : constant Gdouble :=
+        Gdouble'Rounding (Self.Topleft.X * Self.Scale * F) / F;
+      Oy : constant Gdouble :=
+        Gdouble'Rounding (Self.Topleft.Y * Self.Scale * F) / F;
+      X1, Y1, X2, Y2 : Gdouble;
+      X, Y : Gdouble;
+   begin
+      if Self.Tile_Cache.Scale /= Self.Scale
+        or else Self.Tile_Cache.Scale_Factor /= Factor
+      then
+         Invalidate_Tile_Cache (Self);
+         Self.Tile_Cache.Scale := Self.Scale;
+         Self.Tile_Cache.Scale_Factor := Factor;
+      end if;
+
+      Clip_Extents (Cr, X1, Y1, X2, Y2);
+
+      for Col in Integer (Gdouble'Floor ((X1 + Ox) / Gdouble (Tile_Size)))
+        .. Integer (Gdouble'Ceiling ((X2 + Ox) / Gdouble (Tile_Size))) - 1
+      loop
+         for Row in Integer (Gdouble'Floor ((Y1 + Oy) / Gdouble (Tile_Size)))
+           .. Integer (Gdouble'Ceiling ((Y2 + Oy) / Gdouble (Tile_Size))) - 1
+         loop
+            X := Gdouble (Col * Tile_Size) - Ox;
+            Y := Gdouble (Row * Tile_Size) - Oy;
+            Set_Source_Surface (Cr, Get_Tile (Self, (Col, Row)), X, Y);
+            Cairo.Rectangle
+              (Cr, X, Y, Gdouble (Tile_Size), Gdouble (Tile_Size));
+            Fill (Cr);
+         end loop;
+      end loop;
+   end Refresh_From_Tile_Cache;
+
    --------------------------
    -- On_Adj_Value_Changed --
    --------------------------
@@ -1315,6 +1927,8 @@ package body Gtkada.Canvas_View is
    begin
       Cancel_Continuous_Scrolling (S);
       Terminate_Animation (S);
+      Invalidate_Tile_Cache (S);
+      Set_Text_Layout_Cache_Size (S, 0);
 
       if S.Model /= null then
          Unref (S.Model);
@@ -1336,13 +1950,50 @@ package body Gtkada.Canvas_View is
    is
       Self : constant Canvas_View := Canvas_View (Glib.Object.Convert (View));
       X1, Y1, X2, Y2 : Gdouble;
+      Rects : Cairo_Rectangle_List_Access;
+      R     : Cairo_Rectangle;
    begin
-      Clip_Extents (Cr, X1, Y1, X2, Y2);
+      if Self.Tile_Cache.Budget /= 0
+        and then Self.Model /= null
+        and then not Self.In_Drag
+      then
+         Refresh_From_Tile_Cache (Self, Cr);
 
-      if X2 < X1 or else Y2 < Y1 then
-         Refresh (Self, Cr);
       else
-         Refresh (Self, Cr, Self.View_To_Model ((X1, Y1, X2 - X1, Y2 - Y1)));
+         --  Only redraw the damaged region. When it is made of several
+         --  rectangles (for instance the old and new position of a dragged
+         --  item), each is drawn separately, clipped to that rectangle so
+         --  that translucent items are not drawn twice.
+
+         Rects := Copy_Clip_Rectangle_List (Cr);
+
+         if Rects.Status = Cairo_Status_Success
+           and then Rects.Num_Rectangles > 1
+           and then Rects.Num_Rectangles <= Max_Damage_Rectangles
+         then
+            for J in 0 .. Natural (Rects.Num_Rectangles) - 1 loop
+               R := Rects.Rectangles (J);
+               Save (Cr);
+               Cairo.Rectangle (Cr, R.X, R.Y, R.Width, R.Height);
+               Clip (Cr);
+               Refresh
+                 (Self, Cr,
+                  Self.View_To_Model ((R.X, R.Y, R.Width, R.Height)));
+               Restore (Cr);
+            end loop;
+
+         else
+            Clip_Extents (Cr, X1, Y1, X2, Y2);
+
+            if X2 < X1 or else Y2 < Y1 then
+               Refresh (Self, Cr);
+            else
+               Refresh
+                 (Self, Cr, Self.View_To_Model ((X1, Y1, X2 - X1, Y2 - Y1)));
+            end if;
+         end if;
+
+         Rectangle_List_Destroy (Rects);
       end if;
 
       --  We might have an inline widget, which we need to draw.
@@ -1942,7 +2593,10 @@ package body Gtkada.Canvas_View is
       --  GDK already clears the exposed area to the background color, so
       --  we do not need to clear ourselves.
 
-      C := (Cr => Cr, Layout => Self.Layout, View => Canvas_View (Self));
+      C := (Cr     => Cr,
+            Layout => Self.Layout,
+            View   => Canvas_View (Self),
+            Model  => Self.Model);
 
       Save (Cr);
       Self.Set_Transform (Cr);
@@ -1966,6 +2620,17 @@ package body Gtkada.Canvas_View is
       Canvas_Item_Record'Class (Self.all).Draw (Context);
    end Draw_As_Selected;
 
+   ---------------------
+   -- Draw_Simplified --
+   ---------------------
+
+   procedure Draw_Simplified
+     (Self    : not null access Abstract_Item_Record;
+      Context : Draw_Context) is
+   begin
+      Abstract_Item_Record'Class (Self.all).Draw (Context);
+   end Draw_Simplified;
+
    ------------------
    -- Draw_Outline --
    ------------------
@@ -2040,6 +2705,8 @@ package body Gtkada.Canvas_View is
         and then Context.View.Model.Is_Selected (Self)
       then
          Self.Draw_As_Selected (Context);
+      elsif Draw_Simplified_Items (Context) then
+         Self.Draw_Simplified (Context);
       else
          Self.Draw (Context);
       end if;
@@ -2093,6 +2760,76 @@ package body Gtkada.Canvas_View is
          S.Include (Abstract_Item (Item));
       end Add_To_Set;
 
+      Batch_Count  : Natural := 0;
+      Batch_Stroke : Gdk_RGBA := Null_RGBA;
+      Batch_Width  : Gdouble := 0.0;
+      --  The links that have been added to the current path of Context.Cr
+      --  but not stroked yet, when drawing simplified items.
+
+      procedure Flush_Links;
+      --  Stroke the links added to the path by Batch_Link
+
+      procedure Batch_Link
+        (Item : not null access Abstract_Item_Record'Class);
+      --  Draw a link in simplified mode. Consecutive links with the same
+      --  color and line width are stroked at once, which is much faster than
+      --  drawing them one by one.
+
+      procedure Flush_Links is
+      begin
+         if Batch_Count /= 0 then
+            Save (Context.Cr);
+            Set_Source_RGBA (Context.Cr, Batch_Stroke);
+            Set_Line_Width (Context.Cr, Batch_Width);
+            Set_Dash (Context.Cr, No_Dashes, 0.0);
+            Stroke (Context.Cr);
+            Restore (Context.Cr);
+            Batch_Count := 0;
+         end if;
+      end Flush_Links;
+
+      procedure Batch_Link
+        (Item : not null access Abstract_Item_Record'Class)
+      is
+         Link   : Canvas_Link;
+         Stroke : Gdk_RGBA;
+         Width  : Gdouble;
+      begin
+         if Item.all not in Canvas_Link_Record'Class
+           or else (Self.In_Drag and then S.Contains (Abstract_Item (Item)))
+           or else Self.Model.Is_Selected (Item)
+         then
+            Flush_Links;
+            Draw_Item (Item);
+            return;
+         end if;
+
+         Link := Canvas_Link (Item);
+         Stroke := Link.Style.Get_Stroke;
+         if Link.Points = null
+           or else Stroke = Null_RGBA
+           or else not Size_Above_Threshold (Link, Self)
+         then
+            return;
+         end if;
+
+         Width := Simplified_Line_Width (Link, Context);
+         if Batch_Count /= 0
+           and then (Stroke /= Batch_Stroke or else Width /= Batch_Width)
+         then
+            Flush_Links;
+         end if;
+
+         if Batch_Count = 0 then
+            New_Path (Context.Cr);
+         end if;
+
+         Path_Simplified_Link (Link, Context.Cr);
+         Batch_Stroke := Stroke;
+         Batch_Width := Width;
+         Batch_Count := Batch_Count + 1;
+      end Batch_Link;
+
       use Item_Drag_Infos, Item_Sets;
       C  : Item_Drag_Infos.Cursor;
       C2 : Item_Sets.Cursor;
@@ -2121,8 +2858,15 @@ package body Gtkada.Canvas_View is
               (Self, Context, Element (Self.Dragged_Items.First).Item);
          end if;
 
-         Self.Model.For_Each_Item
-           (Draw_Item'Access, In_Area => Area, Filter => Kind_Link);
+         if Draw_Simplified_Items (Context) then
+            Self.Model.For_Each_Item
+              (Batch_Link'Access, In_Area => Area, Filter => Kind_Link);
+            Flush_Links;
+         else
+            Self.Model.For_Each_Item
+              (Draw_Item'Access, In_Area => Area, Filter => Kind_Link);
+         end if;
+
          Self.Model.For_Each_Item
            (Draw_Item'Access, In_Area => Area, Filter => Kind_Item);
 
@@ -2246,6 +2990,59 @@ package body Gtkada.Canvas_View is
       end if;
    end Draw_As_Selected;
 
+   --------------------------
+   -- Path_Simplified_Link --
+   --------------------------
+
+   procedure Path_Simplified_Link
+     (Self : not null access Canvas_Link_Record'Class;
+      Cr   : Cairo_Context)
+   is
+      P : constant Item_Point_Array_Access := Self.Points;
+   begin
+      Move_To (Cr, P (P'First).X, P (P'First).Y);
+      for Index in P'First + 1 .. P'Last loop
+         Line_To (Cr, P (Index).X, P (Index).Y);
+      end loop;
+   end Path_Simplified_Link;
+
+   ---------------------------
+   -- Simplified_Line_Width --
+   ---------------------------
+
+   function Simplified_Line_Width
+     (Self    : not null access Canvas_Link_Record'Class;
+      Context : Draw_Context) return Gdouble is
+   begin
+      return Gdouble'Max
+        (Self.Style.Get_Line_Width, 1.0 / Context.View.Scale);
+   end Simplified_Line_Width;
+
+   ---------------------
+   -- Draw_Simplified --
+   ---------------------
+
+   overriding procedure Draw_Simplified
+     (Self    : not null access Canvas_Link_Record;
+      Context : Draw_Context)
+   is
+      Stroke : constant Gdk_RGBA := Self.Style.Get_Stroke;
+   begin
+      if Self.Points /= null
+        and then Stroke /= Null_RGBA
+        and then Context.View /= null
+        and then Size_Above_Threshold (Self, Context.View)
+      then
+         New_Path (Context.Cr);
+         Path_Simplified_Link (Self, Context.Cr);
+         Set_Source_RGBA (Context.Cr, Stroke);
+         Set_Line_Width
+           (Context.Cr, Simplified_Line_Width (Self, Context));
+         Set_Dash (Context.Cr, No_Dashes, 0.0);
+         Cairo.Stroke (Context.Cr);
+      end if;
+   end Draw_Simplified;
+
    --------------
    -- Contains --
    --------------
@@ -2469,8 +3266,70 @@ package body Gtkada.Canvas_View is
    is
    begin
       Self.Items.Append (Abstract_Item (Item));
+
+      if Item.Is_Link then
+         Index_Link (Self, Item);
+      end if;
    end Add;
 
+   ----------------
+   -- Index_Link --
+   ----------------
+
+   procedure Index_Link
+     (Self : not null access List_Canvas_Model_Record'Class;
+      Link : not null access Abstract_Item_Record'Class)
+   is
+      procedure Add_To (End_Item : Abstract_Item);
+      procedure Add_To (End_Item : Abstract_Item) is
+         C        : Link_Indexes.Cursor := Self.Links_Of.Find (End_Item);
+         Inserted : Boolean;
+      begin
+         if not Link_Indexes.Has_Element (C) then
+            Self.Links_Of.Insert
+              (End_Item, Item_Sets.Empty_Set, C, Inserted);
+         end if;
+         Self.Links_Of.Reference (C).Include (Abstract_Item (Link));
+      end Add_To;
+
+   begin
+      if Link.all in Canvas_Link_Record'Class then
+         Add_To (Canvas_Link (Link).From);
+         Add_To (Canvas_Link (Link).To);
+      else
+         Self.Custom_Links.Include (Abstract_Item (Link));
+      end if;
+   end Index_Link;
+
+   ------------------
+   -- Unindex_Link --
+   ------------------
+
+   procedure Unindex_Link
+     (Self : not null access List_Canvas_Model_Record'Class;
+      Link : not null access Abstract_Item_Record'Class)
+   is
+      procedure Remove_From (End_Item : Abstract_Item);
+      procedure Remove_From (End_Item : Abstract_Item) is
+         C : Link_Indexes.Cursor := Self.Links_Of.Find (End_Item);
+      begin
+         if Link_Indexes.Has_Element (C) then
+            Self.Links_Of.Reference (C).Exclude (Abstract_Item (Link));
+            if Self.Links_Of.Reference (C).Is_Empty then
+               Self.Links_Of.Delete (C);
+            end if;
+         end if;
+      end Remove_From;
+
+   begin
+      if Link.all in Canvas_Link_Record'Class then
+         Remove_From (Canvas_Link (Link).From);
+         Remove_From (Canvas_Link (Link).To);
+      else
+         Self.Custom_Links.Exclude (Abstract_Item (Link));
+      end if;
+   end Unindex_Link;
+
    -----------------------
    -- On_Item_Destroyed --
    -----------------------
@@ -2568,6 +3427,11 @@ package body Gtkada.Canvas_View is
          if Has_Element (C) then
             Self.Items.Delete (C);
          end if;
+
+         if It.Is_Link then
+            Unindex_Link (Self, It);
+         end if;
+         Self.Links_Of.Exclude (It);
       end loop;
 
       --  Now destroy the items
@@ -2600,8 +3464,13 @@ package body Gtkada.Canvas_View is
          end if;
       end Internal;
 
+      S : Item_Sets.Set;
    begin
-      Self.For_Each_Item (Internal'Access, Filter => Kind_Link);
+      --  For_Each_Link works on toplevel items, Internal then only keeps
+      --  the links whose ends are Item itself.
+
+      S.Include (Item.Get_Toplevel_Item);
+      Self.For_Each_Link (Internal'Access, From_Or_To => S);
 
       --  Removing the container items will call their destroy, and therefore
       --  remove all links to their children.
@@ -2638,8 +3507,11 @@ package body Gtkada.Canvas_View is
             end;
          end if;
       end Internal;
+
+      S : Item_Sets.Set;
    begin
-      Self.For_Each_Item (Internal'Access, Filter => Kind_Link);
+      S.Include (Item.Get_Toplevel_Item);
+      Self.For_Each_Link (Internal'Access, From_Or_To => S);
    end From;
 
    --------
@@ -2671,8 +3543,11 @@ package body Gtkada.Canvas_View is
             end;
          end if;
       end Internal;
+
+      S : Item_Sets.Set;
    begin
-      Self.For_Each_Item (Internal'Access, Filter => Kind_Link);
+      S.Include (Item.Get_Toplevel_Item);
+      Self.For_Each_Link (Internal'Access, From_Or_To => S);
    end To;
 
    -----------
@@ -2689,6 +3564,8 @@ package body Gtkada.Canvas_View is
       --  More efficient to clear the list first, so that 'Remove' finds no
       --  related link (since we are going to free them anyway).
       Self.Items.Clear;
+      Self.Links_Of.Clear;
+      Self.Custom_Links.Clear;
 
       while Has_Element (C) loop
          Canvas_Model_Record'Class (Self.all).Remove (Element (C));
@@ -2911,6 +3788,9 @@ package body Gtkada.Canvas_View is
       case Self.Routing is
          when Orthogonal =>
             Compute_Layout_For_Orthogonal_Link (Self, Context);
+         when Orthogonal_Avoid =>
+            Compute_Layout_For_Orthogonal_Link
+              (Self, Context, Avoid_Items => True);
          when Straight =>
             Compute_Layout_For_Straight_Link (Self, Context);
          when Arc =>
@@ -2967,6 +3847,89 @@ package body Gtkada.Canvas_View is
         (Local'Access, Filter => Kind_Link);
    end For_Each_Link;
 
+   -------------------
+   -- For_Each_Link --
+   -------------------
+
+   overriding procedure For_Each_Link
+     (Self       : not null access List_Canvas_Model_Record;
+      Callback   : not null access procedure
+        (Item : not null access Abstract_Item_Record'Class);
+      From_Or_To : Item_Sets.Set)
+   is
+      use Items_Lists;
+      Pending : Items_Lists.List;  --  the ends whose links we need to find
+      Found   : Item_Sets.Set;     --  the links found so far
+      Links   : Items_Lists.List;  --  same, in the order they were found
+      C       : Item_Sets.Cursor := From_Or_To.First;
+      It      : Abstract_Item;
+      L       : Items_Lists.Cursor;
+      Idx     : Link_Indexes.Cursor;
+
+      procedure Add_Child
+        (Child : not null access Container_Item_Record'Class);
+      procedure Add_Child
+        (Child : not null access Container_Item_Record'Class) is
+      begin
+         Pending.Append (Abstract_Item (Child));
+      end Add_Child;
+
+      procedure Add_Links (Key : Abstract_Item; Set : Item_Sets.Set);
+      procedure Add_Links (Key : Abstract_Item; Set : Item_Sets.Set) is
+         pragma Unreferenced (Key);
+         C : Item_Sets.Cursor := Set.First;
+      begin
+         while Item_Sets.Has_Element (C) loop
+            if not Found.Contains (Item_Sets.Element (C)) then
+               Found.Insert (Item_Sets.Element (C));
+               Links.Append (Item_Sets.Element (C));
+
+               --  We also need the links to that link
+               Pending.Append (Item_Sets.Element (C));
+            end if;
+            Item_Sets.Next (C);
+         end loop;
+      end Add_Links;
+
+   begin
+      --  Links might be attached to the items themselves, or to any of their
+      --  children.
+
+      while Item_Sets.Has_Element (C) loop
+         It := Item_Sets.Element (C);
+         Pending.Append (It);
+         if It.all in Container_Item_Record'Class then
+            Container_Item (It).For_Each_Child
+              (Add_Child'Access, Recursive => True);
+         end if;
+         Item_Sets.Next (C);
+      end loop;
+
+      while not Pending.Is_Empty loop
+         It := Pending.First_Element;
+         Pending.Delete_First;
+
+         Idx := Self.Links_Of.Find (It);
+         if Link_Indexes.Has_Element (Idx) then
+            Link_Indexes.Query_Element (Idx, Add_Links'Access);
+         end if;
+      end loop;
+
+      --  We do not know the ends of custom links, so always return them
+
+      C := Self.Custom_Links.First;
+      while Item_Sets.Has_Element (C) loop
+         Callback (Item_Sets.Element (C));
+         Item_Sets.Next (C);
+      end loop;
+
+      L := Links.First;
+      while Has_Element (L) loop
+         Callback (Element (L));
+         Next (L);
+      end loop;
+   end For_Each_Link;
+
    -------------------------
    -- Refresh_Link_Layout --
    -------------------------
@@ -2977,7 +3940,10 @@ package body Gtkada.Canvas_View is
    is
       S : Item_Sets.Set;
       Context : constant Draw_Context :=
-        (Cr => <>, Layout => Model.Layout, View => null);
+        (Cr     => <>,
+         Layout => Model.Layout,
+         View   => null,
+         Model  => Canvas_Model (Model));
 
       procedure Reset_Link_Layout
         (It : not null access Abstract_Item_Record'Class);
@@ -3004,6 +3970,18 @@ package body Gtkada.Canvas_View is
          end if;
       end Do_Link_Layout;
 
+      procedure Add_Link
+        (It : not null access Abstract_Item_Record'Class);
+      --  Add a link to the list of links to layout in parallel
+
+      To_Layout : Items_Lists.List;
+
+      procedure Add_Link
+        (It : not null access Abstract_Item_Record'Class) is
+      begin
+         To_Layout.Append (Abstract_Item (It));
+      end Add_Link;
+
       use Item_Drag_Infos;
       C : Item_Drag_Infos.Cursor;
 
@@ -3017,7 +3995,14 @@ package body Gtkada.Canvas_View is
       if Items.Is_Empty then
          Model.For_Each_Item
            (Reset_Link_Layout'Access, Filter => Kind_Link);
-         Model.For_Each_Item (Do_Link_Layout'Access, Filter => Kind_Link);
+
+         if Model.Parallel_Layout /= null then
+            Model.For_Each_Item (Add_Link'Access, Filter => Kind_Link);
+            Model.Parallel_Layout (To_Layout, Context, Model.Layout_Tasks);
+         else
+            Model.For_Each_Item
+              (Do_Link_Layout'Access, Filter => Kind_Link);
+         end if;
 
       else
          C := Items.First;
@@ -3027,7 +4012,15 @@ package body Gtkada.Canvas_View is
          end loop;
 
          Model.For_Each_Link (Reset_Link_Layout'Access, From_Or_To => S);
-         Model.For_Each_Link (Do_Link_Layout'Access, From_Or_To => S);
+
+         if Model.Parallel_Layout /= null then
+            Model.For_Each_Link (Add_Link'Access, From_Or_To => S);
+            Model.Parallel_Layout (To_Layout, Context, Model.Layout_Tasks);
+         else
+            Model.For_Each_Link (Do_Link_Layout'Access, From_Or_To => S);
+         end if;
+
+         Model.Items_Moved (S);
       end if;
    end Refresh_Link_Layout;
 
@@ -3040,7 +4033,10 @@ package body Gtkada.Canvas_View is
       return Draw_Context
    is
    begin
-      return (Cr => <>, Layout => Self.Layout, View => Canvas_View (Self));
+      return (Cr     => <>,
+              Layout => Self.Layout,
+              View   => Canvas_View (Self),
+              Model  => Self.Model);
    end Build_Context;
 
    --------------------
@@ -3052,7 +4048,10 @@ package body Gtkada.Canvas_View is
       Send_Signal : Boolean := True)
    is
       Context : constant Draw_Context :=
-        (Cr => <>, Layout => Self.Layout, View => null);
+        (Cr     => <>,
+         Layout => Self.Layout,
+         View   => null,
+         Model  => Canvas_Model (Self));
 
       procedure Do_Container_Layout
         (Item : not null access Abstract_Item_Record'Class);
@@ -3835,6 +4834,32 @@ package body Gtkada.Canvas_View is
       end loop;
    end Draw_Children;
 
+   ---------------------
+   -- Draw_Simplified --
+   ---------------------
+
+   overriding procedure Draw_Simplified
+     (Self    : not null access Container_Item_Record;
+      Context : Draw_Context)
+   is
+      Stroke : constant Gdk_RGBA := Self.Style.Get_Stroke;
+      Fill   : constant Cairo_Pattern := Self.Style.Get_Fill;
+   begin
+      if Fill /= Null_Pattern then
+         Resize_Fill_Pattern (Self);
+         Set_Source (Context.Cr, Fill);
+      elsif Stroke /= Null_RGBA then
+         Set_Source_RGBA (Context.Cr, Stroke);
+      end if;
+
+      if not Self.Is_Invisible then
+         Rectangle (Context.Cr, 0.0, 0.0, Self.Width, Self.Height);
+         Cairo.Fill (Context.Cr);
+      end if;
+
+      Self.Draw_Children (Context);
+   end Draw_Simplified;
+
    -------------------
    -- Gtk_New_Image --
    -------------------
@@ -4450,12 +5475,20 @@ package body Gtkada.Canvas_View is
      (Self    : not null access Text_Item_Record;
       Context : Draw_Context)
    is
-      Text : constant String := Compute_Text (Self);
+      Text   : constant String := Compute_Text (Self);
+      Layout : Pango_Layout;
    begin
       Resize_Fill_Pattern (Self);
       Self.Style.Draw_Rect (Context.Cr, (0.0, 0.0), Self.Width, Self.Height);
 
-      if Context.Layout /= null then
+      if Context.View /= null then
+         Layout := Get_Text_Layout
+           (Context.View, Self, Self.Style, Text, Self.Width, Self.Height);
+      end if;
+
+      if Layout /= null then
+         Self.Style.Draw_Layout (Context.Cr, Layout, (0.0, 0.0));
+      elsif Context.Layout /= null then
          Self.Style.Draw_Text
            (Context.Cr, Context.Layout, (0.0, 0.0), Text,
             Max_Width  => Self.Width,
@@ -4463,6 +5496,28 @@ package body Gtkada.Canvas_View is
       end if;
    end Draw;
 
+   ---------------------
+   -- Draw_Simplified --
+   ---------------------
+
+   overriding procedure Draw_Simplified
+     (Self    : not null access Text_Item_Record;
+      Context : Draw_Context)
+   is
+      Color : Gdk_RGBA := Self.Style.Get_Font.Color;
+   begin
+      Container_Item_Record (Self.all).Draw_Simplified (Context); --  inherit
+
+      if Self.Text /= null and then Self.Text.all /= "" then
+         --  A bar in the middle of the item, at half the opacity of the text
+         Color.Alpha := Color.Alpha * 0.5;
+         Set_Source_RGBA (Context.Cr, Color);
+         Rectangle
+           (Context.Cr, 0.0, Self.Height / 3.0, Self.Width, Self.Height / 3.0);
+         Cairo.Fill (Context.Cr);
+      end if;
+   end Draw_Simplified;
+
    -------------
    -- Destroy --
    -------------
@@ -4885,6 +5940,7 @@ package body Gtkada.Canvas_View is
    is
    begin
       Self.Grid_Size := Size;
+      Invalidate_Tile_Cache (Self);
    end Set_Grid_Size;
 
    --------------
@@ -4957,7 +6013,8 @@ package body Gtkada.Canvas_View is
 
       Context := (Cr     => Create (Surf),
                   Layout => Self.Layout,
-                  View   => Canvas_View (Self));
+                  View   => Canvas_View (Self),
+                  Model  => Self.Model);
 
       if Visible_Area_Only then
          Box := Self.Get_Visible_Area;
@@ -5134,6 +6191,7 @@ package body Gtkada.Canvas_View is
       Style : Gtkada.Style.Drawing_Style) is
    begin
       Self.Selection_Style := Style;
+      Invalidate_Tile_Cache (Self);
    end Set_Selection_Style;
 
    -------------------------
@@ -0,0 +1,135 @@
+------------------------------------------------------------------------------
+--                  GtkAda - Ada95 binding for Gtk+/Gnome                   --
+--                                                                          --
+--                        Copyright (C) 2018, AdaCore                       --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+with Ada.Exceptions;             use Ada.Exceptions;
+with Ada.Unchecked_Deallocation;
+
+package body Gtkada.Parallel is
+
+   ---------------------
+   -- Run_In_Parallel --
+   ---------------------
+
+   procedure Run_In_Parallel
+     (First, Last : Natural;
+      Tasks       : Positive;
+      Work        : not null access procedure (First, Last : Natural))
+   is
+      Size  : constant Integer := Last - First + 1;
+      Chunk : Positive;
+      Count : Positive;
+   begin
+      if Size <= 0 then
+         return;
+      end if;
+
+      Chunk := (Size + Integer'Min (Tasks, Size) - 1)
+        / Integer'Min (Tasks, Size);
+      Count := (Size + Chunk - 1) / Chunk;
+
+      if Count = 1 then
+         Work (First, Last);
+         return;
+      end if;
+
+      declare
+         procedure Free is new Ada.Unchecked_Deallocation
+           (Exception_Occurrence, Exception_Occurrence_Access);
+
+         protected Errors is
+            procedure Failed (E : Exception_Occurrence);
+            --  Report an exception in one of the tasks
+
+            function Get return Exception_Occurrence_Access;
+            --  The first exception reported by Failed, if any
+         private
+            Error : Exception_Occurrence_Access;
+         end Errors;
+
+         task type Worker is
+            entry Start (From, To : Natural);
+         end Worker;
+         --  Calls Work on the range given by Start
+
+         protected body Errors is
+            procedure Failed (E : Exception_Occurrence) is
+            begin
+               if Error = null then
+                  Error := Save_Occurrence (E);
+               end if;
+            end Failed;
+
+            function Get return Exception_Occurrence_Access is
+            begin
+               return Error;
+            end Get;
+         end Errors;
+
+         task body Worker is
+            F, T : Natural;
+         begin
+            accept Start (From, To : Natural) do
+               F := From;
+               T := To;
+            end Start;
+
+            Work (F, T);
+
+         exception
+            when E : others =>
+               Errors.Failed (E);
+         end Worker;
+
+         Error : Exception_Occurrence_Access;
+
+      begin
+         declare
+            Workers : array (2 .. Count) of Worker;
+         begin
+            for W in Workers'Range loop
+               Workers (W).Start
+                 (First + (W - 1) * Chunk,
+                  Integer'Min (Last, First + W * Chunk - 1));
+            end loop;
+
+            Work (First, First + Chunk - 1);
+
+         exception
+            when E : others =>
+               Errors.Failed (E);
+         end;  --  wait for all workers to terminate
+
+         Error := Errors.Get;
+         if Error /= null then
+            declare
+               E : Exception_Occurrence;
+            begin
+               Save_Occurrence (E, Error.all);
+               Free (Error);
+               Reraise_Occurrence (E);
+            end;
+         end if;
+      end;
+   end Run_In_Parallel;
+
+end Gtkada.Parallel;
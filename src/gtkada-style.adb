@@ -21,9 +21,12 @@
 --                                                                          --
 ------------------------------------------------------------------------------
 
+with Ada.Containers.Indefinite_Hashed_Maps;
 with Ada.Numerics;       use Ada.Numerics;
 with Ada.Numerics.Generic_Elementary_Functions;
+with Ada.Strings.Hash;
 with Ada.Unchecked_Deallocation;
+with System;
 
 with Glib;               use Glib;
 with Glib.Error;         use Glib.Error;
@@ -70,6 +73,60 @@ package body Gtkada.Style is
       Max_Width, Max_Height : Glib.Gdouble := -1.0);
    --  Setup the layout for the drawing style
 
+   type Text_Size is record
+      Width, Height : Gdouble;
+   end record;
+
+   package Text_Size_Maps is new Ada.Containers.Indefinite_Hashed_Maps
+     (Key_Type        => String,
+      Element_Type    => Text_Size,
+      Hash            => Ada.Strings.Hash,
+      Equivalent_Keys => "=");
+
+   type Text_Metrics_Cache is record
+      Sizes        : Text_Size_Maps.Map;
+      Max_Entries  : Natural := 50_000;
+      Hits, Misses : Natural := 0;
+
+      Context      : System.Address := System.Null_Address;
+      Serial       : Guint := 0;
+      --  The Pango context used for the last measure, and its serial number
+      --  at that time
+   end record;
+
+   Text_Metrics : Text_Metrics_Cache;
+   --  See Set_Text_Metrics_Cache_Size
+
+   procedure Increment (Counter : in out Natural);
+   pragma Inline (Increment);
+   --  Add one to Counter, which stays at Natural'Last once reached
+
+   function Pango_Layout_Get_Context
+     (Layout : System.Address) return System.Address;
+   pragma Import (C, Pango_Layout_Get_Context, "pango_layout_get_context");
+
+   function Pango_Context_Get_Serial (Context : System.Address) return Guint;
+   pragma Import (C, Pango_Context_Get_Serial, "pango_context_get_serial");
+   --  Incremented by Pango every time the context changes (fonts, resolution
+   --  or font options)
+
+   function Pango_Cairo_Context_Get_Resolution
+     (Context : System.Address) return Gdouble;
+   pragma Import
+     (C, Pango_Cairo_Context_Get_Resolution,
+      "pango_cairo_context_get_resolution");
+
+   ---------------
+   -- Increment --
+   ---------------
+
+   procedure Increment (Counter : in out Natural) is
+   begin
+      if Counter < Natural'Last then
+         Counter := Counter + 1;
+      end if;
+   end Increment;
+
    ------------
    -- To_HSV --
    ------------
@@ -1657,21 +1714,130 @@ package body Gtkada.Style is
       Width    : out Glib.Gdouble;
       Height   : out Glib.Gdouble)
    is
-      Ink_Rect, Logical_Rect : Pango_Rectangle;
-   begin
-      if Self.Data /= null and then Self.Data.Font.Name /= null then
+      use type System.Address;
+
+      procedure Measure;
+      --  Compute the size of Text with Pango
+
+      -------------
+      -- Measure --
+      -------------
+
+      procedure Measure is
+         Ink_Rect, Logical_Rect : Pango_Rectangle;
+      begin
          Setup_Layout (Self.Data.Font, Layout);
          Layout.Set_Ellipsize (Ellipsize_None);
          Layout.Set_Text (Text);
          Layout.Get_Extents (Ink_Rect, Logical_Rect);
          Width  := Gdouble (Logical_Rect.Width) / Gdouble (Pango_Scale);
          Height := Gdouble (Logical_Rect.Height) / Gdouble (Pango_Scale);
-      else
+         Increment (Text_Metrics.Misses);
+      end Measure;
+
+      Context : System.Address;
+      Serial  : Guint;
+      Pos     : Text_Size_Maps.Cursor;
+
+   begin
+      if Self.Data = null or else Self.Data.Font.Name = null then
          Width := 0.0;
          Height := 0.0;
+
+      elsif Text_Metrics.Max_Entries = 0 then
+         Measure;
+
+      else
+         Context := Pango_Layout_Get_Context (Layout.Get_Object);
+         Serial  := Pango_Context_Get_Serial (Context);
+
+         if Context = Text_Metrics.Context
+           and then Serial /= Text_Metrics.Serial
+         then
+            Text_Metrics.Sizes.Clear;
+         end if;
+
+         Text_Metrics.Context := Context;
+         Text_Metrics.Serial  := Serial;
+
+         declare
+            Key : constant String :=
+              To_String (Self.Data.Font.Name) & ASCII.LF
+              & Self.Data.Font.Line_Spacing'Img
+              & Gdouble'Image (Pango_Cairo_Context_Get_Resolution (Context))
+              & ASCII.LF & Text;
+         begin
+            Pos := Text_Metrics.Sizes.Find (Key);
+
+            if Text_Size_Maps.Has_Element (Pos) then
+               Width  := Text_Size_Maps.Element (Pos).Width;
+               Height := Text_Size_Maps.Element (Pos).Height;
+               Increment (Text_Metrics.Hits);
+
+            else
+               Measure;
+
+               if Natural (Text_Metrics.Sizes.Length) >=
+                 Text_Metrics.Max_Entries
+               then
+                  Text_Metrics.Sizes.Clear;
+               end if;
+
+               Text_Metrics.Sizes.Insert (Key, (Width, Height));
+            end if;
+         end;
       end if;
    end Measure_Text;
 
+   ---------------------------------
+   -- Set_Text_Metrics_Cache_Size --
+   ---------------------------------
+
+   procedure Set_Text_Metrics_Cache_Size (Max_Entries : Natural) is
+   begin
+      Text_Metrics.Max_Entries := Max_Entries;
+
+      if Natural (Text_Metrics.Sizes.Length) > Max_Entries then
+         Text_Metrics.Sizes.Clear;
+      end if;
+   end Set_Text_Metrics_Cache_Size;
+
+   ---------------------------------
+   -- Get_Text_Metrics_Cache_Size --
+   ---------------------------------
+
+   function Get_Text_Metrics_Cache_Size return Natural is
+   begin
+      return Text_Metrics.Max_Entries;
+   end Get_Text_Metrics_Cache_Size;
+
+   ------------------------------
+   -- Clear_Text_Metrics_Cache --
+   ------------------------------
+
+   procedure Clear_Text_Metrics_Cache is
+   begin
+      Text_Metrics.Sizes.Clear;
+   end Clear_Text_Metrics_Cache;
+
+   ----------------------------------
+   -- Get_Text_Metrics_Cache_Stats --
+   ----------------------------------
+
+   procedure Get_Text_Metrics_Cache_Stats
+     (Hits   : out Natural;
+      Misses : out Natural;
+      Reset  : Boolean := False) is
+   begin
+      Hits   := Text_Metrics.Hits;
+      Misses := Text_Metrics.Misses;
+
+      if Reset then
+         Text_Metrics.Hits := 0;
+         Text_Metrics.Misses := 0;
+      end if;
+   end Get_Text_Metrics_Cache_Stats;
+
    ---------------
    -- Draw_Text --
    ---------------
@@ -1685,17 +1851,47 @@ package body Gtkada.Style is
       Max_Width  : Glib.Gdouble := Glib.Gdouble'First;
       Max_Height : Glib.Gdouble := Glib.Gdouble'First)
    is
+   begin
+      Prepare_Text (Self, Layout, Text, Max_Width, Max_Height);
+      Draw_Layout (Self, Cr, Layout, Topleft);
+   end Draw_Text;
+
+   ------------------
+   -- Prepare_Text --
+   ------------------
+
+   procedure Prepare_Text
+     (Self       : Drawing_Style;
+      Layout     : not null access Pango.Layout.Pango_Layout_Record'Class;
+      Text       : String;
+      Max_Width  : Glib.Gdouble := Glib.Gdouble'First;
+      Max_Height : Glib.Gdouble := Glib.Gdouble'First)
+   is
    begin
       if Self.Data /= null and then Self.Data.Font.Name /= null then
          Setup_Layout (Self.Data.Font, Layout, Max_Width, Max_Height);
          Layout.Set_Ellipsize (Ellipsize_End);
          Layout.Set_Text (Text);
+      end if;
+   end Prepare_Text;
+
+   -----------------
+   -- Draw_Layout --
+   -----------------
 
+   procedure Draw_Layout
+     (Self    : Drawing_Style;
+      Cr      : Cairo.Cairo_Context;
+      Layout  : not null access Pango.Layout.Pango_Layout_Record'Class;
+      Topleft : Point)
+   is
+   begin
+      if Self.Data /= null and then Self.Data.Font.Name /= null then
          Move_To (Cr, Topleft.X, Topleft.Y);
          Show_Layout (Cr, Pango_Layout (Layout));
          New_Path (Cr);
       end if;
-   end Draw_Text;
+   end Draw_Layout;
 
    -----------------
    -- Finish_Path --
@@ -370,6 +370,16 @@ package body Create_Canvas_View_Links is
       Do_Example (Orthogonal, 150.0, 0.0);
       Do_Example (Arc,        300.0, 0.0);
       Do_Example (Curve,      450.0, 0.0);
+      Do_Example (Orthogonal_Avoid, 600.0, 0.0);
+
+      --  An obstacle that the last example goes around
+
+      declare
+         Obstacle : constant Rect_Item := Gtk_New_Rect (Black, 20.0, 20.0);
+      begin
+         Obstacle.Set_Position ((655.0, 50.0));
+         Model.Add (Obstacle);
+      end;
 
       Text := Gtk_New_Text (Font, "Link arrows and symbols");
       Text.Set_Position ((0.0, 160.0));
@@ -63,7 +63,10 @@ package body Create_Canvas_View_Rtrees is
         & " you will need to wrap that simple model with a @bRtree_Model@B,"
         & " which provides a much more efficient implementation for some of"
         & " the queries, like finding the list of items in a given region of"
-        & " the screen.";
+        & " the screen." & ASCII.LF
+        & "This demo also enables a @btile cache@B on the view, so that"
+        & " scrolling only copies images rendered earlier instead of drawing"
+        & " all the visible items again.";
    end Help;
 
    ---------
@@ -97,6 +100,9 @@ package body Create_Canvas_View_Rtrees is
       Canvas.On_Item_Event (On_Item_Event_Scroll_Background'Access);
       Canvas.On_Item_Event (On_Item_Event_Zoom'Access);
 
+      --  Cache the rendering of the view, to speed up scrolling
+      Canvas.Set_Tile_Cache_Budget (64 * 1024 * 1024);
+
       Link_Style := Gtk_New (Stroke => Black_RGBA);
 
       for Num in 0 .. Items_Count loop
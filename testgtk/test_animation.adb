@@ -0,0 +1,148 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the animation queue of the canvas: thousands of items are
+--  moved at the same time, as would happen for an animated layout. It
+--  measures the time needed to queue the animators (each of which replaces
+--  the previous animator of the same item), and the CPU time consumed while
+--  the animation runs.
+
+with Ada.Calendar;           use Ada.Calendar;
+with Ada.Execution_Time;     use Ada.Execution_Time;
+with Ada.Real_Time;
+with Ada.Text_IO;            use Ada.Text_IO;
+with Gdk.RGBA;               use Gdk.RGBA;
+with Glib;                   use Glib;
+with Glib.Main;              use Glib.Main;
+with Gtk.Main;
+with Gtk.Offscreen_Window;   use Gtk.Offscreen_Window;
+with Gtkada.Canvas_View;     use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Views; use Gtkada.Canvas_View.Views;
+with Gtkada.Style;           use Gtkada.Style;
+
+procedure Test_Animation is
+   Count    : constant := 10_000;
+   Length   : constant Duration := 1.0;
+
+   Win      : Gtk_Offscreen_Window;
+   View     : Canvas_View;
+   Model    : List_Canvas_Model;
+   Items    : array (1 .. Count) of Rect_Item;
+
+   procedure Animate_All (Offset : Gdouble);
+   --  Move all items to a new position, with animation
+
+   -----------------
+   -- Animate_All --
+   -----------------
+
+   procedure Animate_All (Offset : Gdouble) is
+   begin
+      for J in Items'Range loop
+         Start
+           (Animate_Position
+              (Items (J),
+               (Gdouble (J mod 100) * 20.0 + Offset,
+                Gdouble (J / 100) * 20.0 + Offset),
+               Duration => Length),
+            View);
+      end loop;
+   end Animate_All;
+
+   function On_Timeout return Boolean;
+   --  Stop the main loop once the animation is over
+
+   ----------------
+   -- On_Timeout --
+   ----------------
+
+   function On_Timeout return Boolean is
+   begin
+      Gtk.Main.Main_Quit;
+      return False;
+   end On_Timeout;
+
+   Style     : constant Drawing_Style := Gtk_New (Stroke => Black_RGBA);
+   Start_CPU : CPU_Time;
+   Used      : Duration;
+   Queued    : Ada.Calendar.Time;
+   Dummy     : G_Source_Id;
+   Errors    : Natural := 0;
+
+begin
+   Gtk.Main.Init;
+   Gtk_New (Model);
+
+   for J in Items'Range loop
+      Items (J) := Gtk_New_Rect (Style, 10.0, 10.0);
+      Items (J).Set_Position ((0.0, 0.0));
+      Model.Add (Items (J));
+   end loop;
+   Model.Refresh_Layout;
+
+   Gtk_New (View, Model);
+   Model.Unref;
+
+   Gtk_New (Win);
+   View.Set_Size_Request (800, 600);
+   Win.Add (View);
+   Win.Show_All;
+
+   --  Queue the animators twice: the second set replaces the first one
+
+   Queued := Ada.Calendar.Clock;
+   Animate_All (Offset => 100.0);
+   Animate_All (Offset => 0.0);
+   Put_Line
+     (Integer'Image (2 * Count) & " animators queued in"
+      & Duration'Image
+        ((Ada.Calendar.Clock - Queued) * 1000) & "ms");
+
+   --  Let the animation run for its whole duration
+
+   Start_CPU := Ada.Execution_Time.Clock;
+   Dummy := Timeout_Add
+     (Guint (Length * 1000), On_Timeout'Unrestricted_Access);
+   Gtk.Main.Main;
+   Used := Ada.Real_Time.To_Duration (Ada.Execution_Time.Clock - Start_CPU);
+   Put_Line
+     ("CPU time during the animation:" & Duration'Image (Used * 1000)
+      & "ms for" & Duration'Image (Length * 1000) & "ms");
+
+   --  Complete any remaining animator, and check the final positions
+
+   Terminate_Animation (View);
+   for J in Items'Range loop
+      if Items (J).Position /=
+        (Gdouble (J mod 100) * 20.0, Gdouble (J / 100) * 20.0)
+      then
+         Errors := Errors + 1;
+      end if;
+   end loop;
+
+   if Errors /= 0 then
+      Put_Line ("FAIL:" & Natural'Image (Errors) & " items misplaced");
+   end if;
+
+   Win.Destroy;
+end Test_Animation;
@@ -0,0 +1,133 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                        Copyright (C) 2018, AdaCore                         --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the A* path finding algorithms
+
+with Ada.Calendar;              use Ada.Calendar;
+with Ada.Numerics.Float_Random; use Ada.Numerics.Float_Random;
+with Ada.Text_IO;               use Ada.Text_IO;
+with Ada.Unchecked_Deallocation;
+with Gtkada.Canvas_View.Astar;  use Gtkada.Canvas_View.Astar;
+
+procedure Test_Astar is
+
+   type Boolean_Matrix is array (Positive range <>, Positive range <>)
+     of Boolean;
+   type Boolean_Matrix_Access is access Boolean_Matrix;
+   procedure Unchecked_Free is new Ada.Unchecked_Deallocation
+     (Boolean_Matrix, Boolean_Matrix_Access);
+
+   type Grid is record
+      Blocked : Boolean_Matrix_Access;
+   end record;
+   --  A grid where some of the cells cannot be traversed
+
+   function Cost (Self : Grid; Parent, From, To : Coordinate) return Integer;
+   function Dist (Self : Grid; P1, P2 : Coordinate) return Integer;
+   function Next is new Manhattan_Next_Point (Grid);
+
+   function Cost (Self : Grid; Parent, From, To : Coordinate) return Integer
+   is
+      pragma Unreferenced (Parent, From);
+   begin
+      if To.X not in Self.Blocked'Range (1)
+        or else To.Y not in Self.Blocked'Range (2)
+        or else Self.Blocked (To.X, To.Y)
+      then
+         return Not_Traversable;
+      end if;
+      return 1;
+   end Cost;
+
+   function Dist (Self : Grid; P1, P2 : Coordinate) return Integer is
+      pragma Unreferenced (Self);
+   begin
+      return abs (P1.X - P2.X) + abs (P1.Y - P2.Y);
+   end Dist;
+
+   function Find is new Find_Path (Grid, Cost, Next, Dist);
+   function Find_In_Grid is new Find_Path_In_Grid (Grid, Cost, Next, Dist);
+
+   procedure Benchmark (Size : Positive; Obstacles : Boolean);
+   --  Route from one corner to the other of a Size x Size grid. When
+   --  Obstacles is true, a quarter of the cells cannot be traversed.
+
+   ---------------
+   -- Benchmark --
+   ---------------
+
+   procedure Benchmark (Size : Positive; Obstacles : Boolean) is
+      G     : Grid;
+      Gen   : Generator;
+      Start : Time;
+      From  : constant Coordinate := (1, 1);
+      To    : constant Coordinate := (Size, Size);
+      Small : constant Boolean := Size <= 12;
+      --  Find_Path gives up after a few hundred points, so is only
+      --  measured on small grids.
+   begin
+      Reset (Gen, 1);
+      G.Blocked := new Boolean_Matrix (1 .. Size, 1 .. Size);
+      for X in 1 .. Size loop
+         for Y in 1 .. Size loop
+            G.Blocked (X, Y) := Obstacles and then Random (Gen) < 0.25;
+         end loop;
+      end loop;
+      G.Blocked (From.X, From.Y) := False;
+      G.Blocked (To.X, To.Y) := False;
+
+      Start := Clock;
+      declare
+         Path : constant Coordinate_Array :=
+           Find_In_Grid (G, From, To, Parent => From,
+                         Width => Size, Height => Size);
+      begin
+         Put ("A* benchmark," & Size'Img & 'x' & Size'Img
+              & (if Obstacles then " with obstacles" else "")
+              & ": heap=" & Duration'Image (Clock - Start)
+              & "s length=" & Integer'Image (Path'Length));
+      end;
+
+      if Small then
+         Start := Clock;
+         declare
+            Path : constant Coordinate_Array :=
+              Find (G, From, To, Parent => From);
+         begin
+            Put (" ordered set=" & Duration'Image (Clock - Start)
+                 & "s length=" & Integer'Image (Path'Length));
+         end;
+      end if;
+
+      New_Line;
+      Unchecked_Free (G.Blocked);
+   end Benchmark;
+
+begin
+   for Obstacles in Boolean loop
+      Benchmark (10, Obstacles);
+      Benchmark (100, Obstacles);
+      Benchmark (300, Obstacles);
+      Benchmark (1_000, Obstacles);
+   end loop;
+end Test_Astar;
@@ -0,0 +1,159 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for graph arenas: count the heap allocations done when a graph
+--  is repeatedly built, modified the way the layered layout does, and
+--  destroyed.
+
+with Ada.Calendar;                      use Ada.Calendar;
+with Ada.Numerics.Float_Random;         use Ada.Numerics.Float_Random;
+with Ada.Text_IO;                       use Ada.Text_IO;
+with Glib.Graphs;                       use Glib.Graphs;
+with Gtkada.Canvas_View;                use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Models.Layers;
+with Gtkada.Style;                      use Gtkada.Style;
+
+procedure Test_Graph_Arena is
+
+   Cycles       : constant := 10;
+   Num_Vertices : constant := 20_000;
+   Num_Edges    : constant := 60_000;
+   Split_Ratio  : constant := 10;
+   --  One edge out of Split_Ratio is replaced with a chain of three edges,
+   --  as is done for the dummy vertices of the layered layout.
+
+   Layout_Items : constant := 2_000;
+   Layout_Links : constant := 4_000;
+
+   type Vertices_Access is access Vertices_Array;
+   type Edges_Access is access Edges_Array;
+
+   procedure Run (Use_Arena : Boolean);
+   --  Build and destroy graphs, and report the allocations done for their
+   --  internal cells.
+
+   procedure Layout;
+   --  Measure the layered layout of a canvas model, which uses an arena
+
+   Gen      : Generator;
+   Vertices : constant Vertices_Access :=
+     new Vertices_Array (0 .. Num_Vertices - 1);
+   Edges    : constant Edges_Access := new Edges_Array (1 .. Num_Edges);
+
+   ---------
+   -- Run --
+   ---------
+
+   procedure Run (Use_Arena : Boolean) is
+      G           : Graph;
+      D1, D2      : Vertex_Access;
+      Start       : Time;
+      Allocations : Natural := 0;
+   begin
+      Reset (Gen, 1);
+      Set_Directed (G, True);
+      Set_Use_Arena (G, Use_Arena);
+
+      Start := Clock;
+      for C in 1 .. Cycles loop
+         for V of Vertices.all loop
+            V := new Vertex;
+            Add_Vertex (G, V);
+         end loop;
+
+         for E of Edges.all loop
+            E := new Edge;
+            Add_Edge
+              (G, E,
+               Vertices (Integer (Random (Gen) * Float (Num_Vertices - 1))),
+               Vertices (Integer (Random (Gen) * Float (Num_Vertices - 1))));
+         end loop;
+
+         for J in Edges'Range loop
+            if J mod Split_Ratio = 0 then
+               D1 := new Vertex;
+               D2 := new Vertex;
+               Add_Vertex (G, D1);
+               Add_Vertex (G, D2);
+               Add_Edge (G, Get_Src (Edges (J)), D1);
+               Add_Edge (G, D1, D2);
+               Add_Edge (G, D2, Get_Dest (Edges (J)));
+               Remove (G, Edges (J));
+            end if;
+         end loop;
+
+         Allocations := Allocations + Count_Allocations (G);
+         Destroy (G);
+      end loop;
+
+      Put_Line
+        ((if Use_Arena then "Arena:" else "Heap: ")
+         & Integer'Image (Allocations / Cycles) & " allocations per cycle,"
+         & Duration'Image ((Clock - Start) / Cycles) & "s per cycle");
+   end Run;
+
+   ------------
+   -- Layout --
+   ------------
+
+   procedure Layout is
+      Style : constant Drawing_Style := Gtk_New;
+      Model : List_Canvas_Model;
+      Items : array (1 .. Layout_Items) of Rect_Item;
+      From  : Positive;
+      To    : Positive;
+      Start : Time;
+   begin
+      Gtk_New (Model);
+
+      for J in Items'Range loop
+         Items (J) := Gtk_New_Rect (Style, Width => 40.0, Height => 20.0);
+         Model.Add (Items (J));
+      end loop;
+
+      for J in 1 .. Layout_Links loop
+         From := 1 + Integer (Random (Gen) * Float (Layout_Items - 1));
+         To := Integer'Min
+           (Layout_Items, From + 1 + Integer (Random (Gen) * 20.0));
+         Model.Add (Gtk_New (Items (From), Items (To), Style));
+      end loop;
+
+      Model.Refresh_Layout (Send_Signal => False);
+
+      Start := Clock;
+      for C in 1 .. Cycles loop
+         Gtkada.Canvas_View.Models.Layers.Layout (Model);
+      end loop;
+      Put_Line
+        ("Layered layout of" & Integer'Image (Layout_Items) & " items,"
+         & Integer'Image (Layout_Links) & " links:"
+         & Duration'Image ((Clock - Start) / Cycles) & "s per cycle");
+
+      Model.Unref;
+   end Layout;
+
+begin
+   Run (Use_Arena => False);
+   Run (Use_Arena => True);
+   Layout;
+end Test_Graph_Arena;
@@ -0,0 +1,148 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the removal of edges and vertices in Glib.Graphs
+
+with Ada.Calendar;                      use Ada.Calendar;
+with Ada.Numerics.Float_Random;         use Ada.Numerics.Float_Random;
+with Ada.Text_IO;                       use Ada.Text_IO;
+with Glib.Graphs;                       use Glib.Graphs;
+
+procedure Test_Graph_Removal is
+
+   Num_Vertices : constant := 50_000;
+   Num_Edges    : constant := 500_000;
+   Num_Hubs     : constant := 10;
+   --  One edge out of ten starts from one of the hubs, so that these have a
+   --  very high degree.
+
+   Num_Removed  : constant := Num_Edges / 10;
+
+   type Vertices_Access is access Vertices_Array;
+   type Edges_Access is access Edges_Array;
+
+   procedure Report (Msg : String; Start : Time);
+   --  Print the time elapsed since Start
+
+   function Random_Vertex return Natural;
+   --  A random vertex of the graph
+
+   G        : Graph;
+   Gen      : Generator;
+   Vertices : constant Vertices_Access :=
+     new Vertices_Array (0 .. Num_Vertices - 1);
+   Edges    : constant Edges_Access := new Edges_Array (1 .. Num_Edges);
+   Start    : Time;
+   Pos      : Positive;
+   Tmp      : Edge_Access;
+   Eit      : Edge_Iterator;
+   Degrees  : Natural;
+   Count    : Natural;
+
+   ------------
+   -- Report --
+   ------------
+
+   procedure Report (Msg : String; Start : Time) is
+   begin
+      Put_Line (Msg & ":" & Duration'Image (Clock - Start) & "s");
+   end Report;
+
+   -------------------
+   -- Random_Vertex --
+   -------------------
+
+   function Random_Vertex return Natural is
+   begin
+      return Integer (Random (Gen) * Float (Num_Vertices - 1));
+   end Random_Vertex;
+
+begin
+   Reset (Gen, 1);
+   Set_Directed (G, True);
+
+   Start := Clock;
+   for V of Vertices.all loop
+      V := new Vertex;
+      Add_Vertex (G, V);
+   end loop;
+
+   for J in Edges'Range loop
+      Edges (J) := new Edge;
+      Add_Edge
+        (G, Edges (J),
+         Source => Vertices
+           (if J mod 10 = 0 then J / 10 mod Num_Hubs else Random_Vertex),
+         Dest   => Vertices (Random_Vertex));
+   end loop;
+   Report
+     ("Build" & Integer'Image (Num_Vertices) & " vertices,"
+      & Integer'Image (Num_Edges) & " edges", Start);
+
+   --  Move a random selection of edges to the end of the array
+
+   for J in reverse Edges'Last - Num_Removed + 1 .. Edges'Last loop
+      Pos := 1 + Integer (Random (Gen) * Float (J - 1));
+      Tmp := Edges (J);
+      Edges (J) := Edges (Pos);
+      Edges (Pos) := Tmp;
+   end loop;
+
+   Start := Clock;
+   for J in Edges'Last - Num_Removed + 1 .. Edges'Last loop
+      Remove (G, Edges (J));
+   end loop;
+   Report
+     ("Remove" & Integer'Image (Num_Removed) & " random edges", Start);
+
+   Start := Clock;
+   Degrees := 0;
+   for V of Vertices.all loop
+      Degrees := Degrees + Out_Degree (G, V);
+   end loop;
+   Report ("Sum of degrees", Start);
+
+   Count := 0;
+   Eit := First (G);
+   while not At_End (Eit) loop
+      Count := Count + 1;
+      Next (Eit);
+   end loop;
+
+   if Degrees /= Num_Edges - Num_Removed or else Count /= Degrees then
+      Put_Line
+        ("Wrong number of edges:" & Integer'Image (Degrees)
+         & Integer'Image (Count));
+   end if;
+
+   Start := Clock;
+   for H in 0 .. Num_Hubs - 1 loop
+      Remove (G, Vertices (H));
+   end loop;
+   Report
+     ("Remove" & Integer'Image (Num_Hubs) & " hub vertices", Start);
+
+   Start := Clock;
+   Destroy (G);
+   Report ("Destroy", Start);
+end Test_Graph_Removal;
@@ -0,0 +1,242 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for frozen graphs: compare the algorithms of Glib.Graphs on the
+--  linked lists and on the snapshot built by Freeze.
+
+with Ada.Calendar;                      use Ada.Calendar;
+with Ada.Numerics.Float_Random;         use Ada.Numerics.Float_Random;
+with Ada.Text_IO;                       use Ada.Text_IO;
+with Glib;                              use Glib;
+with Glib.Graphs;                       use Glib.Graphs;
+with Gtkada.Canvas_View;                use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Models.Layers;
+with Gtkada.Style;                      use Gtkada.Style;
+
+procedure Test_Graph_Snapshot is
+
+   Blocks      : constant := 100;
+   Block_Size  : constant := 1_000;
+   Block_Edges : constant := 10_000;
+   --  The graph is made of independent blocks of vertices, as is typical of
+   --  call graphs. This also limits the depth of the recursive searches on
+   --  the unfrozen graph.
+
+   Layout_Items : constant := 2_000;
+   Layout_Links : constant := 4_000;
+
+   task Runner with Storage_Size => 512 * 1024 * 1024;
+   --  The algorithms store their result on the stack
+
+   task body Runner is
+      type Algorithm is
+        (Degrees, Breadth_First, Depth_First, Components, Spanning_Tree);
+
+      type Breadth_Access is access Breadth_Vertices_Array;
+      type Depth_Access is access Depth_Vertices_Array;
+      type Edges_Access is access Edges_Array;
+      type Breadth_Results is array (0 .. Blocks - 1) of Breadth_Access;
+
+      G        : Graph;
+      Gen      : Generator;
+      Vertices : array (0 .. Blocks * Block_Size - 1) of Vertex_Access;
+      Start    : Time;
+      Times    : array (Algorithm, Boolean) of Duration;
+
+      Degree_Sum : array (Boolean) of Natural := (others => 0);
+      BFS        : array (Boolean) of Breadth_Results;
+      DFS        : array (Boolean) of Depth_Access;
+      SCC        : array (Boolean) of Connected_Component_List;
+      MST        : array (Boolean) of Edges_Access;
+
+      procedure Run (Frozen : Boolean);
+      --  Run all algorithms on G, and store their results
+
+      function Same_Results (Algo : Algorithm) return Boolean;
+      --  Whether the algorithm returned the same result on the linked lists
+      --  and on the snapshot.
+
+      procedure Layout;
+      --  Measure the layered layout of a canvas model
+
+      function In_Block (Block : Natural) return Natural
+        is (Block * Block_Size
+            + Integer (Random (Gen) * Float (Block_Size - 1)));
+      --  A random vertex in the given block
+
+      ---------
+      -- Run --
+      ---------
+
+      procedure Run (Frozen : Boolean) is
+      begin
+         Start := Clock;
+         for V of Vertices loop
+            Degree_Sum (Frozen) :=
+              Degree_Sum (Frozen) + In_Degree (G, V) + Out_Degree (G, V);
+         end loop;
+         Times (Degrees, Frozen) := Clock - Start;
+
+         Start := Clock;
+         for B in Breadth_Results'Range loop
+            BFS (Frozen) (B) := new Breadth_Vertices_Array'
+              (Breadth_First_Search (G, Vertices (B * Block_Size)));
+         end loop;
+         Times (Breadth_First, Frozen) := Clock - Start;
+
+         Start := Clock;
+         DFS (Frozen) := new Depth_Vertices_Array'(Depth_First_Search (G));
+         Times (Depth_First, Frozen) := Clock - Start;
+
+         Start := Clock;
+         SCC (Frozen) := Strongly_Connected_Components (G, DFS (Frozen).all);
+         Times (Components, Frozen) := Clock - Start;
+
+         Start := Clock;
+         MST (Frozen) := new Edges_Array'(Kruskal (G));
+         Times (Spanning_Tree, Frozen) := Clock - Start;
+      end Run;
+
+      ------------------
+      -- Same_Results --
+      ------------------
+
+      function Same_Results (Algo : Algorithm) return Boolean is
+         L1 : Connected_Component_List := SCC (False);
+         L2 : Connected_Component_List := SCC (True);
+      begin
+         case Algo is
+            when Degrees =>
+               return Degree_Sum (False) = Degree_Sum (True);
+
+            when Breadth_First =>
+               for B in Breadth_Results'Range loop
+                  if BFS (False) (B).all /= BFS (True) (B).all then
+                     return False;
+                  end if;
+               end loop;
+               return True;
+
+            when Depth_First =>
+               return DFS (False).all = DFS (True).all;
+
+            when Components =>
+               while L1 /= null and then L2 /= null loop
+                  if L1.Vertices /= L2.Vertices then
+                     return False;
+                  end if;
+                  L1 := L1.Next;
+                  L2 := L2.Next;
+               end loop;
+               return L1 = null and then L2 = null;
+
+            when Spanning_Tree =>
+               return MST (False).all = MST (True).all;
+         end case;
+      end Same_Results;
+
+      ------------
+      -- Layout --
+      ------------
+
+      procedure Layout is
+         Style : constant Drawing_Style := Gtk_New;
+         Model : List_Canvas_Model;
+         Items : array (1 .. Layout_Items) of Rect_Item;
+         From  : Positive;
+         To    : Positive;
+      begin
+         Gtk_New (Model);
+
+         for J in Items'Range loop
+            Items (J) := Gtk_New_Rect (Style, Width => 40.0, Height => 20.0);
+            Model.Add (Items (J));
+         end loop;
+
+         --  Links mostly go forward, so that there are long chains of items
+         for J in 1 .. Layout_Links loop
+            From := 1 + Integer (Random (Gen) * Float (Layout_Items - 1));
+            To := Integer'Min
+              (Layout_Items, From + 1 + Integer (Random (Gen) * 20.0));
+            Model.Add (Gtk_New (Items (From), Items (To), Style));
+         end loop;
+
+         Model.Refresh_Layout (Send_Signal => False);
+
+         Start := Clock;
+         Gtkada.Canvas_View.Models.Layers.Layout (Model);
+         Put_Line
+           ("Layered layout of" & Integer'Image (Layout_Items) & " items,"
+            & Integer'Image (Layout_Links) & " links:"
+            & Duration'Image (Clock - Start) & "s");
+
+         Model.Unref;
+      end Layout;
+
+   begin
+      Reset (Gen, 1);
+      Set_Directed (G, True);
+
+      for V of Vertices loop
+         V := new Vertex;
+         Add_Vertex (G, V);
+      end loop;
+
+      for B in 0 .. Blocks - 1 loop
+         for J in 1 .. Block_Edges loop
+            Add_Edge (G, Vertices (In_Block (B)), Vertices (In_Block (B)));
+         end loop;
+      end loop;
+
+      Run (Frozen => False);
+
+      Start := Clock;
+      Freeze (G);
+      Put_Line
+        ("Freeze" & Integer'Image (Vertices'Length) & " vertices,"
+         & Integer'Image (Blocks * Block_Edges) & " edges:"
+         & Duration'Image (Clock - Start) & "s");
+
+      Run (Frozen => True);
+
+      for Algo in Algorithm loop
+         Put_Line
+           (Algorithm'Image (Algo) & ": lists="
+            & Duration'Image (Times (Algo, False)) & "s frozen="
+            & Duration'Image (Times (Algo, True)) & "s speedup="
+            & Integer'Image
+               (Integer (100.0 * Times (Algo, False)
+                         / Duration'Max (Times (Algo, True), Duration'Small)))
+            & "%" & (if Same_Results (Algo) then "" else " (RESULTS DIFFER)"));
+      end loop;
+
+      Free (SCC (False));
+      Free (SCC (True));
+      Destroy (G);
+
+      Layout;
+   end Runner;
+
+begin
+   null;
+end Test_Graph_Snapshot;
@@ -0,0 +1,138 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the incremental layered layout: a few items are added to a
+--  large model, which is then laid out again either from scratch or
+--  incrementally. This reports the time and the number of items that moved.
+
+with Ada.Calendar;                      use Ada.Calendar;
+with Ada.Numerics.Float_Random;         use Ada.Numerics.Float_Random;
+with Ada.Text_IO;                       use Ada.Text_IO;
+with Glib;                              use Glib;
+with Gtkada.Canvas_View;                use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Models.Layers;  use Gtkada.Canvas_View.Models.Layers;
+with Gtkada.Style;                      use Gtkada.Style;
+
+procedure Test_Incremental_Layout is
+
+   Num_Items : constant := 20_000;
+   Num_Added : constant := 10;
+   Window    : constant := 50;
+   --  Each item is linked from one of the Window previous items
+
+   subtype Item_Index is Positive range 1 .. Num_Items + Num_Added;
+   type Item_Array is array (Item_Index) of Rect_Item;
+   type Point_Array is array (Item_Index) of Gtkada.Style.Point;
+   type Item_Array_Access is access Item_Array;
+   type Point_Array_Access is access Point_Array;
+
+   procedure Add_Items (First, Last : Item_Index);
+   --  Add items and their link to the model
+
+   procedure Run (Name : String; Incremental : Boolean);
+   --  Layout the model again after adding new items, and report how many of
+   --  the existing items moved
+
+   Style  : constant Drawing_Style := Gtk_New;
+   Gen    : Generator;
+   Model  : List_Canvas_Model;
+   Cache  : Layout_Cache;
+   Items  : constant Item_Array_Access := new Item_Array;
+   Before : constant Point_Array_Access := new Point_Array;
+
+   ---------------
+   -- Add_Items --
+   ---------------
+
+   procedure Add_Items (First, Last : Item_Index) is
+      From : Item_Index;
+   begin
+      for J in First .. Last loop
+         Items (J) := Gtk_New_Rect (Style, Width => 40.0, Height => 20.0);
+         Model.Add (Items (J));
+
+         if J > 1 then
+            From := Integer'Max
+              (1, J - 1 - Integer (Random (Gen) * Float (Window - 1)));
+            Model.Add (Gtk_New (Items (From), Items (J), Style));
+         end if;
+      end loop;
+      Model.Refresh_Layout (Send_Signal => False);
+   end Add_Items;
+
+   ---------
+   -- Run --
+   ---------
+
+   procedure Run (Name : String; Incremental : Boolean) is
+      Start   : Time;
+      Elapsed : Duration;
+      Moved   : Natural := 0;
+   begin
+      --  Start from the same layout for both runs
+
+      for J in 1 .. Num_Items loop
+         Items (J).Set_Position (Before (J));
+      end loop;
+
+      Start := Clock;
+      if Incremental then
+         Incremental_Layout (Model, Cache);
+      else
+         Layout (Model);
+      end if;
+      Elapsed := Clock - Start;
+
+      for J in 1 .. Num_Items loop
+         if Items (J).Position /= Before (J) then
+            Moved := Moved + 1;
+         end if;
+      end loop;
+
+      Put_Line
+        (Name & ":" & Duration'Image (Elapsed) & "s,"
+         & Moved'Img & " of" & Integer'Image (Num_Items) & " items moved");
+   end Run;
+
+   Start : Time;
+
+begin
+   Reset (Gen, 1);
+   Gtk_New (Model);
+   Add_Items (1, Num_Items);
+
+   Start := Clock;
+   Incremental_Layout (Model, Cache);
+   Put_Line ("initial layout:" & Duration'Image (Clock - Start) & "s");
+
+   for J in 1 .. Num_Items loop
+      Before (J) := Items (J).Position;
+   end loop;
+
+   Add_Items (Num_Items + 1, Item_Index'Last);
+   Run ("full layout", Incremental => False);
+   Run ("incremental layout", Incremental => True);
+
+   Free (Cache);
+   Model.Unref;
+end Test_Incremental_Layout;
@@ -0,0 +1,201 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the ordering of items within layers in the layered layout:
+--  compare the number of edge crossings and the time for several settings.
+
+with Ada.Calendar;                      use Ada.Calendar;
+with Ada.Numerics.Float_Random;         use Ada.Numerics.Float_Random;
+with Ada.Text_IO;                       use Ada.Text_IO;
+with System.Multiprocessors;            use System.Multiprocessors;
+with Glib;                              use Glib;
+with Gtkada.Canvas_View;                use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Models.Layers;
+with Gtkada.Parallel;                   use Gtkada.Parallel;
+with Gtkada.Style;                      use Gtkada.Style;
+
+procedure Test_Layer_Ordering is
+
+   Num_Layers : constant := 20;
+   Layer_Size : constant := 1_000;
+   --  Each item is linked to two items of the next layer. All links join
+   --  adjacent layers, so that the layout keeps the layers below.
+
+   subtype Layer_Index is Natural range 0 .. Num_Layers - 1;
+   subtype Item_Index is Natural range 0 .. Layer_Size - 1;
+
+   type Link_Info is record
+      From, To : Item_Index;
+   end record;
+   type Link_Array is array (Layer_Index, 1 .. 2 * Layer_Size) of Link_Info;
+   type Item_Array is array (Layer_Index, Item_Index) of Rect_Item;
+   type Position_Array is array (Layer_Index, Item_Index) of Gdouble;
+
+   type Link_Array_Access is access Link_Array;
+   type Item_Array_Access is access Item_Array;
+   type Position_Array_Access is access Position_Array;
+
+   procedure Run
+     (Name        : String;
+      Sweeps      : Positive := 8;
+      Tasks       : Positive := 1;
+      Transpose   : Boolean := False;
+      Time_Budget : Duration := Duration'Last);
+   --  Layout the model with the given settings, and report the number of
+   --  crossings.
+
+   Style     : constant Drawing_Style := Gtk_New;
+   Gen       : Generator;
+   Model     : List_Canvas_Model;
+   Items     : constant Item_Array_Access := new Item_Array;
+   Links     : constant Link_Array_Access := new Link_Array;
+   Reference : constant Position_Array_Access := new Position_Array;
+   Perm      : array (Item_Index) of Item_Index;
+   Pos       : Item_Index;
+   Tmp       : Item_Index;
+
+   ---------
+   -- Run --
+   ---------
+
+   procedure Run
+     (Name        : String;
+      Sweeps      : Positive := 8;
+      Tasks       : Positive := 1;
+      Transpose   : Boolean := False;
+      Time_Budget : Duration := Duration'Last)
+   is
+      Start     : constant Time := Clock;
+      Elapsed   : Duration;
+      Crossings : Natural := 0;
+      Same      : Boolean := True;
+      L1, L2    : Link_Info;
+
+      Default_Sweeps : constant Boolean := Sweeps = 8 and then not Transpose;
+      --  The result should then not depend on the number of tasks
+
+      function Y (Layer : Layer_Index; Item : Item_Index) return Gdouble
+        is (Items (Layer, Item).Position.Y);
+
+   begin
+      Gtkada.Canvas_View.Models.Layers.Layout
+        (Model,
+         Sweeps      => Sweeps,
+         Tasks       => Tasks,
+         Runner      => Run_In_Parallel'Access,
+         Transpose   => Transpose,
+         Time_Budget => Time_Budget);
+      Elapsed := Clock - Start;
+
+      for L in Layer_Index'First .. Layer_Index'Last - 1 loop
+         for J in Links'Range (2) loop
+            L1 := Links (L, J);
+            for K in J + 1 .. Links'Last (2) loop
+               L2 := Links (L, K);
+               if (Y (L, L1.From) - Y (L, L2.From))
+                 * (Y (L + 1, L1.To) - Y (L + 1, L2.To)) < 0.0
+               then
+                  Crossings := Crossings + 1;
+               end if;
+            end loop;
+         end loop;
+      end loop;
+
+      --  The run with one task is the reference for the runs with several
+      --  tasks.
+
+      if Default_Sweeps then
+         for L in Layer_Index loop
+            for J in Item_Index loop
+               if Tasks = 1 then
+                  Reference (L, J) := Y (L, J);
+               elsif Reference (L, J) /= Y (L, J) then
+                  Same := False;
+               end if;
+            end loop;
+         end loop;
+      end if;
+
+      Put_Line
+        (Name & ":" & Duration'Image (Elapsed) & "s,"
+         & Natural'Image (Crossings) & " crossings"
+         & (if Same then "" else " (ORDER DIFFERS FROM 1 TASK)"));
+   end Run;
+
+begin
+   Reset (Gen, 1);
+   Gtk_New (Model);
+
+   for L in Layer_Index loop
+      for J in Item_Index loop
+         Items (L, J) := Gtk_New_Rect (Style, Width => 40.0, Height => 20.0);
+         Model.Add (Items (L, J));
+      end loop;
+   end loop;
+
+   --  The first link of each item goes to a random permutation of the next
+   --  layer, so that all items except the first layer have a parent.
+
+   for L in Layer_Index'First .. Layer_Index'Last - 1 loop
+      for J in Item_Index loop
+         Perm (J) := J;
+      end loop;
+
+      for J in reverse Item_Index'First + 1 .. Item_Index'Last loop
+         Pos := Integer (Random (Gen) * Float (J));
+         Tmp := Perm (J);
+         Perm (J) := Perm (Pos);
+         Perm (Pos) := Tmp;
+      end loop;
+
+      for J in Item_Index loop
+         Links (L, 2 * J + 1) := (From => J, To => Perm (J));
+         Links (L, 2 * J + 2) :=
+           (From => J,
+            To   => Integer (Random (Gen) * Float (Layer_Size - 1)));
+      end loop;
+
+      for J in Links'Range (2) loop
+         Model.Add
+           (Gtk_New
+              (Items (L, Links (L, J).From),
+               Items (L + 1, Links (L, J).To),
+               Style));
+      end loop;
+   end loop;
+
+   Model.Refresh_Layout (Send_Signal => False);
+
+   Run ("8 sweeps, 1 task");
+   Run ("8 sweeps," & Number_Of_CPUs'Img & " tasks",
+        Tasks => Positive (Number_Of_CPUs));
+   Run ("24 sweeps with transpose",
+        Sweeps => 24, Tasks => Positive (Number_Of_CPUs), Transpose => True);
+   Run ("24 sweeps with transpose, 2s budget",
+        Sweeps      => 24,
+        Tasks       => Positive (Number_Of_CPUs),
+        Transpose   => True,
+        Time_Budget => 2.0);
+
+   Model.Unref;
+end Test_Layer_Ordering;
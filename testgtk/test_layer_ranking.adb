@@ -0,0 +1,147 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the assignment of items to layers in the layered layout:
+--  compare the total length of the links (in number of layers) and the time
+--  for the default ranking and the network simplex.
+
+with Ada.Calendar;                      use Ada.Calendar;
+with Ada.Containers.Ordered_Maps;
+with Ada.Numerics.Float_Random;         use Ada.Numerics.Float_Random;
+with Ada.Text_IO;                       use Ada.Text_IO;
+with Glib;                              use Glib;
+with Gtkada.Canvas_View;                use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Models.Layers;
+with Gtkada.Style;                      use Gtkada.Style;
+
+procedure Test_Layer_Ranking is
+
+   Num_Items : constant := 5_000;
+   Num_Links : constant := 10_000;
+   Window    : constant := 200;
+   --  Links always go from an item to one of the next Window items, so that
+   --  the graph is acyclic and has a large number of layers.
+
+   subtype Item_Index is Positive range 1 .. Num_Items;
+   subtype Link_Index is Positive range 1 .. Num_Links;
+
+   type Link_Info is record
+      From, To : Item_Index;
+   end record;
+   type Link_Array is array (Link_Index) of Link_Info;
+   type Item_Array is array (Item_Index) of Rect_Item;
+
+   type Link_Array_Access is access Link_Array;
+   type Item_Array_Access is access Item_Array;
+
+   package Layer_Maps is new Ada.Containers.Ordered_Maps
+     (Key_Type     => Gdouble,
+      Element_Type => Natural);
+   use Layer_Maps;
+
+   procedure Run (Name : String; Optimal_Ranking : Boolean);
+   --  Layout the model, and report the total length of the links
+
+   Style : constant Drawing_Style := Gtk_New;
+   Gen   : Generator;
+   Model : List_Canvas_Model;
+   Items : constant Item_Array_Access := new Item_Array;
+   Links : constant Link_Array_Access := new Link_Array;
+   From  : Item_Index;
+
+   ---------
+   -- Run --
+   ---------
+
+   procedure Run (Name : String; Optimal_Ranking : Boolean) is
+      Start   : constant Time := Clock;
+      Elapsed : Duration;
+      Layers  : Layer_Maps.Map;
+      C       : Layer_Maps.Cursor;
+      Length  : Natural := 0;
+      Longest : Natural := 0;
+      Span    : Integer;
+
+      function Layer (Item : Item_Index) return Natural
+        is (Layers.Element (Items (Item).Position.X));
+
+   begin
+      Gtkada.Canvas_View.Models.Layers.Layout
+        (Model, Optimal_Ranking => Optimal_Ranking);
+      Elapsed := Clock - Start;
+
+      --  Items of the same layer share the same X coordinate
+
+      for J in Item_Index loop
+         Layers.Include (Items (J).Position.X, 0);
+      end loop;
+
+      C := Layers.First;
+      for L in 0 .. Natural (Layers.Length) - 1 loop
+         Layers.Replace_Element (C, L);
+         Next (C);
+      end loop;
+
+      for J in Link_Index loop
+         Span := Layer (Links (J).To) - Layer (Links (J).From);
+         if Span <= 0 then
+            Put_Line ("  link" & J'Img & " does not go forward");
+         else
+            Length := Length + Span;
+            Longest := Natural'Max (Longest, Span);
+         end if;
+      end loop;
+
+      Put_Line
+        (Name & ":" & Duration'Image (Elapsed) & "s,"
+         & Ada.Containers.Count_Type'Image (Layers.Length)
+         & " layers, total link length"
+         & Length'Img & ", longest link" & Longest'Img);
+   end Run;
+
+begin
+   Reset (Gen, 1);
+   Gtk_New (Model);
+
+   for J in Item_Index loop
+      Items (J) := Gtk_New_Rect (Style, Width => 40.0, Height => 20.0);
+      Model.Add (Items (J));
+   end loop;
+
+   for J in Link_Index loop
+      From := 1 + Integer (Random (Gen) * Float (Num_Items - 2));
+      Links (J) :=
+        (From => From,
+         To   => Integer'Min
+           (Num_Items, From + 1 + Integer (Random (Gen) * Float (Window))));
+      Model.Add
+        (Gtk_New (Items (Links (J).From), Items (Links (J).To), Style));
+   end loop;
+
+   Model.Refresh_Layout (Send_Signal => False);
+
+   Run ("tight tree", Optimal_Ranking => False);
+   Run ("network simplex", Optimal_Ranking => True);
+
+   Model.Unref;
+end Test_Layer_Ranking;
@@ -0,0 +1,181 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the parallel layout of links
+--  Benchmark for the level of detail of the canvas view: measures the time
+--  needed to render a frame at various scales, with and without simplified
+--  drawing of the items.
+
+with Ada.Calendar;           use Ada.Calendar;
+with Ada.Text_IO;            use Ada.Text_IO;
+with Cairo;                  use Cairo;
+with Cairo.Image_Surface;    use Cairo.Image_Surface;
+with Cairo.Surface;
+with Gdk.RGBA;               use Gdk.RGBA;
+with Glib;                   use Glib;
+with Gtk.Main;
+with Gtk.Offscreen_Window;   use Gtk.Offscreen_Window;
+with Gtkada.Canvas_View;     use Gtkada.Canvas_View;
+with Gtkada.Style;           use Gtkada.Style;
+
+procedure Test_Level_Of_Detail is
+   Columns : constant := 60;
+   Rows    : constant := 40;
+   Frames  : constant := 20;
+   Width   : constant := 800;
+   Height  : constant := 600;
+
+   Scales  : constant array (1 .. 3) of Gdouble := (1.0, 0.25, 0.05);
+
+   Win     : Gtk_Offscreen_Window;
+   View    : Canvas_View;
+   Model   : List_Canvas_Model;
+   Surface : Cairo_Surface;
+   Cr      : Cairo_Context;
+
+   procedure Process_Events;
+   --  Let gtk+ process all pending events
+
+   procedure Build_Model;
+   --  Create a grid of rounded rectangles with shadows, each containing a
+   --  text, and links with arrows and labels between them.
+
+   function Frame_Time return Duration;
+   --  Average time needed to render the whole view
+
+   --------------------
+   -- Process_Events --
+   --------------------
+
+   procedure Process_Events is
+      Dummy : Boolean;
+   begin
+      while Gtk.Main.Events_Pending loop
+         Dummy := Gtk.Main.Main_Iteration;
+      end loop;
+   end Process_Events;
+
+   -----------------
+   -- Build_Model --
+   -----------------
+
+   procedure Build_Model is
+      Box_Style  : constant Drawing_Style := Gtk_New
+        (Stroke => Black_RGBA,
+         Fill   => Create_Rgba_Pattern ((0.8, 0.9, 1.0, 1.0)),
+         Shadow => (Color => (0.0, 0.0, 0.0, 0.3), others => <>));
+      Text_Style : constant Drawing_Style := Gtk_New (Stroke => Null_RGBA);
+      Link_Style : constant Drawing_Style := Gtk_New
+        (Stroke   => (0.2, 0.2, 0.2, 1.0),
+         Arrow_To => (Head => Solid, Fill => Black_RGBA, others => <>));
+
+      Items : array (0 .. Columns - 1, 0 .. Rows - 1) of Rect_Item;
+      Text  : Text_Item;
+      Link  : Canvas_Link;
+   begin
+      Gtk_New (Model);
+
+      for X in Items'Range (1) loop
+         for Y in Items'Range (2) loop
+            Items (X, Y) := Gtk_New_Rect (Box_Style, Radius => 6.0);
+            Items (X, Y).Set_Position
+              ((150.0 * Gdouble (X), 100.0 * Gdouble (Y)));
+            Text := Gtk_New_Text
+              (Text_Style, "Item" & Integer'Image (X * Rows + Y));
+            Items (X, Y).Add_Child (Text);
+            Model.Add (Items (X, Y));
+
+            if X > 0 then
+               Link := Gtk_New
+                 (Items (X - 1, Y), Items (X, Y), Link_Style,
+                  Routing => Curve,
+                  Label   => Gtk_New_Text (Text_Style, "next"));
+               Model.Add (Link);
+            end if;
+
+            if Y > 0 then
+               Link := Gtk_New
+                 (Items (X, Y - 1), Items (X, Y), Link_Style,
+                  Routing => Orthogonal);
+               Model.Add (Link);
+            end if;
+         end loop;
+      end loop;
+
+      Model.Refresh_Layout;
+   end Build_Model;
+
+   ----------------
+   -- Frame_Time --
+   ----------------
+
+   function Frame_Time return Duration is
+      Start : Time;
+   begin
+      Process_Events;
+      Start := Clock;
+      for F in 1 .. Frames loop
+         View.Draw (Cr);
+      end loop;
+      Cairo.Surface.Flush (Surface);
+      return (Clock - Start) / Frames;
+   end Frame_Time;
+
+   Full, Simplified : Duration;
+
+begin
+   Gtk.Main.Init;
+   Build_Model;
+
+   Gtk_New (View, Model);
+   Model.Unref;
+
+   Gtk_New (Win);
+   View.Set_Size_Request (Width, Height);
+   Win.Add (View);
+   Win.Show_All;
+   Process_Events;
+
+   Surface := Create (Cairo_Format_ARGB32, Width, Height);
+   Cr := Create (Surface);
+
+   for S of Scales loop
+      View.Set_Scale (S);
+      View.Center_On ((75.0 * Gdouble (Columns), 50.0 * Gdouble (Rows)));
+
+      View.Set_Detail_Threshold (0.0);
+      Full := Frame_Time;
+
+      View.Set_Detail_Threshold (0.3);
+      Simplified := Frame_Time;
+
+      Put_Line
+        ("Scale" & Integer'Image (Integer (S * 100.0)) & "%:"
+         & " full=" & Duration'Image (Full * 1000) & "ms"
+         & " simplified=" & Duration'Image (Simplified * 1000) & "ms");
+   end loop;
+
+   Destroy (Cr);
+   Cairo.Surface.Destroy (Surface);
+   Win.Destroy;
+end Test_Level_Of_Detail;
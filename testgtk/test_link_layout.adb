@@ -0,0 +1,159 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the parallel layout of links
+
+with Ada.Calendar;              use Ada.Calendar;
+with Ada.Numerics.Float_Random; use Ada.Numerics.Float_Random;
+with Ada.Text_IO;               use Ada.Text_IO;
+with System.Multiprocessors;    use System.Multiprocessors;
+with Glib;                      use Glib;
+with Gtkada.Canvas_View;        use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Links.Parallel;
+use Gtkada.Canvas_View.Links.Parallel;
+with Gtkada.Style;              use Gtkada.Style;
+
+procedure Test_Link_Layout is
+   Columns    : constant := 100;
+   Rows       : constant := 50;
+   Link_Count : constant := 20_000;
+
+   type Item_Array is array (Positive range <>) of Rect_Item;
+   type Link_Array is array (Positive range <>) of Canvas_Link;
+   type Points_Array is array (Positive range <>) of Item_Point_Array_Access;
+
+   Style  : constant Drawing_Style := Gtk_New;
+   Model  : List_Canvas_Model;
+   Items  : Item_Array (1 .. Columns * Rows);
+   Links  : Link_Array (1 .. Link_Count);
+   Serial : Points_Array (1 .. Link_Count);
+   Gen    : Generator;
+
+   Reference : Duration := 0.0;
+
+   function Near (Index : Positive) return Positive;
+   --  An item close to Items (Index), so that links remain short, as in
+   --  typical diagrams.
+
+   function Same_Layout return Boolean;
+   --  Whether the links have the same layout as in the serial case
+
+   procedure Measure (Tasks : Positive);
+   --  Compute the layout of all links with the given number of tasks, and
+   --  print the speedup compared to a single task.
+
+   ----------
+   -- Near --
+   ----------
+
+   function Near (Index : Positive) return Positive is
+      Col : constant Integer := (Index - 1) mod Columns
+        + Integer (Random (Gen) * 6.0) - 3;
+      Row : constant Integer := (Index - 1) / Columns
+        + Integer (Random (Gen) * 6.0) - 3;
+   begin
+      return Integer'Max (0, Integer'Min (Rows - 1, Row)) * Columns
+        + Integer'Max (0, Integer'Min (Columns - 1, Col)) + 1;
+   end Near;
+
+   -----------------
+   -- Same_Layout --
+   -----------------
+
+   function Same_Layout return Boolean is
+   begin
+      for J in Links'Range loop
+         if Links (J).Get_Points.all /= Serial (J).all then
+            return False;
+         end if;
+      end loop;
+      return True;
+   end Same_Layout;
+
+   -------------
+   -- Measure --
+   -------------
+
+   procedure Measure (Tasks : Positive) is
+      Start   : Time;
+      Elapsed : Duration;
+   begin
+      Set_Layout_Tasks (Model, Tasks);
+      Start := Clock;
+      Model.Refresh_Layout (Send_Signal => False);
+      Elapsed := Clock - Start;
+
+      if Tasks = 1 then
+         Reference := Elapsed;
+         for J in Links'Range loop
+            Serial (J) := new Item_Point_Array'(Links (J).Get_Points.all);
+         end loop;
+      end if;
+
+      Put_Line
+        ("Layout of" & Integer'Image (Link_Count) & " links,"
+         & Tasks'Img & " task(s):" & Duration'Image (Elapsed) & "s"
+         & " speedup=" & Integer'Image (Integer (100.0 * Reference / Elapsed))
+         & "%" & (if Same_Layout then "" else " (LAYOUT DIFFERS)"));
+   end Measure;
+
+   Routing : Route_Style;
+   Tasks   : Positive := 1;
+
+begin
+   Reset (Gen, 1);
+   Gtk_New (Model);
+
+   for J in Items'Range loop
+      Items (J) := Gtk_New_Rect (Style, Width => 60.0, Height => 30.0);
+      Items (J).Set_Position
+        ((120.0 * Gdouble ((J - 1) mod Columns),
+          80.0 * Gdouble ((J - 1) / Columns)));
+      Model.Add (Items (J));
+   end loop;
+
+   for J in Links'Range loop
+      case J mod 4 is
+         when 0      => Routing := Straight;
+         when 1      => Routing := Curve;
+         when others => Routing := Orthogonal;
+      end case;
+
+      Links (J) := Gtk_New
+        (From    => Items ((J - 1) mod Items'Length + 1),
+         To      => Items (Near ((J - 1) mod Items'Length + 1)),
+         Style   => Style,
+         Routing => Routing);
+      Model.Add (Links (J));
+   end loop;
+
+   --  The speedup is limited by the number of processors, and by the part of
+   --  the layout that remains serial (items and labels).
+
+   Put_Line ("Processors:" & Number_Of_CPUs'Img);
+   loop
+      Measure (Tasks);
+      exit when Tasks >= Positive (Number_Of_CPUs);
+      Tasks := Positive'Min (Tasks * 2, Positive (Number_Of_CPUs));
+   end loop;
+end Test_Link_Layout;
@@ -0,0 +1,207 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the minimap: a view displays a large model, and is
+--  scrolled while a minimap monitors it. It measures the time needed to
+--  draw the minimap the first time, when the whole model is rendered, and
+--  then after each scroll of the monitored view.
+--  It also checks that items moved with the keyboard in the monitored view,
+--  which does not emit layout_changed, are drawn at their new position in
+--  the minimap.
+
+with Ada.Calendar;             use Ada.Calendar;
+with Ada.Command_Line;         use Ada.Command_Line;
+with Ada.Text_IO;              use Ada.Text_IO;
+with Cairo;                    use Cairo;
+with Cairo.Image_Surface;      use Cairo.Image_Surface;
+with Cairo.Surface;
+with Gdk.RGBA;                 use Gdk.RGBA;
+with Gdk.Types.Keysyms;        use Gdk.Types.Keysyms;
+with Glib;                     use Glib;
+with Gtk.Box;                  use Gtk.Box;
+with Gtk.Main;
+with Gtk.Offscreen_Window;     use Gtk.Offscreen_Window;
+with Gtkada.Canvas_View;       use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Views; use Gtkada.Canvas_View.Views;
+with Gtkada.Style;             use Gtkada.Style;
+
+procedure Test_Minimap is
+   Columns : constant := 100;
+   Rows    : constant := 200;
+   Frames  : constant := 50;
+
+   Win     : Gtk_Offscreen_Window;
+   Box     : Gtk_Hbox;
+   View    : Canvas_View;
+   Minimap : Minimap_View;
+   Model   : List_Canvas_Model;
+   Style   : constant Drawing_Style := Gtk_New (Stroke => Black_RGBA);
+   Item    : Rect_Item;
+   Surface : Cairo_Surface;
+   Cr      : Cairo_Context;
+   Start   : Time;
+   First   : Duration;
+   Dummy   : Boolean;
+   Details : aliased Canvas_Event_Details := Null_Canvas_Event_Details;
+   Moved, Expected : Cairo_Surface;
+
+   function Key_Scrolls is new On_Item_Event_Key_Scrolls_Generic
+     (Modifier => 0);
+
+   procedure Process_Events;
+   --  Let gtk+ process all pending events
+
+   function Draw_Minimap return Cairo_Surface;
+   --  Draw the minimap into a new surface
+
+   function Same_Image (S1, S2 : Cairo_Surface) return Boolean;
+   --  Whether the two surfaces, of the same size, have the same pixels
+
+   --------------------
+   -- Process_Events --
+   --------------------
+
+   procedure Process_Events is
+   begin
+      while Gtk.Main.Events_Pending loop
+         Dummy := Gtk.Main.Main_Iteration;
+      end loop;
+   end Process_Events;
+
+   ------------------
+   -- Draw_Minimap --
+   ------------------
+
+   function Draw_Minimap return Cairo_Surface is
+      S  : constant Cairo_Surface := Create (Cairo_Format_ARGB32, 200, 200);
+      Cr : constant Cairo_Context := Create (S);
+   begin
+      Minimap.Draw (Cr);
+      Destroy (Cr);
+      Cairo.Surface.Flush (S);
+      return S;
+   end Draw_Minimap;
+
+   ----------------
+   -- Same_Image --
+   ----------------
+
+   function Same_Image (S1, S2 : Cairo_Surface) return Boolean is
+      Size : constant Natural := Natural (Get_Stride (S1) * Get_Height (S1));
+      D1   : Byte_Array (1 .. Size);
+      for D1'Address use Get_Data_Generic (S1);
+      pragma Import (Ada, D1);
+      D2   : Byte_Array (1 .. Size);
+      for D2'Address use Get_Data_Generic (S2);
+      pragma Import (Ada, D2);
+   begin
+      return D1 = D2;
+   end Same_Image;
+
+begin
+   Gtk.Main.Init;
+   Gtk_New (Model);
+
+   for X in 0 .. Columns - 1 loop
+      for Y in 0 .. Rows - 1 loop
+         Item := Gtk_New_Rect (Style, 20.0, 10.0);
+         Item.Set_Position ((30.0 * Gdouble (X), 15.0 * Gdouble (Y)));
+         Model.Add (Item);
+      end loop;
+   end loop;
+   Model.Refresh_Layout;
+
+   Gtk_New (View, Model);
+   Model.Unref;
+   View.Set_Size_Request (800, 600);
+
+   Gtk_New (Minimap);
+   Minimap.Set_Size_Request (200, 200);
+   Minimap.Monitor (View);
+
+   Gtk_New (Win);
+   Gtk_New_Hbox (Box);
+   Win.Add (Box);
+   Box.Pack_Start (View);
+   Box.Pack_Start (Minimap, Expand => False);
+   Win.Show_All;
+   Process_Events;
+
+   Surface := Create (Cairo_Format_ARGB32, 200, 200);
+   Cr := Create (Surface);
+
+   --  The minimap was already drawn while processing the events. Report a
+   --  change in the layout, so that its thumbnail is discarded and the
+   --  first frame renders the whole model again.
+
+   Model.Layout_Changed;
+
+   Start := Clock;
+   Minimap.Draw (Cr);
+   First := Clock - Start;
+
+   Start := Clock;
+   for F in 1 .. Frames loop
+      View.Set_Topleft ((10.0 * Gdouble (F), 10.0 * Gdouble (F)));
+      View.Viewport_Changed;
+      Process_Events;
+      Minimap.Draw (Cr);
+   end loop;
+   Cairo.Surface.Flush (Surface);
+
+   Put_Line
+     (Integer'Image (Columns * Rows) & " items: first frame"
+      & Duration'Image (First * 1000) & "ms, then"
+      & Duration'Image ((Clock - Start) / Frames * 1000) & "ms per scroll");
+
+   --  Move the last item with the keyboard, far enough that the change is
+   --  visible in the minimap. Its thumbnail must then match a rendering
+   --  from scratch.
+
+   View.Set_Snap (Snap_To_Grid => False);
+   Details.Event_Type    := Key_Press;
+   Details.Key           := GDK_Right;
+   Details.Item          := Abstract_Item (Item);
+   Details.Toplevel_Item := Abstract_Item (Item);
+
+   for K in 1 .. 40 loop
+      Dummy := Key_Scrolls (View, Details'Unchecked_Access);
+   end loop;
+   Process_Events;
+
+   Moved := Draw_Minimap;
+   Model.Layout_Changed;
+   Expected := Draw_Minimap;
+
+   if not Same_Image (Moved, Expected) then
+      Put_Line ("FAIL: moved item not redrawn in the minimap");
+      Set_Exit_Status (Failure);
+   end if;
+
+   Cairo.Surface.Destroy (Moved);
+   Cairo.Surface.Destroy (Expected);
+
+   Destroy (Cr);
+   Cairo.Surface.Destroy (Surface);
+   Win.Destroy;
+end Test_Minimap;
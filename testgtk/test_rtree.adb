@@ -21,16 +21,437 @@
 --                                                                          --
 ------------------------------------------------------------------------------
 
+with Ada.Calendar;              use Ada.Calendar;
+with Ada.Numerics.Float_Random; use Ada.Numerics.Float_Random;
 with Ada.Text_IO;               use Ada.Text_IO;
+with Glib;                      use Glib;
+with Gtk.Main;
 with Gtkada.Canvas_View;        use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Models; use Gtkada.Canvas_View.Models;
 with Gtkada.Canvas_View.Rtrees; use Gtkada.Canvas_View.Rtrees;
 with Gtkada.Style;              use Gtkada.Style;
 
 procedure Test_Rtree is
+   package List_Rtrees is new Rtree_Models (List_Canvas_Model_Record);
+
    R     : Rtree (Min_Children => 2, Max_Children => 2);
    Item  : Rect_Item;
    Style : constant Drawing_Style := Gtk_New;
    Context : Draw_Context;
+
+   type Item_Array is array (Positive range <>) of Rect_Item;
+   type Model_Rectangle_Array is array (Positive range <>) of Model_Rectangle;
+
+   procedure Benchmark_Drag (Count : Positive);
+   --  Compare the cost of moving one item in a tree of Count items, either
+   --  by rebuilding the whole tree or by updating it incrementally.
+
+   procedure Benchmark_Model_Drag (Count : Positive);
+   --  Same as Benchmark_Drag, but going through a Rtree_Model as the views
+   --  do, compared with a full Refresh_Layout after each move.
+
+   procedure Check_Shrink;
+   --  Check that the bounding boxes of the tree shrink when the outermost
+   --  item moves inwards, or is deleted.
+
+   procedure Check_Bulk_Load;
+   --  Check that Bulk_Load never creates underfull nodes, whatever the
+   --  number of items.
+
+   procedure Benchmark_Load (Count : Positive);
+   --  Compare inserting Count items one by one with Bulk_Load, both for the
+   --  time it takes to build the tree and for the cost of queries.
+
+   procedure Benchmark_Policy (Count : Positive; Clustered : Boolean);
+   --  Compare the quality of the trees built by inserting Count items one by
+   --  one, with each of the split policies. Items are either spread
+   --  uniformly, or grouped in small clusters (as often happens after an
+   --  automatic layout).
+
+   --------------------
+   -- Benchmark_Drag --
+   --------------------
+
+   procedure Benchmark_Drag (Count : Positive) is
+      Moves    : constant := 1_000;
+      Per_Row  : constant := 200;
+      T        : Rtree (Default_Min_Children, Default_Max_Children);
+      Items    : Item_Array (1 .. Count);
+      Dragged  : Rect_Item;
+      Old, Box : Model_Rectangle;
+      Start    : Time;
+      Rebuild, Update : Duration;
+   begin
+      for J in Items'Range loop
+         Items (J) := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         Items (J).Set_Position
+           ((40.0 * Gdouble (J mod Per_Row), 40.0 * Gdouble (J / Per_Row)));
+         Items (J).Size_Request (Context);
+         T.Insert (Items (J));
+      end loop;
+
+      Dragged := Items (Count / 2);
+
+      --  Full rebuild after moving the item (previous behavior)
+
+      Start := Clock;
+      T.Clear;
+      for J in Items'Range loop
+         T.Insert (Items (J));
+      end loop;
+      Rebuild := Clock - Start;
+
+      --  Incremental update, as done for each step of a drag
+
+      Start := Clock;
+      for M in 1 .. Moves loop
+         Old := Dragged.Model_Bounding_Box;
+         Dragged.Set_Position
+           ((Dragged.Position.X + 3.0, Dragged.Position.Y + 1.0));
+         Box := Dragged.Model_Bounding_Box;
+         T.Update (Dragged, Old, Box);
+      end loop;
+      Update := (Clock - Start) / Moves;
+
+      Put_Line
+        ("Drag benchmark," & Count'Img & " items: rebuild="
+         & Duration'Image (Rebuild) & "s update="
+         & Duration'Image (Update) & "s");
+
+      T.Clear;
+   end Benchmark_Drag;
+
+   --------------------------
+   -- Benchmark_Model_Drag --
+   --------------------------
+
+   procedure Benchmark_Model_Drag (Count : Positive) is
+      Moves   : constant := 100;
+      Per_Row : constant := 200;
+      Model   : List_Rtrees.Rtree_Model;
+      It      : Rect_Item;
+      Dragged : Rect_Item;
+      Moved   : Item_Sets.Set;
+      Found   : Boolean := False;
+      Start   : Time;
+      Refresh, Update : Duration;
+
+      procedure Move;
+      --  Move the dragged item a little
+
+      procedure Check (Item : not null access Abstract_Item_Record'Class);
+      --  Whether Item is the dragged item
+
+      procedure Move is
+      begin
+         Dragged.Set_Position
+           ((Dragged.Position.X + 3.0, Dragged.Position.Y + 1.0));
+      end Move;
+
+      procedure Check (Item : not null access Abstract_Item_Record'Class) is
+      begin
+         Found := Found or else Abstract_Item (Item) = Abstract_Item (Dragged);
+      end Check;
+
+   begin
+      List_Rtrees.Gtk_New (Model);
+
+      for J in 1 .. Count loop
+         It := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         It.Set_Position
+           ((40.0 * Gdouble (J mod Per_Row), 40.0 * Gdouble (J / Per_Row)));
+         Model.Add (It);
+
+         if J = Count / 2 then
+            Dragged := It;
+         end if;
+      end loop;
+
+      Model.Refresh_Layout;
+      Moved.Include (Abstract_Item (Dragged));
+
+      --  Full refresh of the layout after each move
+
+      Start := Clock;
+      for M in 1 .. Moves loop
+         Move;
+         Model.Refresh_Layout;
+      end loop;
+      Refresh := (Clock - Start) / Moves;
+
+      --  As done by the views while items are dragged or animated
+
+      Start := Clock;
+      for M in 1 .. Moves loop
+         Move;
+         Model.Items_Moved (Moved);
+         Model.Layout_Changed;
+      end loop;
+      Update := (Clock - Start) / Moves;
+
+      Model.For_Each_Item
+        (Check'Access, In_Area => Dragged.Model_Bounding_Box);
+      if not Found then
+         Put_Line ("FAIL: dragged item not found at its new position");
+      end if;
+
+      Put_Line
+        ("Model drag benchmark," & Count'Img & " items: refresh="
+         & Duration'Image (Refresh) & "s items_moved="
+         & Duration'Image (Update) & "s");
+
+      Model.Unref;
+   end Benchmark_Model_Drag;
+
+   ------------------
+   -- Check_Shrink --
+   ------------------
+
+   procedure Check_Shrink is
+      T     : Rtree (Default_Min_Children, Default_Max_Children);
+      Items : Item_Array (1 .. 100);
+      Old   : Model_Rectangle;
+      Last  : Rect_Item renames Items (Items'Last);
+
+      procedure Expect (Name : String; Width : Gdouble);
+      --  Check the width of the bounding box of the tree
+
+      procedure Expect (Name : String; Width : Gdouble) is
+      begin
+         if T.Bounding_Box.Width /= Width then
+            Put_Line
+              ("FAIL: " & Name & ": width="
+               & Gdouble'Image (T.Bounding_Box.Width)
+               & " expected=" & Gdouble'Image (Width));
+         end if;
+      end Expect;
+
+   begin
+      for J in Items'Range loop
+         Items (J) := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         Items (J).Set_Position ((40.0 * Gdouble (J - 1), 0.0));
+         Items (J).Size_Request (Context);
+         T.Insert (Items (J));
+      end loop;
+
+      Expect ("initial", 40.0 * 99.0 + 20.0);
+
+      --  The outermost item moves a little inwards: its leaf stays in the
+      --  same node.
+
+      Old := Last.Model_Bounding_Box;
+      Last.Set_Position ((40.0 * 99.0 - 5.0, 0.0));
+      T.Update (Last, Old, Last.Model_Bounding_Box);
+      Expect ("small move", 40.0 * 99.0 + 15.0);
+
+      --  It now moves to the middle of the tree
+
+      Old := Last.Model_Bounding_Box;
+      Last.Set_Position ((100.0, 10.0));
+      T.Update (Last, Old, Last.Model_Bounding_Box);
+      Expect ("large move", 40.0 * 98.0 + 20.0);
+
+      T.Delete
+        (Items (Items'Last - 1), Items (Items'Last - 1).Model_Bounding_Box);
+      Expect ("delete", 40.0 * 97.0 + 20.0);
+
+      T.Clear;
+   end Check_Shrink;
+
+   ---------------------
+   -- Check_Bulk_Load --
+   ---------------------
+
+   procedure Check_Bulk_Load is
+      T     : Rtree (Default_Min_Children, Default_Max_Children);
+      Items : Items_Lists.List;
+      It    : Rect_Item;
+   begin
+      for Count in 1 .. 200 loop
+         It := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         It.Set_Position
+           ((40.0 * Gdouble (Count mod 13), 40.0 * Gdouble (Count / 13)));
+         It.Size_Request (Context);
+         Items.Append (Abstract_Item (It));
+
+         T.Bulk_Load (Items);
+         if T.Min_Node_Children < Default_Min_Children then
+            Put_Line
+              ("FAIL: bulk load" & Count'Img & " items: node with"
+               & Natural'Image (T.Min_Node_Children) & " children");
+         end if;
+      end loop;
+
+      T.Clear;
+   end Check_Bulk_Load;
+
+   --------------------
+   -- Benchmark_Load --
+   --------------------
+
+   procedure Benchmark_Load (Count : Positive) is
+      Queries : constant := 1_000;
+      Per_Row : constant := 200;
+      T       : Rtree (Default_Min_Children, Default_Max_Children);
+      Items   : Items_Lists.List;
+      It      : Rect_Item;
+      Start   : Time;
+
+      function Area (Q : Positive) return Model_Rectangle is
+        ((X      => 40.0 * Gdouble ((Q * 37) mod Per_Row),
+          Y      => 40.0 * Gdouble ((Q * 53) mod (Count / Per_Row + 1)),
+          Width  => 800.0,
+          Height => 600.0));
+      --  A window roughly the size of a screen, scattered across the whole
+      --  set of items.
+
+      procedure Measure (Name : String; Build : Duration);
+      --  Run a series of queries on T, and print the results
+
+      procedure Measure (Name : String; Build : Duration) is
+         Visited : Natural := 0;
+         Found   : Natural := 0;
+         Query   : Duration;
+      begin
+         Start := Clock;
+         for Q in 1 .. Queries loop
+            Found := Found + Natural (T.Find (Area (Q)).Length);
+         end loop;
+         Query := (Clock - Start) / Queries;
+
+         for Q in 1 .. Queries loop
+            Visited := Visited + T.Count_Visited_Nodes (Area (Q));
+         end loop;
+
+         Put_Line
+           ("Load benchmark," & Count'Img & " items, " & Name
+            & ": build=" & Duration'Image (Build)
+            & "s query=" & Duration'Image (Query)
+            & "s visited/query=" & Natural'Image (Visited / Queries)
+            & " found/query=" & Natural'Image (Found / Queries));
+      end Measure;
+
+   begin
+      for J in 1 .. Count loop
+         It := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         It.Set_Position
+           ((40.0 * Gdouble (J mod Per_Row), 40.0 * Gdouble (J / Per_Row)));
+         It.Size_Request (Context);
+         Items.Append (Abstract_Item (It));
+      end loop;
+
+      Start := Clock;
+      for Elem of Items loop
+         T.Insert (Elem);
+      end loop;
+      Measure ("insert", Clock - Start);
+
+      Start := Clock;
+      T.Bulk_Load (Items);
+      Measure ("bulk  ", Clock - Start);
+
+      T.Clear;
+   end Benchmark_Load;
+
+   ----------------------
+   -- Benchmark_Policy --
+   ----------------------
+
+   procedure Benchmark_Policy (Count : Positive; Clustered : Boolean) is
+      Queries  : constant := 1_000;
+      Clusters : constant := 50;
+      Size     : constant := 8_000.0;  --  dimension of the whole area
+      Spread   : constant := 300.0;    --  dimension of a cluster
+      Gen      : Generator;
+      Items    : Item_Array (1 .. Count);
+      Queried  : Model_Rectangle_Array (1 .. Queries);
+      Centers  : array (1 .. Clusters) of Model_Point;
+      Start    : Time;
+      Build, Query : Duration;
+      Visited, Found : Natural;
+
+      procedure Count_Item
+        (Item : not null access Abstract_Item_Record'Class);
+      procedure Count_Item
+        (Item : not null access Abstract_Item_Record'Class)
+      is
+         pragma Unreferenced (Item);
+      begin
+         Found := Found + 1;
+      end Count_Item;
+
+      function Coord (Max : Gdouble) return Gdouble
+        is (Gdouble (Random (Gen)) * Max);
+
+   begin
+      Reset (Gen, 1);
+
+      for C in Centers'Range loop
+         Centers (C) := (Coord (Size), Coord (Size));
+      end loop;
+
+      for J in Items'Range loop
+         Items (J) := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         if Clustered then
+            Items (J).Set_Position
+              ((Centers (J mod Clusters + 1).X + Coord (Spread),
+                Centers (J mod Clusters + 1).Y + Coord (Spread)));
+         else
+            Items (J).Set_Position ((Coord (Size), Coord (Size)));
+         end if;
+         Items (J).Size_Request (Context);
+      end loop;
+
+      --  Query around the items, so that the results are not empty
+
+      for Q in Queried'Range loop
+         Queried (Q) :=
+           (X      => Items (Q mod Count + 1).Position.X - 100.0,
+            Y      => Items (Q mod Count + 1).Position.Y - 100.0,
+            Width  => 400.0,
+            Height => 300.0);
+      end loop;
+
+      for Policy in Split_Policy loop
+         declare
+            T : Rtree (Default_Min_Children, Default_Max_Children);
+         begin
+            T.Set_Split_Policy (Policy);
+
+            Start := Clock;
+            for J in Items'Range loop
+               T.Insert (Items (J));
+            end loop;
+            Build := Clock - Start;
+
+            --  Same as Rtree_Model.For_Each_Item with an area
+
+            Found := 0;
+            Start := Clock;
+            for Q in Queried'Range loop
+               T.For_Each_Object (Count_Item'Access, In_Area => Queried (Q));
+            end loop;
+            Query := (Clock - Start) / Queries;
+
+            Visited := 0;
+            for Q in Queried'Range loop
+               Visited := Visited + T.Count_Visited_Nodes (Queried (Q));
+            end loop;
+
+            Put_Line
+              ("Policy benchmark," & Count'Img & " items, "
+               & (if Clustered then "clustered" else "uniform  ")
+               & ", " & Policy'Img
+               & ": build=" & Duration'Image (Build)
+               & "s query=" & Duration'Image (Query)
+               & "s visited/query=" & Natural'Image (Visited / Queries)
+               & " found/query=" & Natural'Image (Found / Queries));
+
+            T.Clear;
+         end;
+      end loop;
+   end Benchmark_Policy;
+
 begin
    Put_Line ("Empty Rtree");
    Dump_Debug (R);
@@ -56,7 +477,55 @@ begin
    R.Insert (Item);
    Dump_Debug (R);
 
+   Put_Line ("Delete third child");
+   R.Delete (Item, Item.Model_Bounding_Box);
+   Dump_Debug (R);
+
+   Put_Line ("Move third child back into the tree");
+   declare
+      Old : constant Model_Rectangle := Item.Model_Bounding_Box;
+   begin
+      Item.Set_Position ((100.0, 100.0));
+      R.Update (Item, Old, Item.Model_Bounding_Box);
+   end;
+   Dump_Debug (R);
+
    R.Clear;
    Dump_Debug (R);
 
+   Put_Line ("Bulk load three children");
+   declare
+      Items : Items_Lists.List;
+   begin
+      for J in 1 .. 3 loop
+         Item := Gtk_New_Rect (Style, Width => 20.0, Height => 20.0);
+         Item.Set_Position ((10.0 * Gdouble (J), 10.0));
+         Item.Size_Request (Context);
+         Items.Append (Abstract_Item (Item));
+      end loop;
+      R.Bulk_Load (Items);
+   end;
+   Dump_Debug (R);
+
+   R.Clear;
+
+   --  The time to update the tree for a drag should not depend on the number
+   --  of items.
+
+   Benchmark_Drag (1_000);
+   Benchmark_Drag (10_000);
+   Benchmark_Drag (50_000);
+
+   Gtk.Main.Init;
+   Check_Shrink;
+   Check_Bulk_Load;
+   Benchmark_Model_Drag (1_000);
+   Benchmark_Model_Drag (10_000);
+
+   Benchmark_Load (10_000);
+   Benchmark_Load (100_000);
+
+   Benchmark_Policy (50_000, Clustered => False);
+   Benchmark_Policy (50_000, Clustered => True);
+
 end Test_Rtree;
@@ -0,0 +1,132 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the smart guides: a zoomed out view displays thousands of
+--  items, and we measure the time needed to compute the guides when a drag
+--  starts, and then to snap the dragged item on each motion event.
+
+with Ada.Calendar;             use Ada.Calendar;
+with Ada.Command_Line;         use Ada.Command_Line;
+with Ada.Text_IO;              use Ada.Text_IO;
+with Gdk.RGBA;                 use Gdk.RGBA;
+with Glib;                     use Glib;
+with Gtk.Main;
+with Gtk.Offscreen_Window;     use Gtk.Offscreen_Window;
+with Gtkada.Canvas_View;       use Gtkada.Canvas_View;
+with Gtkada.Canvas_View.Views; use Gtkada.Canvas_View.Views;
+with Gtkada.Style;             use Gtkada.Style;
+
+procedure Test_Smart_Guides is
+   Columns : constant := 100;
+   Rows    : constant := 100;
+   Motions : constant := 100_000;
+
+   Win     : Gtk_Offscreen_Window;
+   View    : Canvas_View;
+   Model   : List_Canvas_Model;
+   Style   : constant Drawing_Style := Gtk_New (Stroke => Black_RGBA);
+   Item    : Rect_Item;
+   Start   : Time;
+   Pos     : Model_Coordinate;
+   Dummy   : Boolean;
+   Errors  : Natural := 0;
+
+   procedure Process_Events;
+   --  Process all pending events
+
+   --------------------
+   -- Process_Events --
+   --------------------
+
+   procedure Process_Events is
+   begin
+      while Gtk.Main.Events_Pending loop
+         Dummy := Gtk.Main.Main_Iteration;
+      end loop;
+   end Process_Events;
+
+begin
+   Gtk.Main.Init;
+   Gtk_New (Model);
+
+   --  Items are 20x10 and on a grid of 37 pixels, so that their edges and
+   --  centers all create distinct guides.
+
+   for X in 0 .. Columns - 1 loop
+      for Y in 0 .. Rows - 1 loop
+         Item := Gtk_New_Rect (Style, 20.0, 10.0);
+         Item.Set_Position ((37.0 * Gdouble (X), 37.0 * Gdouble (Y)));
+         Model.Add (Item);
+      end loop;
+   end loop;
+   Model.Refresh_Layout;
+
+   Gtk_New (View, Model);
+   Model.Unref;
+   View.Set_Snap (Snap_To_Grid => False, Snap_To_Guides => True);
+
+   Gtk_New (Win);
+   View.Set_Size_Request (800, 600);
+   Win.Add (View);
+   Win.Show_All;
+   Process_Events;
+
+   --  Zoom out so that all the items are visible, and thus all contribute
+   --  guides.
+
+   View.Scale_To_Fit (Min_Scale => 0.01);
+   Process_Events;
+
+   Start := Clock;
+   Prepare_Smart_Guides (View);
+   Put_Line
+     ("Guides for" & Integer'Image (Columns * Rows) & " items:"
+      & Duration'Image ((Clock - Start) * 1000) & "ms");
+
+   Start := Clock;
+   for M in 1 .. Motions loop
+      --  An item of width 20 whose left edge is 2 pixels right of a
+      --  column of items snaps to it.
+
+      Pos := Snap_To_Smart_Guides
+        (View,
+         Pos        => 37.0 * Gdouble (M mod Columns) + 2.0,
+         Size       => 20.0,
+         Horizontal => False);
+
+      if Pos /= 37.0 * Gdouble (M mod Columns) then
+         Errors := Errors + 1;
+      end if;
+   end loop;
+   Put_Line
+     (Integer'Image (Motions) & " snaps:"
+      & Duration'Image ((Clock - Start) * 1000) & "ms");
+
+   if Errors /= 0 then
+      Put_Line ("FAIL:" & Natural'Image (Errors) & " wrong snaps");
+      Set_Exit_Status (Failure);
+   end if;
+
+   Free_Smart_Guides (View);
+   Win.Destroy;
+end Test_Smart_Guides;
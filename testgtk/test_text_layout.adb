@@ -0,0 +1,151 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the cache of text layouts: this is the animation demo
+--  scaled up to thousands of labels. It measures the time needed to render
+--  frames while the view scrolls, with and without the cache of layouts.
+
+with Ada.Calendar;           use Ada.Calendar;
+with Ada.Text_IO;            use Ada.Text_IO;
+with Cairo;                  use Cairo;
+with Cairo.Image_Surface;    use Cairo.Image_Surface;
+with Cairo.Surface;
+with Gdk.RGBA;               use Gdk.RGBA;
+with Glib;                   use Glib;
+with Gtk.Main;
+with Gtk.Offscreen_Window;   use Gtk.Offscreen_Window;
+with Gtkada.Canvas_View;     use Gtkada.Canvas_View;
+with Gtkada.Style;           use Gtkada.Style;
+
+procedure Test_Text_Layout is
+   Columns : constant := 50;
+   Rows    : constant := 80;
+   Frames  : constant := 20;
+   Width   : constant := 800;
+   Height  : constant := 600;
+
+   Win     : Gtk_Offscreen_Window;
+   View    : Canvas_View;
+   Model   : List_Canvas_Model;
+   Surface : Cairo_Surface;
+   Cr      : Cairo_Context;
+
+   procedure Process_Events;
+   --  Let gtk+ process all pending events
+
+   procedure Build_Model;
+   --  Create a grid of rectangles, each containing a label
+
+   function Frame_Time return Duration;
+   --  Average time needed to render a frame, while the view scrolls by one
+   --  pixel between frames
+
+   --------------------
+   -- Process_Events --
+   --------------------
+
+   procedure Process_Events is
+      Dummy : Boolean;
+   begin
+      while Gtk.Main.Events_Pending loop
+         Dummy := Gtk.Main.Main_Iteration;
+      end loop;
+   end Process_Events;
+
+   -----------------
+   -- Build_Model --
+   -----------------
+
+   procedure Build_Model is
+      Box_Style  : constant Drawing_Style := Gtk_New (Stroke => Black_RGBA);
+      Text_Style : constant Drawing_Style := Gtk_New (Stroke => Null_RGBA);
+      Item       : Rect_Item;
+   begin
+      Gtk_New (Model);
+
+      for X in 0 .. Columns - 1 loop
+         for Y in 0 .. Rows - 1 loop
+            Item := Gtk_New_Rect (Box_Style);
+            Item.Set_Position ((80.0 * Gdouble (X), 30.0 * Gdouble (Y)));
+            Item.Add_Child
+              (Gtk_New_Text
+                 (Text_Style, "Label" & Integer'Image (X * Rows + Y)));
+            Model.Add (Item);
+         end loop;
+      end loop;
+
+      Model.Refresh_Layout;
+   end Build_Model;
+
+   ----------------
+   -- Frame_Time --
+   ----------------
+
+   function Frame_Time return Duration is
+      Start : Time;
+   begin
+      Process_Events;
+      Start := Clock;
+      for F in 1 .. Frames loop
+         View.Set_Topleft ((Gdouble (F), Gdouble (F)));
+         View.Draw (Cr);
+      end loop;
+      Cairo.Surface.Flush (Surface);
+      return (Clock - Start) / Frames;
+   end Frame_Time;
+
+   Uncached, Cached : Duration;
+
+begin
+   Gtk.Main.Init;
+   Build_Model;
+
+   Gtk_New (View, Model);
+   Model.Unref;
+
+   Gtk_New (Win);
+   View.Set_Size_Request (Width, Height);
+   Win.Add (View);
+   Win.Show_All;
+   Process_Events;
+
+   Surface := Create (Cairo_Format_ARGB32, Width, Height);
+   Cr := Create (Surface);
+
+   View.Set_Scale (0.2);
+
+   View.Set_Text_Layout_Cache_Size (0);
+   Uncached := Frame_Time;
+
+   View.Set_Text_Layout_Cache_Size (Columns * Rows);
+   Cached := Frame_Time;
+
+   Put_Line
+     (Integer'Image (Columns * Rows) & " labels:"
+      & " uncached=" & Duration'Image (Uncached * 1000) & "ms"
+      & " cached=" & Duration'Image (Cached * 1000) & "ms");
+
+   Destroy (Cr);
+   Cairo.Surface.Destroy (Surface);
+   Win.Destroy;
+end Test_Text_Layout;
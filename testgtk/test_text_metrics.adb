@@ -0,0 +1,130 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the cache of text sizes: measures the time needed to
+--  refresh the layout of a model with a lot of text items, when the size of
+--  each text has to be computed by pango and when it is found in the cache.
+
+with Ada.Calendar;           use Ada.Calendar;
+with Ada.Text_IO;            use Ada.Text_IO;
+with Gdk.RGBA;               use Gdk.RGBA;
+with Glib;                   use Glib;
+with Gtk.Main;
+with Gtk.Offscreen_Window;   use Gtk.Offscreen_Window;
+with Gtkada.Canvas_View;     use Gtkada.Canvas_View;
+with Gtkada.Style;           use Gtkada.Style;
+
+procedure Test_Text_Metrics is
+   Columns : constant := 150;
+   Rows    : constant := 200;
+
+   Win     : Gtk_Offscreen_Window;
+   View    : Canvas_View;
+   Model   : List_Canvas_Model;
+
+   procedure Process_Events;
+   --  Let gtk+ process all pending events
+
+   procedure Build_Model;
+   --  Create a grid of text items. Only a few different texts are used, as
+   --  is common for the labels of a diagram.
+
+   procedure Measure (Name : String);
+   --  Refresh the layout of the whole model, and print the time it took and
+   --  the use of the cache
+
+   --------------------
+   -- Process_Events --
+   --------------------
+
+   procedure Process_Events is
+      Dummy : Boolean;
+   begin
+      while Gtk.Main.Events_Pending loop
+         Dummy := Gtk.Main.Main_Iteration;
+      end loop;
+   end Process_Events;
+
+   -----------------
+   -- Build_Model --
+   -----------------
+
+   procedure Build_Model is
+      Text_Style : constant Drawing_Style := Gtk_New (Stroke => Null_RGBA);
+      Text       : Text_Item;
+   begin
+      Gtk_New (Model);
+
+      for X in 0 .. Columns - 1 loop
+         for Y in 0 .. Rows - 1 loop
+            Text := Gtk_New_Text
+              (Text_Style, "Item" & Integer'Image ((X * Rows + Y) mod 1000));
+            Text.Set_Position ((100.0 * Gdouble (X), 30.0 * Gdouble (Y)));
+            Model.Add (Text);
+         end loop;
+      end loop;
+   end Build_Model;
+
+   -------------
+   -- Measure --
+   -------------
+
+   procedure Measure (Name : String) is
+      Start        : Time;
+      Hits, Misses : Natural;
+   begin
+      Get_Text_Metrics_Cache_Stats (Hits, Misses, Reset => True);
+
+      Start := Clock;
+      Model.Refresh_Layout;
+      Get_Text_Metrics_Cache_Stats (Hits, Misses);
+
+      Put_Line
+        (Name & ":" & Duration'Image ((Clock - Start) * 1000) & "ms,"
+         & Hits'Img & " hits," & Misses'Img & " misses");
+   end Measure;
+
+   Size : constant Natural := Get_Text_Metrics_Cache_Size;
+
+begin
+   Gtk.Main.Init;
+   Build_Model;
+
+   Gtk_New (View, Model);
+   Model.Unref;
+
+   Gtk_New (Win);
+   Win.Add (View);
+   Win.Show_All;
+   Process_Events;
+
+   Set_Text_Metrics_Cache_Size (0);
+   Measure ("no cache");
+
+   Set_Text_Metrics_Cache_Size (Size);
+   Clear_Text_Metrics_Cache;
+   Measure ("empty cache");
+   Measure ("full cache");
+
+   Win.Destroy;
+end Test_Text_Metrics;
@@ -0,0 +1,311 @@
+------------------------------------------------------------------------------
+--               GtkAda - Ada95 binding for the Gimp Toolkit                --
+--                                                                          --
+--                       Copyright (C) 2018, AdaCore                        --
+--                                                                          --
+-- This library is free software;  you can redistribute it and/or modify it --
+-- under terms of the  GNU General Public License  as published by the Free --
+-- Software  Foundation;  either version 3,  or (at your  option) any later --
+-- version. This library is distributed in the hope that it will be useful, --
+-- but WITHOUT ANY WARRANTY;  without even the implied warranty of MERCHAN- --
+-- TABILITY or FITNESS FOR A PARTICULAR PURPOSE.                            --
+--                                                                          --
+-- As a special exception under Section 7 of GPL version 3, you are granted --
+-- additional permissions described in the GCC Runtime Library Exception,   --
+-- version 3.1, as published by the Free Software Foundation.               --
+--                                                                          --
+-- You should have received a copy of the GNU General Public License and    --
+-- a copy of the GCC Runtime Library Exception along with this program;     --
+-- see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see    --
+-- <http://www.gnu.org/licenses/>.                                          --
+--                                                                          --
+------------------------------------------------------------------------------
+
+--  Benchmark for the XML parser: a document of about 100Mb is generated,
+--  and then read with the streaming parser, by building the whole tree, and
+--  as a document mapped in memory.
+
+with Ada.Calendar;          use Ada.Calendar;
+with Ada.Directories;
+with Ada.Streams.Stream_IO; use Ada.Streams.Stream_IO;
+with Ada.Text_IO;
+with Glib;                  use Glib;
+with Glib.Xml_Int;          use Glib.Xml_Int;
+
+procedure Test_XML_Stream is
+
+   File_Name : constant String := "test_xml_stream.xml";
+   Size      : constant := 100 * 1024 * 1024;
+
+   type Counter is new XML_Handler with record
+      Tags, Attributes, Text_Length : Natural := 0;
+   end record;
+   --  Counts the events reported by the parser
+
+   overriding procedure Start_Tag
+     (Self       : in out Counter;
+      Tag        : UTF8_String;
+      Attributes : UTF8_String);
+   overriding procedure Attribute
+     (Self  : in out Counter;
+      Key   : UTF8_String;
+      Value : UTF8_String);
+   overriding procedure Text (Self : in out Counter; Value : UTF8_String);
+
+   procedure Generate;
+   --  Create the document
+
+   function Count_Nodes (N : Node_Ptr) return Natural;
+   --  The number of nodes in the tree starting at N
+
+   function Count_Elements
+     (Doc : Documents.Document; E : Documents.Element) return Natural;
+   --  The number of elements in the document starting at E
+
+   ---------------
+   -- Start_Tag --
+   ---------------
+
+   overriding procedure Start_Tag
+     (Self       : in out Counter;
+      Tag        : UTF8_String;
+      Attributes : UTF8_String)
+   is
+      pragma Unreferenced (Tag, Attributes);
+   begin
+      Self.Tags := Self.Tags + 1;
+   end Start_Tag;
+
+   ---------------
+   -- Attribute --
+   ---------------
+
+   overriding procedure Attribute
+     (Self  : in out Counter;
+      Key   : UTF8_String;
+      Value : UTF8_String)
+   is
+      pragma Unreferenced (Key, Value);
+   begin
+      Self.Attributes := Self.Attributes + 1;
+   end Attribute;
+
+   ----------
+   -- Text --
+   ----------
+
+   overriding procedure Text (Self : in out Counter; Value : UTF8_String) is
+   begin
+      Self.Text_Length := Self.Text_Length + Value'Length;
+   end Text;
+
+   --------------
+   -- Generate --
+   --------------
+
+   procedure Generate is
+      F       : File_Type;
+      Written : Natural := 0;
+      Count   : Natural := 0;
+   begin
+      Create (F, Out_File, File_Name);
+      String'Write (Stream (F), "<?xml version=""1.0""?>" & ASCII.LF);
+      String'Write (Stream (F), "<desktop>" & ASCII.LF);
+
+      while Written < Size loop
+         Count := Count + 1;
+
+         declare
+            Img  : constant String := Natural'Image (Count);
+            Id   : constant String := Img (Img'First + 1 .. Img'Last);
+            Line : constant String :=
+              "  <child name=""item" & Id & """ id='" & Id & "'>"
+              & "<title>Title &amp; " & Id & "</title>"
+              & "<geometry x=""10"" y=""20"" />"
+              & "<!-- comment " & Id & " -->"
+              & "</child>" & ASCII.LF;
+         begin
+            String'Write (Stream (F), Line);
+            Written := Written + Line'Length;
+         end;
+      end loop;
+
+      String'Write (Stream (F), "</desktop>" & ASCII.LF);
+      Close (F);
+   end Generate;
+
+   -----------------
+   -- Count_Nodes --
+   -----------------
+
+   function Count_Nodes (N : Node_Ptr) return Natural is
+      Result : Natural := 1;
+      C      : Node_Ptr := N.Child;
+   begin
+      while C /= null loop
+         Result := Result + Count_Nodes (C);
+         C := C.Next;
+      end loop;
+      return Result;
+   end Count_Nodes;
+
+   --------------------
+   -- Count_Elements --
+   --------------------
+
+   function Count_Elements
+     (Doc : Documents.Document; E : Documents.Element) return Natural
+   is
+      use Documents;
+      Result : Natural := 1;
+      C      : Element := First_Child (Doc, E);
+   begin
+      while C /= No_Element loop
+         Result := Result + Count_Elements (Doc, C);
+         C := Next (Doc, C);
+      end loop;
+      return Result;
+   end Count_Elements;
+
+   Start   : Time;
+   Doc     : Documents.Document;
+   Events  : Counter;
+   Success : Boolean;
+   Tree    : Node_Ptr;
+
+begin
+   Generate;
+
+   Start := Clock;
+   Parse (Events, File_Name, Success);
+   Ada.Text_IO.Put_Line
+     ("streaming:" & Duration'Image (Clock - Start) & "s, success="
+      & Success'Img & "," & Events.Tags'Img & " tags,"
+      & Events.Attributes'Img & " attributes,"
+      & Events.Text_Length'Img & " bytes of text");
+
+   Start := Clock;
+   Tree := Parse (File_Name);
+   Ada.Text_IO.Put_Line
+     ("tree:" & Duration'Image (Clock - Start) & "s,"
+      & Natural'Image (if Tree = null then 0 else Count_Nodes (Tree))
+      & " nodes");
+
+   if Tree = null
+     or else Get_Attribute (Tree.Child, "name") /= "item1"
+     or else Get_Field (Tree.Child, "title").all /= "Title & 1"
+   then
+      Ada.Text_IO.Put_Line ("  unexpected contents for the first child");
+   end if;
+
+   if Tree /= null then
+      declare
+         C       : Node_Ptr;
+         Lookups : Natural := 0;
+      begin
+         Start := Clock;
+         for Pass in 1 .. 10 loop
+            C := Tree.Child;
+            while C /= null loop
+               if Get_Attribute (C, "id") /= "" then
+                  Lookups := Lookups + 1;
+               end if;
+               C := C.Next;
+            end loop;
+         end loop;
+         Ada.Text_IO.Put_Line
+           ("attributes:" & Duration'Image (Clock - Start) & "s,"
+            & Lookups'Img & " lookups");
+
+         Set_Attribute (Tree.Child, "id", "<new>");
+         if Get_Attribute (Tree.Child, "id") /= "<new>"
+           or else Get_Attribute (Tree.Child, "name") /= "item1"
+         then
+            Ada.Text_IO.Put_Line ("  unexpected attributes after update");
+         end if;
+      end;
+   end if;
+
+   if Tree /= null then
+      declare
+         use Indexes;
+         Index : Tag_Index;
+         Found : Natural := 0;
+      begin
+         --  Look for a tag that is not in the document, so that Find_Tag
+         --  needs to look at all the children
+
+         Start := Clock;
+         for J in 1 .. 100 loop
+            if Find_Tag (Tree.Child, "perspectives") /= null then
+               Found := Found + 1;
+            end if;
+         end loop;
+         Ada.Text_IO.Put_Line
+           ("find_tag:" & Duration'Image (Clock - Start) & "s");
+
+         Start := Clock;
+         for J in 1 .. 100 loop
+            if Find_Child (Index, Tree, "perspectives") /= null then
+               Found := Found + 1;
+            end if;
+         end loop;
+         Ada.Text_IO.Put_Line
+           ("index:" & Duration'Image (Clock - Start) & "s");
+
+         declare
+            Titles : constant Node_Array :=
+              Query (Index, Tree, "child[@name='item2']/title");
+         begin
+            if Found /= 0
+              or else Titles'Length /= 1
+              or else Titles (Titles'First).Value.all /= "Title & 2"
+              or else Query_First (Index, Tree, "child/geometry[@x=""10""]")
+                /= Find_Tag (Tree.Child.Child, "geometry")
+            then
+               Ada.Text_IO.Put_Line ("  unexpected result for queries");
+            end if;
+         end;
+
+         Clear (Index);
+      end;
+   end if;
+
+   Start := Clock;
+   Free (Tree);
+   Ada.Text_IO.Put_Line ("free:" & Duration'Image (Clock - Start) & "s");
+
+   for Map_File in reverse Boolean loop
+      Start := Clock;
+      Documents.Load (Doc, File_Name, Success, Map_File => Map_File);
+      Ada.Text_IO.Put_Line
+        ("document (mapped=" & Map_File'Img & "):"
+         & Duration'Image (Clock - Start) & "s, success=" & Success'Img & ","
+         & Natural'Image
+           (if Success
+            then Count_Elements (Doc, Documents.Root (Doc)) else 0)
+         & " elements");
+
+      if Success then
+         declare
+            use Documents;
+            Child : constant Element := First_Child (Doc, Root (Doc));
+         begin
+            if Get_Attribute (Doc, Child, "name") /= "item1"
+              or else Value
+                (Doc, Find_Tag (Doc, First_Child (Doc, Child), "title"))
+                /= "Title & 1"
+            then
+               Ada.Text_IO.Put_Line
+                 ("  unexpected contents for the first child");
+            end if;
+         end;
+      end if;
+
+      Start := Clock;
+      Documents.Free (Doc);
+      Ada.Text_IO.Put_Line ("free:" & Duration'Image (Clock - Start) & "s");
+   end loop;
+
+   Ada.Directories.Delete_File (File_Name);
+end Test_XML_Stream;